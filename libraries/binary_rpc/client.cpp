@@ -0,0 +1,208 @@
+#include <graphene/binary_rpc/client.hpp>
+
+#include <fc/log/logger.hpp>
+
+#include <websocketpp/client.hpp>
+#include <websocketpp/config/asio_no_tls_client.hpp>
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+namespace graphene {
+    namespace binary_rpc {
+
+        using websocket_client_type = websocketpp::client<websocketpp::config::asio_client>;
+
+        struct client::impl final {
+            websocket_client_type endpoint;
+            websocket_client_type::connection_ptr connection;
+            std::thread thread;
+            fc::microseconds timeout;
+
+            std::mutex mutex;
+            std::map<uint64_t, std::promise<response>> pending;
+            uint64_t next_id = 1;
+            bool is_closed = false;
+
+            std::promise<std::string> opened;
+            std::map<std::string, uint32_t> methods;
+
+            void on_message(websocket_client_type::message_ptr message) {
+                if (message->get_opcode() != websocketpp::frame::opcode::binary) {
+                    return;
+                }
+
+                response value;
+                try {
+                    const auto &payload = message->get_payload();
+                    value = fc::raw::unpack<response>(payload.data(), static_cast<uint32_t>(payload.size()));
+                } catch (const fc::exception &e) {
+                    wlog("Invalid response of binary RPC: ${e}", ("e", e.to_string()));
+                    return;
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                auto itr = pending.find(value.id);
+                if (itr != pending.end()) {
+                    itr->second.set_value(std::move(value));
+                    pending.erase(itr);
+                }
+            }
+
+            void on_close(const std::string &reason) {
+                std::lock_guard<std::mutex> lock(mutex);
+                is_closed = true;
+                for (auto &item: pending) {
+                    response value;
+                    value.id = item.first;
+                    value.code = connection_closed_code;
+                    value.message = reason;
+                    item.second.set_value(std::move(value));
+                }
+                pending.clear();
+            }
+
+            std::future<response> send(uint32_t method, std::vector<fc::variant> args) {
+                request value;
+                value.method = method;
+                value.args = std::move(args);
+
+                std::future<response> result;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    value.id = next_id++;
+                    auto &promise = pending[value.id];
+                    result = promise.get_future();
+                    if (is_closed) {
+                        on_closed_request(value.id);
+                        return result;
+                    }
+                }
+
+                auto data = fc::raw::pack(value);
+                auto ec = connection->send(data.data(), data.size(), websocketpp::frame::opcode::binary);
+                if (ec) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    on_closed_request(value.id);
+                }
+                return result;
+            }
+
+            /// called under the lock
+            void on_closed_request(uint64_t id) {
+                auto itr = pending.find(id);
+                if (itr == pending.end()) {
+                    return;
+                }
+                response value;
+                value.id = id;
+                value.code = connection_closed_code;
+                value.message = "Connection is closed";
+                itr->second.set_value(std::move(value));
+                pending.erase(itr);
+            }
+
+            void close() {
+                websocketpp::lib::error_code ec;
+                connection->close(websocketpp::close::status::going_away, "", ec);
+                if (ec) {
+                    endpoint.stop();
+                }
+                if (thread.joinable()) {
+                    thread.join();
+                }
+            }
+
+            response wait(std::future<response> &future) {
+                FC_ASSERT(future.wait_for(std::chrono::microseconds(timeout.count())) == std::future_status::ready,
+                          "Timeout of binary RPC call");
+                return future.get();
+            }
+        };
+
+        client::client(const std::string &url, fc::microseconds timeout)
+            : _impl(new impl()) {
+            auto &my = *_impl;
+            my.timeout = timeout;
+
+            my.endpoint.clear_access_channels(websocketpp::log::alevel::all);
+            my.endpoint.clear_error_channels(websocketpp::log::elevel::all);
+            my.endpoint.init_asio();
+
+            my.endpoint.set_open_handler([&my](websocketpp::connection_hdl) {
+                my.opened.set_value(std::string());
+            });
+            my.endpoint.set_fail_handler([&my](websocketpp::connection_hdl hdl) {
+                auto con = my.endpoint.get_con_from_hdl(hdl);
+                my.opened.set_value(con->get_ec().message());
+            });
+            my.endpoint.set_message_handler([&my](websocketpp::connection_hdl, websocket_client_type::message_ptr message) {
+                my.on_message(message);
+            });
+            my.endpoint.set_close_handler([&my](websocketpp::connection_hdl hdl) {
+                auto con = my.endpoint.get_con_from_hdl(hdl);
+                my.on_close("Connection is closed: " + con->get_remote_close_reason());
+            });
+
+            websocketpp::lib::error_code ec;
+            my.connection = my.endpoint.get_connection(url, ec);
+            FC_ASSERT(!ec, "Invalid url ${u}: ${e}", ("u", url)("e", ec.message()));
+            my.endpoint.connect(my.connection);
+            my.thread = std::thread([&my]() {
+                my.endpoint.run();
+            });
+
+            auto opened = my.opened.get_future();
+            if (opened.wait_for(std::chrono::microseconds(timeout.count())) != std::future_status::ready) {
+                my.endpoint.stop();
+                my.thread.join();
+                FC_THROW("Timeout of connection to ${u}", ("u", url));
+            }
+            auto error = opened.get();
+            if (!error.empty()) {
+                my.thread.join();
+                FC_THROW("Can't connect to ${u}: ${e}", ("u", url)("e", error));
+            }
+
+            try {
+                auto methods = my.send(get_methods_id, {});
+                my.methods = unpack<std::map<std::string, uint32_t>>(my.wait(methods));
+            } catch (...) {
+                my.close();
+                throw;
+            }
+        }
+
+        client::~client() {
+            _impl->close();
+        }
+
+        std::future<response> client::async_call(
+            const std::string &api, const std::string &method, std::vector<fc::variant> args
+        ) {
+            auto itr = _impl->methods.find(api + '.' + method);
+            FC_ASSERT(itr != _impl->methods.end(), "Method ${a}.${m} isn't served by binary RPC",
+                      ("a", api)("m", method));
+            return _impl->send(itr->second, std::move(args));
+        }
+
+        std::vector<char> client::call_packed(
+            const std::string &api, const std::string &method, std::vector<fc::variant> args
+        ) {
+            auto future = async_call(api, method, std::move(args));
+            auto value = _impl->wait(future);
+            check(value);
+            return std::move(value.result);
+        }
+
+        const std::map<std::string, uint32_t> &client::methods() const {
+            return _impl->methods;
+        }
+
+        void client::check(const response &value) {
+            FC_ASSERT(value.code == 0, "Binary RPC error ${c}: ${m}", ("c", value.code)("m", value.message));
+        }
+
+    }
+} // graphene::binary_rpc
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <graphene/binary_rpc/protocol.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/time.hpp>
+
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace graphene {
+    namespace binary_rpc {
+
+        /**
+         * Client of binary RPC of the node, it is used by tools which understand protocol types
+         * (indexers, cli_wallet) to fetch blocks and history without JSON.
+         *
+         * Example:
+         *   client node("ws://127.0.0.1:8091");
+         *   auto block = node.call<fc::optional<signed_block>>("database_api", "get_block", 25000000);
+         *
+         * Requests are pipelined: async_call() doesn't wait for the response, so many blocks can be requested
+         * at once. The client is thread-safe, the connection is served by its own thread.
+         */
+        class client final {
+        public:
+            /// connects to the websocket endpoint of the node and resolves ids of methods
+            explicit client(const std::string &url, fc::microseconds timeout = fc::seconds(30));
+
+            ~client();
+
+            client(const client &) = delete;
+
+            client &operator=(const client &) = delete;
+
+            std::future<response> async_call(const std::string &api, const std::string &method, std::vector<fc::variant> args);
+
+            /// the packed result, the error of the call is thrown
+            std::vector<char> call_packed(const std::string &api, const std::string &method, std::vector<fc::variant> args);
+
+            template<typename Result, typename... Args>
+            Result call(const std::string &api, const std::string &method, const Args &... args) {
+                auto packed = call_packed(api, method, std::vector<fc::variant>{fc::variant(args)...});
+                return fc::raw::unpack<Result>(packed);
+            }
+
+            /// the result of the response from async_call(), the error of the call is thrown
+            template<typename Result>
+            static Result unpack(const response &value) {
+                check(value);
+                return fc::raw::unpack<Result>(value.result);
+            }
+
+            /// api.method of methods which the node serves by binary RPC
+            const std::map<std::string, uint32_t> &methods() const;
+
+        private:
+            static void check(const response &);
+
+            struct impl;
+            std::unique_ptr<impl> _impl;
+        };
+
+    }
+} // graphene::binary_rpc
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <fc/io/raw.hpp>
+#include <fc/io/raw_variant.hpp>
+#include <fc/reflect/reflect.hpp>
+#include <fc/variant.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace graphene {
+    namespace binary_rpc {
+
+        /**
+         * Binary RPC is sent in binary websocket messages, each message is one fc::raw packed request or response.
+         *
+         * The method is called by its id, ids are assigned by the node on startup, so the client resolves
+         * them by the get_methods call after connecting. The args are the same as args of the JSON-RPC call,
+         * the result is the fc::raw packed return type of the method.
+         */
+
+        /// the reserved method, its result is std::map<std::string, uint32_t> of api.method to id
+        constexpr uint32_t get_methods_id = 0;
+
+        /// the code of the response which is generated by the client when the connection is closed
+        constexpr int32_t connection_closed_code = -1;
+
+        struct request {
+            /// the response has the same id, requests can be pipelined
+            uint64_t id = 0;
+            uint32_t method = get_methods_id;
+            std::vector<fc::variant> args;
+        };
+
+        struct response {
+            uint64_t id = 0;
+            /// 0 on success, otherwise the code of JSON-RPC error
+            int32_t code = 0;
+            std::string message;
+            /// the packed result of the method
+            std::vector<char> result;
+        };
+
+    }
+} // graphene::binary_rpc
+
+FC_REFLECT((graphene::binary_rpc::request), (id)(method)(args))
+FC_REFLECT((graphene::binary_rpc::response), (id)(code)(message)(result))
@@ -1,80 +1,326 @@
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <exception>
 #include <fstream>
+#include <mutex>
+#include <thread>
 #include <graphene/chain/block_log.hpp>
 #include <boost/iostreams/device/mapped_file.hpp>
 #include <boost/filesystem.hpp>
-#include <boost/thread/shared_mutex.hpp>
+
+#ifdef HAS_ZSTD
+#include <zstd.h>
+#include <zdict.h>
+#endif
 
 namespace graphene { namespace chain {
     namespace detail {
-        using read_write_mutex = boost::shared_mutex;
-        using read_lock = boost::shared_lock<read_write_mutex>;
-        using write_lock = boost::unique_lock<read_write_mutex>;
         static constexpr boost::iostreams::stream_offset min_valid_file_size = sizeof(uint64_t);
 
-        class block_log_impl {
+        static constexpr char header_magic[8] = {'V', 'I', 'Z', 'B', 'L', 'O', 'G', '2'};
+
+        // magic, version, compression, index step, dictionary size
+        static constexpr std::size_t header_size = sizeof(header_magic) + sizeof(uint32_t) * 4;
+
+        // packed size, raw size
+        static constexpr std::size_t record_header_size = sizeof(uint32_t) * 2;
+
+        class block_compressor {
         public:
-            optional<signed_block> head;
-            block_id_type head_id;
+            void init(block_log_compression value, int32_t level, const char* dictionary, std::size_t dictionary_size) {
+                reset();
+                compression = value;
+                compression_level = level;
 
-            std::string block_path;
-            std::string index_path;
-            boost::iostreams::mapped_file block_mapped_file;
-            boost::iostreams::mapped_file index_mapped_file;
-            read_write_mutex mutex;
+                switch (compression) {
+                    case block_log_compression::none:
+                        break;
 
-            bool has_block_records() const {
-                auto size = block_mapped_file.size();
-                return (size > min_valid_file_size);
+                    case block_log_compression::zstd:
+#ifdef HAS_ZSTD
+                        cctx.reset(ZSTD_createCCtx());
+                        if (dictionary_size) {
+                            cdict.reset(ZSTD_createCDict(dictionary, dictionary_size, compression_level));
+                            ddict.reset(ZSTD_createDDict(dictionary, dictionary_size));
+                            FC_ASSERT(cdict && ddict, "Can't load compression dictionary of block log.");
+                        }
+                        break;
+#else
+                        FC_THROW_EXCEPTION(fc::unsupported_exception,
+                            "Block log is compressed by zstd, but the node is built without zstd support.");
+#endif
+
+                    default:
+                        FC_THROW_EXCEPTION(fc::unsupported_exception,
+                            "Unknown compression ${c} of block log.", ("c", static_cast<uint32_t>(compression)));
+                }
             }
 
-            bool has_index_records() const {
-                auto size = index_mapped_file.size();
-                return (size >= min_valid_file_size);
+            void reset() {
+                compression = block_log_compression::none;
+#ifdef HAS_ZSTD
+                cdict.reset();
+                ddict.reset();
+                cctx.reset();
+#endif
+            }
+
+            bool is_compressed() const {
+                return compression != block_log_compression::none;
+            }
+
+            block_log_compression get_compression() const {
+                return compression;
             }
 
-            std::size_t get_mapped_size(const boost::iostreams::mapped_file& mapped_file) const {
-                auto size = mapped_file.size();
-                if (size < min_valid_file_size) {
-                    return 0;
+            // called only under the write lock
+            void compress(const std::vector<char>& src, std::vector<char>& dst) {
+#ifdef HAS_ZSTD
+                dst.resize(ZSTD_compressBound(src.size()));
+                std::size_t size;
+                if (cdict) {
+                    size = ZSTD_compress_usingCDict(
+                        cctx.get(), dst.data(), dst.size(), src.data(), src.size(), cdict.get());
+                } else {
+                    size = ZSTD_compressCCtx(
+                        cctx.get(), dst.data(), dst.size(), src.data(), src.size(), compression_level);
                 }
-                return size;
+                FC_ASSERT(!ZSTD_isError(size), "Can't compress block: ${e}", ("e", ZSTD_getErrorName(size)));
+                dst.resize(size);
+#else
+                FC_ASSERT(false, "The node is built without zstd support.");
+#endif
             }
 
-            uint64_t get_uint64(const boost::iostreams::mapped_file& mapped_file, std::size_t pos) const {
-                uint64_t value;
-                FC_ASSERT(get_mapped_size(mapped_file) >= pos + sizeof(value));
+            // called concurrently from reader threads
+            void decompress(const char* src, std::size_t src_size, std::size_t raw_size, std::vector<char>& dst) const {
+#ifdef HAS_ZSTD
+                struct dctx_holder {
+                    ZSTD_DCtx* ctx = ZSTD_createDCtx();
+                    ~dctx_holder() {
+                        ZSTD_freeDCtx(ctx);
+                    }
+                };
+                static thread_local dctx_holder dctx;
+
+                dst.resize(raw_size);
+                std::size_t size;
+                if (ddict) {
+                    size = ZSTD_decompress_usingDDict(dctx.ctx, dst.data(), dst.size(), src, src_size, ddict.get());
+                } else {
+                    size = ZSTD_decompressDCtx(dctx.ctx, dst.data(), dst.size(), src, src_size);
+                }
+                FC_ASSERT(!ZSTD_isError(size), "Can't decompress block: ${e}", ("e", ZSTD_getErrorName(size)));
+                FC_ASSERT(size == raw_size, "Wrong size of decompressed block.");
+#else
+                FC_ASSERT(false, "The node is built without zstd support.");
+#endif
+            }
 
-                auto* ptr = mapped_file.data() + pos;
-                value = *reinterpret_cast<uint64_t*>(ptr);
-                return value;
+            static std::vector<char> train_dictionary(
+                const std::vector<char>& samples, const std::vector<std::size_t>& sample_sizes, std::size_t size
+            ) {
+#ifdef HAS_ZSTD
+                std::vector<char> result(size);
+                auto dict_size = ZDICT_trainFromBuffer(
+                    result.data(), result.size(), samples.data(), sample_sizes.data(), sample_sizes.size());
+                FC_ASSERT(!ZDICT_isError(dict_size),
+                    "Can't train compression dictionary: ${e}", ("e", ZDICT_getErrorName(dict_size)));
+                result.resize(dict_size);
+                return result;
+#else
+                FC_ASSERT(false, "The node is built without zstd support.");
+                return {};
+#endif
             }
 
-            uint64_t get_last_uint64(const boost::iostreams::mapped_file& mapped_file) const {
-                uint64_t value;
-                auto size = get_mapped_size(mapped_file);
-                FC_ASSERT(size >= sizeof(value));
+        private:
+            block_log_compression compression = block_log_compression::none;
+            int32_t compression_level = 0;
+
+#ifdef HAS_ZSTD
+            struct zstd_deleter {
+                void operator()(ZSTD_CCtx* ptr) const { ZSTD_freeCCtx(ptr); }
+                void operator()(ZSTD_CDict* ptr) const { ZSTD_freeCDict(ptr); }
+                void operator()(ZSTD_DDict* ptr) const { ZSTD_freeDDict(ptr); }
+            };
+
+            std::unique_ptr<ZSTD_CCtx, zstd_deleter> cctx;
+            std::unique_ptr<ZSTD_CDict, zstd_deleter> cdict;
+            std::unique_ptr<ZSTD_DDict, zstd_deleter> ddict;
+#endif
+        };
 
-                auto* ptr = mapped_file.data() + size - sizeof(value);
-                value = *reinterpret_cast<uint64_t*>(ptr);
-                return value;
+        static std::size_t get_mapped_size(const boost::iostreams::mapped_file& mapped_file) {
+            auto size = mapped_file.size();
+            if (size < min_valid_file_size) {
+                return 0;
+            }
+            return size;
+        }
+
+        static uint64_t get_uint64(const boost::iostreams::mapped_file& mapped_file, std::size_t pos) {
+            uint64_t value;
+            FC_ASSERT(get_mapped_size(mapped_file) >= pos + sizeof(value));
+
+            auto* ptr = mapped_file.data() + pos;
+            value = *reinterpret_cast<uint64_t*>(ptr);
+            return value;
+        }
+
+        static uint32_t get_uint32(const boost::iostreams::mapped_file& mapped_file, std::size_t pos) {
+            uint32_t value;
+            FC_ASSERT(get_mapped_size(mapped_file) >= pos + sizeof(value));
+
+            auto* ptr = mapped_file.data() + pos;
+            value = *reinterpret_cast<uint32_t*>(ptr);
+            return value;
+        }
+
+        static uint64_t get_last_uint64(const boost::iostreams::mapped_file& mapped_file, uint64_t end) {
+            FC_ASSERT(end >= sizeof(uint64_t));
+            return get_uint64(mapped_file, end - sizeof(uint64_t));
+        }
+
+        static uint64_t get_index_size(uint32_t block_num, uint32_t step) {
+            if (block_num == 0) {
+                return 0;
+            }
+            return ((block_num - 1) / step + 1) * sizeof(uint64_t);
+        }
+
+        /**
+         * Epoch based reclamation of the published states of the block log.
+         *
+         * A reader registers itself in the current epoch before loading of the state pointer.
+         * The writer doesn't wait for readers: it advances the epoch only when readers of the previous epoch
+         * have left, so after two advances nobody can reference a state which was replaced before them.
+         * Counters of readers are striped by threads, so reader threads don't bounce one cache line between each other.
+         */
+        class epoch_manager {
+        public:
+            class guard {
+            public:
+                explicit guard(const epoch_manager& manager) {
+                    auto& s = manager.stripes[get_stripe_index()];
+                    for (;;) {
+                        const auto epoch = manager.epoch.load();
+                        counter = &s.readers[epoch & 1];
+                        counter->fetch_add(1);
+                        if (manager.epoch.load() == epoch) {
+                            break;
+                        }
+                        // the writer has advanced the epoch, it may not wait for this counter
+                        counter->fetch_sub(1);
+                    }
+                }
+
+                ~guard() {
+                    counter->fetch_sub(1, std::memory_order_release);
+                }
+
+                guard(const guard&) = delete;
+                guard& operator=(const guard&) = delete;
+
+            private:
+                std::atomic<uint64_t>* counter;
+            };
+
+            uint64_t current() const {
+                return epoch.load();
+            }
+
+            /// advances the epoch if readers of the previous one have left, returns the current epoch
+            uint64_t try_advance() {
+                // called only by the writer, so the epoch isn't changed concurrently
+                const auto current_epoch = epoch.load();
+                for (const auto& s: stripes) {
+                    if (s.readers[(current_epoch - 1) & 1].load() != 0) {
+                        return current_epoch;
+                    }
+                }
+                epoch.store(current_epoch + 1);
+                return current_epoch + 1;
+            }
+
+        private:
+            static constexpr std::size_t stripe_count = 64;
+
+            struct alignas(64) stripe {
+                std::atomic<uint64_t> readers[2] = {};
+            };
+
+            static std::size_t get_stripe_index() {
+                static std::atomic<std::size_t> next_index{0};
+                static thread_local std::size_t index = next_index.fetch_add(1, std::memory_order_relaxed) % stripe_count;
+                return index;
+            }
+
+            mutable std::array<stripe, stripe_count> stripes;
+            std::atomic<uint64_t> epoch{0};
+        };
+
+        /**
+         * Immutable state of the block log. Readers access it without locks under the epoch guard.
+         * The mappings are shared between states: a mapping is released with the last state which uses it.
+         */
+        struct block_log_state {
+            std::shared_ptr<boost::iostreams::mapped_file> block_mapped_file;
+            std::shared_ptr<boost::iostreams::mapped_file> index_mapped_file;
+
+            // ends of data, the files can be larger because of preallocated extents
+            uint64_t block_end = 0;
+            uint64_t index_end = 0;
+
+            uint32_t version = 1;
+            uint32_t index_step = 1;
+            uint64_t first_record_pos = 0;
+            const block_compressor* compressor = nullptr;
+
+            /// the head block is shared between states, so publishing of the state doesn't copy it
+            std::shared_ptr<const signed_block> head;
+            block_id_type head_id;
+
+            uint64_t next_record_pos(uint64_t pos) const {
+                if (version == 1) {
+                    signed_block tmp_block;
+                    return read_block(pos, tmp_block);
+                }
+
+                auto packed_size = get_uint32(*block_mapped_file, pos);
+                return pos + record_header_size + packed_size + sizeof(uint64_t);
             }
 
             uint64_t get_block_pos(uint32_t block_num) const {
-                if (head.valid() &&
+                if (head &&
                     block_num <= protocol::block_header::num_from_id(head_id) &&
                     block_num > 0
                 ) {
-                    return get_uint64(index_mapped_file, sizeof(uint64_t) * (block_num - 1));
+                    auto chunk = (block_num - 1) / index_step;
+                    auto pos = get_uint64(*index_mapped_file, sizeof(uint64_t) * chunk);
+                    for (auto num = chunk * index_step + 1; num < block_num; ++num) {
+                        pos = next_record_pos(pos);
+                    }
+                    return pos;
                 }
                 return block_log::npos;
             }
 
             uint64_t read_block(uint64_t pos, signed_block& block) const {
-                const auto file_size = get_mapped_size(block_mapped_file);
+                if (version == 1) {
+                    return read_block_v1(pos, block);
+                }
+                return read_block_v2(pos, block);
+            }
+
+            uint64_t read_block_v1(uint64_t pos, signed_block& block) const {
+                const auto file_size = block_end;
                 FC_ASSERT(file_size > pos);
 
-                const auto* ptr = block_mapped_file.data() + pos;
+                const auto* ptr = block_mapped_file->data() + pos;
                 const auto available_size = file_size - pos;
                 const auto max_block_size = std::min<std::size_t>(available_size, CHAIN_BLOCK_SIZE);
 
@@ -82,17 +328,168 @@ namespace graphene { namespace chain {
                 fc::raw::unpack(ds, block);
 
                 const auto end_pos = pos + ds.tellp();
-                FC_ASSERT(get_uint64(block_mapped_file, end_pos) == pos);
+                FC_ASSERT(get_uint64(*block_mapped_file, end_pos) == pos);
+
+                return end_pos + sizeof(uint64_t);
+            }
+
+            uint64_t read_block_v2(uint64_t pos, signed_block& block) const {
+                const auto file_size = block_end;
+                FC_ASSERT(file_size > pos + record_header_size && pos >= first_record_pos);
+
+                const auto packed_size = get_uint32(*block_mapped_file, pos);
+                const auto raw_size = get_uint32(*block_mapped_file, pos + sizeof(uint32_t));
+                const auto data_pos = pos + record_header_size;
+                const auto end_pos = data_pos + packed_size;
+
+                FC_ASSERT(raw_size <= CHAIN_BLOCK_SIZE && end_pos + sizeof(uint64_t) <= file_size);
+                FC_ASSERT(get_uint64(*block_mapped_file, end_pos) == pos);
+
+                const auto* ptr = block_mapped_file->data() + data_pos;
+                if (compressor->is_compressed()) {
+                    std::vector<char> raw_data;
+                    compressor->decompress(ptr, packed_size, raw_size, raw_data);
+                    fc::datastream<const char*> ds(raw_data.data(), raw_data.size());
+                    fc::raw::unpack(ds, block);
+                } else {
+                    fc::datastream<const char*> ds(ptr, packed_size);
+                    fc::raw::unpack(ds, block);
+                }
 
                 return end_pos + sizeof(uint64_t);
             }
 
             signed_block read_head() const {
-                auto pos = get_last_uint64(block_mapped_file);
+                auto pos = get_last_uint64(*block_mapped_file, block_end);
                 signed_block block;
                 read_block(pos, block);
                 return block;
             }
+        };
+
+        /**
+         * The writer part of the block log. All methods are called under the writer mutex,
+         * they change the private copy of the state and publish it for readers.
+         */
+        class block_log_impl {
+        public:
+            std::string block_path;
+            std::string index_path;
+            std::mutex mutex;
+
+            block_log_options options;
+            std::vector<char> new_dictionary;
+            block_compressor compressor;
+
+            block_log_state state;
+            std::atomic<const block_log_state*> published_state{nullptr};
+            epoch_manager epochs;
+            /// replaced states with epochs of their replacement, they are deleted when their readers have left
+            std::deque<std::pair<uint64_t, const block_log_state*>> retired_states;
+
+            ~block_log_impl() {
+                delete published_state.load();
+                wait_for_readers();
+            }
+
+            void publish() {
+                retire(published_state.exchange(new block_log_state(state)));
+            }
+
+            void unpublish() {
+                retire(published_state.exchange(nullptr));
+                wait_for_readers();
+            }
+
+            // the appender doesn't wait for slow readers, the replaced state is deleted on one of the next appends
+            void retire(const block_log_state* prev_state) {
+                if (prev_state) {
+                    retired_states.emplace_back(epochs.current(), prev_state);
+                }
+                reclaim();
+            }
+
+            void reclaim() {
+                const auto epoch = epochs.try_advance();
+                while (!retired_states.empty() && retired_states.front().first + 2 <= epoch) {
+                    delete retired_states.front().second;
+                    retired_states.pop_front();
+                }
+            }
+
+            // on closing all mappings are released
+            void wait_for_readers() {
+                for (reclaim(); !retired_states.empty(); reclaim()) {
+                    std::this_thread::yield();
+                }
+            }
+
+            bool has_block_records() const {
+                return (state.block_end > min_valid_file_size && state.block_end > state.first_record_pos);
+            }
+
+            bool has_index_records() const {
+                return (state.index_end >= min_valid_file_size);
+            }
+
+            void write_header(std::ostream& stream) const {
+                uint32_t values[4] = {
+                    options.version,
+                    static_cast<uint32_t>(options.compression),
+                    options.index_step,
+                    static_cast<uint32_t>(new_dictionary.size())};
+
+                stream.write(header_magic, sizeof(header_magic));
+                stream.write(reinterpret_cast<const char*>(values), sizeof(values));
+                stream.write(new_dictionary.data(), new_dictionary.size());
+            }
+
+            void read_header() {
+                const auto size = state.block_mapped_file->size();
+                const auto* ptr = state.block_mapped_file->data();
+
+                state.compressor = &compressor;
+
+                if (size < header_size || std::memcmp(ptr, header_magic, sizeof(header_magic)) != 0) {
+                    state.version = 1;
+                    state.index_step = 1;
+                    state.first_record_pos = 0;
+                    compressor.reset();
+                    return;
+                }
+
+                ptr += sizeof(header_magic);
+                uint32_t values[4];
+                std::memcpy(values, ptr, sizeof(values));
+
+                state.version = values[0];
+                auto compression = static_cast<block_log_compression>(values[1]);
+                state.index_step = values[2];
+                auto dictionary_size = values[3];
+
+                FC_ASSERT(state.version == 2, "Unknown version ${v} of block log.", ("v", state.version));
+                FC_ASSERT(state.index_step > 0, "Wrong index step of block log.");
+                FC_ASSERT(size >= header_size + dictionary_size, "Block log header is truncated.");
+
+                state.first_record_pos = header_size + dictionary_size;
+                compressor.init(
+                    compression, options.compression_level,
+                    state.block_mapped_file->data() + header_size, dictionary_size);
+            }
+
+            void create_nonexist_block_file() const {
+                if (!boost::filesystem::is_regular_file(block_path) ||
+                    boost::filesystem::file_size(block_path) < min_valid_file_size
+                ) {
+                    std::ofstream stream(block_path, std::ios::out|std::ios::binary|std::ios::trunc);
+                    if (options.version == 2) {
+                        write_header(stream);
+                    } else {
+                        stream << '\0';
+                    }
+                    stream.close();
+                }
+            }
 
             void create_nonexist_file(const std::string& path) const {
                 if (!boost::filesystem::is_regular_file(path) || boost::filesystem::file_size(path) == 0) {
@@ -102,38 +499,203 @@ namespace graphene { namespace chain {
                 }
             }
 
+            static std::shared_ptr<boost::iostreams::mapped_file> open_mapped_file(const std::string& path) {
+                auto mapped_file = std::make_shared<boost::iostreams::mapped_file>();
+                mapped_file->open(path, boost::iostreams::mapped_file::readwrite);
+                return mapped_file;
+            }
+
             void open_block_mapped_file() {
-                create_nonexist_file(block_path);
-                block_mapped_file.open(block_path, boost::iostreams::mapped_file::readwrite);
+                create_nonexist_block_file();
+                state.block_mapped_file = open_mapped_file(block_path);
+                read_header();
             }
 
             void open_index_mapped_file() {
                 create_nonexist_file(index_path);
-                index_mapped_file.open(index_path, boost::iostreams::mapped_file::readwrite);
+                state.index_mapped_file = open_mapped_file(index_path);
             }
 
+            bool is_index_valid() const { try {
+                const auto head_num = state.head->block_num();
+                if (state.index_end != get_index_size(head_num, state.index_step)) {
+                    return false;
+                }
+
+                auto pos = get_last_uint64(*state.index_mapped_file, state.index_end);
+                for (auto num = (head_num - 1) / state.index_step * state.index_step + 1; num < head_num; ++num) {
+                    pos = state.next_record_pos(pos);
+                }
+                return pos == get_last_uint64(*state.block_mapped_file, state.block_end);
+            } catch (const fc::exception&) {
+                return false;
+            } }
+
             void construct_index() {
                 ilog("Reconstructing Block Log Index...");
-                index_mapped_file.close();
+                state.index_mapped_file.reset();
                 boost::filesystem::remove_all(index_path);
                 open_index_mapped_file();
-                index_mapped_file.resize(head->block_num() * sizeof(uint64_t));
 
-                uint64_t pos = 0;
-                uint64_t end_pos = get_last_uint64(block_mapped_file);
-                auto* idx_ptr = index_mapped_file.data();
-                signed_block tmp_block;
+                const auto head_num = state.head->block_num();
+                state.index_end = get_index_size(head_num, state.index_step);
+                state.index_mapped_file->resize(state.index_end);
+
+                const auto start = fc::time_point::now();
+                if (!construct_index_backward()) {
+                    wlog("Back-pointers of block log are inconsistent, reading all blocks to construct index");
+                    construct_index_forward();
+                }
+                ilog("Block Log Index is reconstructed for ${n} blocks in ${t} ms",
+                     ("n", head_num)("t", (fc::time_point::now() - start).count() / 1000));
+            }
+
+            /**
+             * Each record ends with its own position, so positions of all blocks are found
+             * by jumping backwards from the end of data without unpacking of blocks.
+             */
+            bool construct_index_backward() { try {
+                auto* idx_ptr = reinterpret_cast<uint64_t*>(state.index_mapped_file->data());
+                uint64_t end = state.block_end;
+
+                for (uint32_t num = state.head->block_num(); num > 0; --num) {
+                    const auto pos = get_last_uint64(*state.block_mapped_file, end);
+                    if (pos < state.first_record_pos || pos + sizeof(uint64_t) >= end) {
+                        return false;
+                    }
+                    // the size of record is known in version 2, so the position can be checked for free
+                    if (state.version != 1 && state.next_record_pos(pos) != end) {
+                        return false;
+                    }
+                    if ((num - 1) % state.index_step == 0) {
+                        idx_ptr[(num - 1) / state.index_step] = pos;
+                    }
+                    end = pos;
+                }
+                return end == state.first_record_pos;
+            } catch (const fc::exception&) {
+                return false;
+            } }
+
+            void construct_index_forward() {
+                uint64_t pos = state.first_record_pos;
+                auto* idx_ptr = state.index_mapped_file->data();
+
+                for (uint32_t num = 1, head_num = state.head->block_num(); num <= head_num; ++num) {
+                    if ((num - 1) % state.index_step == 0) {
+                        *reinterpret_cast<uint64_t*>(idx_ptr) = pos;
+                        idx_ptr += sizeof(pos);
+                    }
+                    pos = state.next_record_pos(pos);
+                }
+            }
+
+            /**
+             * Grows the file by whole extents, so it is remapped only when the current extent is exhausted.
+             * Readers can use the current mapping, so the grown file is mapped again instead of remapping in place.
+             */
+            void reserve(
+                std::shared_ptr<boost::iostreams::mapped_file>& mapped_file, const std::string& path, uint64_t size
+            ) {
+                if (size <= mapped_file->size()) {
+                    return;
+                }
+                if (options.extent_size) {
+                    size = (size + options.extent_size - 1) / options.extent_size * options.extent_size;
+                }
+                boost::filesystem::resize_file(path, size);
+                mapped_file = open_mapped_file(path);
+            }
 
-                while (pos <= end_pos) {
-                    *reinterpret_cast<uint64_t*>(idx_ptr) = pos;
-                    pos = read_block(pos, tmp_block);
-                    idx_ptr += sizeof(pos);
+            // called only when the state isn't published
+            void truncate(boost::iostreams::mapped_file& mapped_file, uint64_t end) {
+                // mapping of an empty file isn't possible
+                const auto size = std::max<uint64_t>(end, 1);
+                if (mapped_file.is_open() && mapped_file.size() != size) {
+                    mapped_file.resize(size);
+                }
+            }
+
+            bool is_record_end(uint64_t end) const { try {
+                const auto pos = get_last_uint64(*state.block_mapped_file, end);
+                if (pos < state.first_record_pos || pos >= end) {
+                    return false;
+                }
+                signed_block block;
+                return state.read_block(pos, block) == end;
+            } catch (const fc::exception&) {
+                return false;
+            } }
+
+            /**
+             * Finds the end of the last complete record. After a clean shutdown the file is truncated
+             * and ends with a record. After a crash the file has a preallocated tail filled by zeros,
+             * in this case records are walked from the last position which was written to the index.
+             */
+            uint64_t find_block_end() {
+                const uint64_t file_size = get_mapped_size(*state.block_mapped_file);
+                if (file_size <= state.first_record_pos) {
+                    return state.first_record_pos;
+                }
+
+                state.block_end = file_size;
+                if (is_record_end(file_size)) {
+                    return file_size;
+                }
+
+                wlog("Block log has a preallocated tail, searching for the end of blocks...");
+
+                // the tail of the index is filled by zeros too, only the first entry can be zero in version 1
+                const uint64_t index_size = get_mapped_size(*state.index_mapped_file) / sizeof(uint64_t);
+                uint64_t low = 1;
+                uint64_t high = index_size;
+                while (low < high) {
+                    const auto middle = low + (high - low) / 2;
+                    if (get_uint64(*state.index_mapped_file, middle * sizeof(uint64_t)) != 0) {
+                        low = middle + 1;
+                    } else {
+                        high = middle;
+                    }
+                }
+
+                uint64_t chunk = 0;
+                uint64_t pos = state.first_record_pos;
+                if (low > 1) {
+                    const auto index_pos = get_uint64(*state.index_mapped_file, (low - 1) * sizeof(uint64_t));
+                    if (index_pos > state.first_record_pos && index_pos < file_size) {
+                        chunk = low - 1;
+                        pos = index_pos;
+                    }
+                }
+
+                auto end = walk_records(pos, chunk * state.index_step + 1);
+                if (end == pos && pos != state.first_record_pos) {
+                    // the index doesn't belong to the log
+                    end = walk_records(state.first_record_pos, 1);
+                }
+
+                ilog("End of blocks is found at ${p}, the file size is ${s}", ("p", end)("s", file_size));
+                return end;
+            }
+
+            uint64_t walk_records(uint64_t pos, uint32_t block_num) const {
+                signed_block block;
+                for (;; ++block_num) {
+                    try {
+                        const auto next_pos = state.read_block(pos, block);
+                        // zeros in version 1 can be unpacked as a block with the valid back-pointer
+                        if (block.block_num() != block_num || block.timestamp == fc::time_point_sec()) {
+                            return pos;
+                        }
+                        pos = next_pos;
+                    } catch (const fc::exception&) {
+                        return pos;
+                    }
                 }
             }
 
             void open(const fc::path& file) { try {
-                block_mapped_file.close();
-                index_mapped_file.close();
+                close();
 
                 block_path = file.string();
                 index_path = boost::filesystem::path(file.string() + ".index").string();
@@ -141,6 +703,10 @@ namespace graphene { namespace chain {
                 open_block_mapped_file();
                 open_index_mapped_file();
 
+                state.block_end = find_block_end();
+                truncate(*state.block_mapped_file, state.block_end);
+                state.index_end = get_mapped_size(*state.index_mapped_file);
+
                 /* On startup of the block log, there are several states the log file and the index file can be
                  * in relation to each other.
                  *
@@ -161,68 +727,112 @@ namespace graphene { namespace chain {
                  */
 
                 if (has_block_records()) {
-                    ilog("Log is nonempty");
-                    head = read_head();
-                    head_id = head->id();
+                    ilog("Log is nonempty, version ${v}", ("v", state.version));
+                    state.head = std::make_shared<const signed_block>(state.read_head());
+                    state.head_id = state.head->id();
+                    state.index_end = std::min(state.index_end, get_index_size(state.head->block_num(), state.index_step));
 
                     if (has_index_records()) {
                         ilog("Index is nonempty");
 
-                        auto block_pos = get_last_uint64(block_mapped_file);
-                        auto index_pos = get_last_uint64(index_mapped_file);
-
-                        if (block_pos != index_pos) {
-                            ilog("block_pos != index_pos, close and reopen index_stream");
+                        if (!is_index_valid()) {
+                            ilog("Index doesn't match log, close and reopen index_stream");
                             construct_index();
                         }
                     } else {
                         ilog("Index is empty");
                         construct_index();
                     }
+                    truncate(*state.index_mapped_file, state.index_end);
                 } else if (has_index_records()) {
                     ilog("Index is nonempty, remove and recreate it");
-                    index_mapped_file.close();
-                    block_mapped_file.close();
-
-                    boost::filesystem::remove_all(block_path);
+                    state.index_mapped_file.reset();
                     boost::filesystem::remove_all(index_path);
 
-                    open_block_mapped_file();
+                    if (state.version == 1) {
+                        // the header of version 2 describes the format of future blocks, so it is kept
+                        state.block_mapped_file.reset();
+                        boost::filesystem::remove_all(block_path);
+                        open_block_mapped_file();
+                        state.block_end = state.first_record_pos;
+                    }
+
                     open_index_mapped_file();
+                    state.index_end = 0;
                 }
+
+                publish();
             } FC_LOG_AND_RETHROW() }
 
             uint64_t append(const signed_block& b, const std::vector<char>& data) { try {
-                const auto index_pos = get_mapped_size(index_mapped_file);
+                FC_ASSERT(published_state.load(), "Block log is not open.");
+
+                const auto block_num = b.block_num();
+                const auto index_pos = state.index_end;
 
                 FC_ASSERT(
-                    index_pos == sizeof(uint64_t) * (b.block_num() - 1),
+                    index_pos == get_index_size(block_num - 1, state.index_step),
                     "Append to index file occuring at wrong position.",
                     ("position", index_pos)
-                    ("expected", (b.block_num() - 1) * sizeof(uint64_t)));
+                    ("expected", get_index_size(block_num - 1, state.index_step)));
 
-                uint64_t block_pos = get_mapped_size(block_mapped_file);
+                const uint64_t block_pos = state.block_end;
+                uint64_t record_end;
 
-                block_mapped_file.resize(block_pos + data.size() + sizeof(block_pos));
-                auto* ptr = block_mapped_file.data() + block_pos;
-                std::memcpy(ptr, data.data(), data.size());
-                ptr += data.size();
-                *reinterpret_cast<uint64_t*>(ptr) = block_pos;
+                // readers don't look beyond the end of data of the published state, so it is safe to write there
+                if (state.version == 1) {
+                    record_end = block_pos + data.size() + sizeof(block_pos);
+                    reserve(state.block_mapped_file, block_path, record_end);
+                    auto* ptr = state.block_mapped_file->data() + block_pos;
+                    std::memcpy(ptr, data.data(), data.size());
+                    ptr += data.size();
+                    *reinterpret_cast<uint64_t*>(ptr) = block_pos;
+                } else {
+                    const std::vector<char>* packed_data = &data;
+                    std::vector<char> compressed_data;
+                    if (compressor.is_compressed()) {
+                        compressor.compress(data, compressed_data);
+                        packed_data = &compressed_data;
+                    }
 
-                index_mapped_file.resize(index_pos + sizeof(index_pos));
-                ptr = index_mapped_file.data() + index_pos;
-                *reinterpret_cast<uint64_t*>(ptr) = block_pos;
+                    record_end = block_pos + record_header_size + packed_data->size() + sizeof(block_pos);
+                    reserve(state.block_mapped_file, block_path, record_end);
+                    auto* ptr = state.block_mapped_file->data() + block_pos;
+                    *reinterpret_cast<uint32_t*>(ptr) = static_cast<uint32_t>(packed_data->size());
+                    ptr += sizeof(uint32_t);
+                    *reinterpret_cast<uint32_t*>(ptr) = static_cast<uint32_t>(data.size());
+                    ptr += sizeof(uint32_t);
+                    std::memcpy(ptr, packed_data->data(), packed_data->size());
+                    ptr += packed_data->size();
+                    *reinterpret_cast<uint64_t*>(ptr) = block_pos;
+                }
+                state.block_end = record_end;
 
-                head = b;
-                head_id = b.id();
+                if ((block_num - 1) % state.index_step == 0) {
+                    reserve(state.index_mapped_file, index_path, index_pos + sizeof(index_pos));
+                    auto* ptr = state.index_mapped_file->data() + index_pos;
+                    *reinterpret_cast<uint64_t*>(ptr) = block_pos;
+                    state.index_end = index_pos + sizeof(index_pos);
+                }
+
+                state.head = std::make_shared<const signed_block>(b);
+                state.head_id = b.id();
+                publish();
                 return block_pos;
             } FC_LOG_AND_RETHROW() }
 
             void close() {
-                block_mapped_file.close();
-                index_mapped_file.close();
-                head.reset();
-                head_id = block_id_type();
+                unpublish();
+
+                // the preallocated tails are cut, so the closed log has the same layout as without extents
+                if (state.block_mapped_file) {
+                    truncate(*state.block_mapped_file, state.block_end);
+                }
+                if (state.index_mapped_file) {
+                    truncate(*state.index_mapped_file, state.index_end);
+                }
+                state = block_log_state();
+                compressor.reset();
             }
         };
     }
@@ -233,47 +843,73 @@ namespace graphene { namespace chain {
 
     block_log::~block_log() {
         flush();
+        close();
     }
 
-    void block_log::open(const fc::path& file) {
-        detail::write_lock lock(my->mutex);
+    void block_log::open(const fc::path& file, const block_log_options& options) {
+        FC_ASSERT(options.version == 1 || options.version == 2, "Unknown version of block log.");
+        FC_ASSERT(options.index_step > 0, "Index step of block log should be positive.");
+        FC_ASSERT(options.version == 2 || (options.index_step == 1 && options.compression == block_log_compression::none),
+            "Version 1 of block log supports neither compression nor sparse index.");
+
+        std::lock_guard<std::mutex> lock(my->mutex);
+        my->options = options;
         my->open(file);
     }
 
     void block_log::close() {
-        detail::write_lock lock(my->mutex);
+        std::lock_guard<std::mutex> lock(my->mutex);
         my->close();
     }
 
     bool block_log::is_open() const {
-        detail::read_lock lock(my->mutex);
-        return my->block_mapped_file.is_open();
+        return my->published_state.load() != nullptr;
+    }
+
+    uint32_t block_log::version() const {
+        std::lock_guard<std::mutex> lock(my->mutex);
+        return my->state.version;
+    }
+
+    block_log_compression block_log::compression() const {
+        std::lock_guard<std::mutex> lock(my->mutex);
+        return my->compressor.get_compression();
+    }
+
+    uint32_t block_log::index_step() const {
+        std::lock_guard<std::mutex> lock(my->mutex);
+        return my->state.index_step;
     }
 
     uint64_t block_log::append(const signed_block& block) { try {
         auto data = fc::raw::pack(block);
-        detail::write_lock lock(my->mutex);
+        std::lock_guard<std::mutex> lock(my->mutex);
         return my->append(block, data);
     } FC_LOG_AND_RETHROW() }
 
     void block_log::flush() {
-        // it isn't needed, because all data is already in page cache
+        // blocks are written to shared mappings, so they are in the page cache after append
     }
 
     std::pair<signed_block, uint64_t> block_log::read_block(uint64_t pos) const {
-        detail::read_lock lock(my->mutex);
+        detail::epoch_manager::guard guard(my->epochs);
+        const auto* state = my->published_state.load(std::memory_order_acquire);
+        FC_ASSERT(state, "Block log is not open.");
+
         std::pair<signed_block, uint64_t> result;
-        result.second = my->read_block(pos, result.first);
+        result.second = state->read_block(pos, result.first);
         return result;
     }
 
     optional<signed_block> block_log::read_block_by_num(uint32_t block_num) const { try {
-        detail::read_lock lock(my->mutex);
+        detail::epoch_manager::guard guard(my->epochs);
+        const auto* state = my->published_state.load(std::memory_order_acquire);
+
         optional<signed_block> result;
-        uint64_t pos = my->get_block_pos(block_num);
+        uint64_t pos = state ? state->get_block_pos(block_num) : npos;
         if (pos != npos) {
             signed_block block;
-            my->read_block(pos, block);
+            state->read_block(pos, block);
             FC_ASSERT(
                 block.block_num() == block_num,
                 "Wrong block was read from block log (${returned} != ${expected}).",
@@ -285,17 +921,180 @@ namespace graphene { namespace chain {
     } FC_LOG_AND_RETHROW() }
 
     uint64_t block_log::get_block_pos(uint32_t block_num) const {
-        detail::read_lock lock(my->mutex);
-        return my->get_block_pos(block_num);
+        detail::epoch_manager::guard guard(my->epochs);
+        const auto* state = my->published_state.load(std::memory_order_acquire);
+        return state ? state->get_block_pos(block_num) : npos;
     }
 
     signed_block block_log::read_head() const {
-        detail::read_lock lock(my->mutex);
-        return my->read_head();
+        detail::epoch_manager::guard guard(my->epochs);
+        const auto* state = my->published_state.load(std::memory_order_acquire);
+        FC_ASSERT(state, "Block log is not open.");
+        return state->read_head();
+    }
+
+    optional<signed_block> block_log::head() const {
+        detail::epoch_manager::guard guard(my->epochs);
+        const auto* state = my->published_state.load(std::memory_order_acquire);
+        if (!state || !state->head) {
+            return optional<signed_block>();
+        }
+        return *state->head;
     }
 
-    const optional<signed_block>& block_log::head() const {
-        detail::read_lock lock(my->mutex);
-        return my->head;
+    uint32_t block_log::head_block_num() const {
+        detail::epoch_manager::guard guard(my->epochs);
+        const auto* state = my->published_state.load(std::memory_order_acquire);
+        if (!state || !state->head) {
+            return 0;
+        }
+        return protocol::block_header::num_from_id(state->head_id);
     }
+
+    namespace detail {
+        static void verify_blocks(
+            const block_log& log, uint32_t first_num, uint32_t last_num, uint32_t head_num, std::atomic<uint32_t>& checked
+        ) {
+            block_id_type prev_id;
+            if (first_num > 1) {
+                prev_id = log.read_block_by_num(first_num - 1)->id();
+            }
+
+            auto pos = log.get_block_pos(first_num);
+            for (auto num = first_num; num <= last_num; ++num) {
+                auto result = log.read_block(pos);
+                const auto& block = result.first;
+
+                FC_ASSERT(block.block_num() == num,
+                    "Block ${n} has wrong number ${b}.", ("n", num)("b", block.block_num()));
+                FC_ASSERT(block.previous == prev_id,
+                    "Block ${n} doesn't link to the previous block.", ("n", num)("previous", block.previous));
+                FC_ASSERT(block.transaction_merkle_root == block.calculate_merkle_root(),
+                    "Block ${n} has wrong merkle root.", ("n", num));
+
+                prev_id = block.id();
+                pos = result.second;
+
+                // report progress each 10%
+                const auto step = std::max<uint32_t>(head_num / 10, 1);
+                const auto total = checked.fetch_add(1, std::memory_order_relaxed) + 1;
+                if (total % step == 0) {
+                    ilog("Verified ${p}% of block log (${n} of ${h})",
+                         ("p", uint64_t(total) * 100 / head_num)("n", total)("h", head_num));
+                }
+            }
+        }
+    }
+
+    void block_log::verify(uint32_t threads) const { try {
+        const auto head_num = head_block_num();
+        if (!head_num) {
+            return;
+        }
+
+        threads = std::max<uint32_t>(1, std::min(threads, head_num));
+        const uint32_t range_size = (head_num + threads - 1) / threads;
+
+        std::atomic<uint32_t> checked{0};
+        std::vector<std::exception_ptr> errors(threads);
+        std::vector<std::thread> workers;
+
+        ilog("Verifying block log with ${n} blocks on ${t} threads", ("n", head_num)("t", threads));
+
+        for (uint32_t i = 0; i < threads; ++i) {
+            const uint32_t first_num = i * range_size + 1;
+            const uint32_t last_num = std::min(head_num, first_num + range_size - 1);
+            if (first_num > last_num) {
+                break;
+            }
+
+            workers.emplace_back([&, i, first_num, last_num]() {
+                try {
+                    detail::verify_blocks(*this, first_num, last_num, head_num, checked);
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            });
+        }
+
+        for (auto& worker: workers) {
+            worker.join();
+        }
+
+        for (auto& error: errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+
+        ilog("Block log is verified");
+    } FC_LOG_AND_RETHROW() }
+
+    void block_log::convert(const fc::path& file, const block_log_options& options) { try {
+        FC_ASSERT(options.version == 1 || options.version == 2, "Unknown version of block log.");
+
+        const auto tmp_file = fc::path(file.string() + ".convert");
+        const auto tmp_index = fc::path(tmp_file.string() + ".index");
+
+        block_log src;
+        src.open(file);
+
+        const auto head_num = src.head_block_num();
+        if (head_num == 0) {
+            ilog("Block log ${f} is empty, nothing to convert", ("f", file.string()));
+            return;
+        }
+        if (src.version() == options.version && src.compression() == options.compression &&
+            src.index_step() == options.index_step
+        ) {
+            ilog("Block log ${f} already has version ${v} with the requested compression, it isn't converted",
+                 ("f", file.string())("v", options.version));
+            return;
+        }
+
+        ilog("Converting block log ${f} with ${n} blocks from version ${v}",
+             ("f", file.string())("n", head_num)("v", src.version()));
+
+        block_log dst;
+        fc::remove_all(tmp_file);
+        fc::remove_all(tmp_index);
+
+        if (options.compression != block_log_compression::none && options.dictionary_size) {
+            // zstd recommends to have about 100 times more samples than the size of the dictionary
+            const uint64_t max_samples_size = uint64_t(options.dictionary_size) * 100;
+            const uint32_t sample_step = std::max<uint32_t>(1, head_num / 100000);
+
+            std::vector<char> samples;
+            std::vector<std::size_t> sample_sizes;
+            for (uint32_t num = 1; num <= head_num && samples.size() < max_samples_size; num += sample_step) {
+                auto data = fc::raw::pack(*src.read_block_by_num(num));
+                samples.insert(samples.end(), data.begin(), data.end());
+                sample_sizes.push_back(data.size());
+            }
+
+            ilog("Training compression dictionary on ${n} blocks", ("n", sample_sizes.size()));
+            dst.my->new_dictionary = detail::block_compressor::train_dictionary(
+                samples, sample_sizes, options.dictionary_size);
+        }
+
+        dst.open(tmp_file, options);
+
+        uint32_t last_percent = 0;
+        for (uint32_t num = 1; num <= head_num; ++num) {
+            dst.append(*src.read_block_by_num(num));
+
+            uint32_t percent = uint64_t(num) * 100 / head_num;
+            if (percent != last_percent) {
+                ilog("Converted ${p}% of block log (${n} of ${h})", ("p", percent)("n", num)("h", head_num));
+                last_percent = percent;
+            }
+        }
+
+        src.close();
+        dst.close();
+
+        fc::rename(tmp_file, file);
+        fc::rename(tmp_index, fc::path(file.string() + ".index"));
+        ilog("Block log ${f} is converted", ("f", file.string()));
+    } FC_CAPTURE_LOG_AND_RETHROW((file)) }
 } } // graphene::chain
@@ -0,0 +1,266 @@
+#include <graphene/chain/block_timing.hpp>
+
+#include <fc/log/logger.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+namespace graphene { namespace chain {
+
+        namespace {
+            struct key_registry {
+                std::mutex mutex;
+                std::vector<std::string> names;
+                std::map<std::string, block_timing::key_type> keys;
+            };
+
+            key_registry& registry() {
+                static key_registry instance;
+                return instance;
+            }
+
+            std::string format_millis(uint64_t micros) {
+                char buf[32];
+                snprintf(buf, sizeof(buf), "%.3fms", double(micros) / 1000.0);
+                return buf;
+            }
+        }
+
+        constexpr uint32_t latency_histogram::sub_bucket_bits;
+        constexpr uint32_t latency_histogram::sub_buckets;
+        constexpr uint32_t latency_histogram::bucket_count;
+        constexpr uint32_t block_timing::slot_count;
+
+        uint32_t latency_histogram::bucket_index(uint64_t value) {
+            if (value < sub_buckets) {
+                return static_cast<uint32_t>(value);
+            }
+            value = std::min<uint64_t>(value, UINT32_MAX);
+
+            uint32_t exponent = 0;
+            for (auto v = value; v >>= 1;) {
+                ++exponent;
+            }
+            const auto mantissa = static_cast<uint32_t>(value >> (exponent - sub_bucket_bits)) & (sub_buckets - 1);
+            return (exponent - sub_bucket_bits + 1) * sub_buckets + mantissa;
+        }
+
+        uint64_t latency_histogram::bucket_upper_bound(uint32_t index) {
+            if (index < sub_buckets) {
+                return index;
+            }
+            const uint32_t shift = index / sub_buckets - 1;
+            const uint64_t lower = uint64_t(sub_buckets + index % sub_buckets) << shift;
+            return lower + (uint64_t(1) << shift) - 1;
+        }
+
+        void latency_histogram::record(uint64_t value) {
+            ++_buckets[bucket_index(value)];
+            ++_count;
+            _sum += value;
+            _max = std::max(_max, value);
+        }
+
+        void latency_histogram::merge(const latency_histogram& other) {
+            for (uint32_t i = 0; i < bucket_count; ++i) {
+                _buckets[i] += other._buckets[i];
+            }
+            _count += other._count;
+            _sum += other._sum;
+            _max = std::max(_max, other._max);
+        }
+
+        void latency_histogram::reset() {
+            *this = latency_histogram();
+        }
+
+        uint64_t latency_histogram::percentile(double p) const {
+            if (_count == 0) {
+                return 0;
+            }
+
+            const auto target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(_count * p / 100.0)));
+            uint64_t seen = 0;
+            for (uint32_t i = 0; i < bucket_count; ++i) {
+                seen += _buckets[i];
+                if (seen >= target) {
+                    return std::min(bucket_upper_bound(i), _max);
+                }
+            }
+            return _max;
+        }
+
+        block_timing::key_type block_timing::key(const std::string& name) {
+            auto& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+
+            auto itr = r.keys.find(name);
+            if (itr != r.keys.end()) {
+                return itr->second;
+            }
+
+            const auto result = static_cast<key_type>(r.names.size());
+            r.names.push_back(name);
+            r.keys.emplace(name, result);
+            return result;
+        }
+
+        std::string block_timing::key_name(key_type key) {
+            auto& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            return key < r.names.size() ? r.names[key] : std::string();
+        }
+
+        void block_timing::set_enabled(bool value) {
+            _enabled = value;
+        }
+
+        void block_timing::set_window(uint32_t blocks) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _window = std::max<uint32_t>(blocks, slot_count);
+            for (auto& s: _slots) {
+                s = slot();
+            }
+        }
+
+        void block_timing::set_log_interval(uint32_t blocks) {
+            _log_interval = blocks;
+        }
+
+        void block_timing::set_budget(fc::microseconds value) {
+            _budget = value;
+        }
+
+        void block_timing::begin_block() {
+            // durations of a failed block are dropped
+            _pending.clear();
+        }
+
+        void block_timing::end_block(uint32_t block_num, int64_t block_micros) {
+            if (!_enabled) {
+                return;
+            }
+
+            static const auto block_key = key("block");
+
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+
+                if (_slots[_current_slot].blocks >= _window / slot_count) {
+                    _current_slot = (_current_slot + 1) % slot_count;
+                    _slots[_current_slot] = slot();
+                }
+
+                auto& s = _slots[_current_slot];
+                ++s.blocks;
+
+                auto record_to = [&](key_type k, uint64_t micros) {
+                    if (k >= s.histograms.size()) {
+                        s.histograms.resize(k + 1);
+                    }
+                    s.histograms[k].record(micros);
+                };
+
+                record_to(block_key, static_cast<uint64_t>(std::max<int64_t>(block_micros, 0)));
+                for (const auto& item: _pending) {
+                    record_to(item.first, item.second);
+                }
+
+                _head_block_num = block_num;
+            }
+
+            if (_budget.count() > 0 && block_micros > _budget.count()) {
+                log_budget_exceeded(block_num, block_micros);
+            }
+
+            if (_log_interval && block_num % _log_interval == 0) {
+                log_summary();
+            }
+
+            _pending.clear();
+        }
+
+        void block_timing::log_budget_exceeded(uint32_t block_num, int64_t block_micros) const {
+            std::map<key_type, uint64_t> totals;
+            for (const auto& item: _pending) {
+                totals[item.first] += item.second;
+            }
+
+            std::vector<std::pair<key_type, uint64_t>> items(totals.begin(), totals.end());
+            std::sort(items.begin(), items.end(), [](const auto& l, const auto& r) {
+                return l.second > r.second;
+            });
+
+            std::string slowest;
+            for (std::size_t i = 0; i < items.size() && i < 5; ++i) {
+                slowest += (i ? ", " : "") + key_name(items[i].first) + " " + format_millis(items[i].second);
+            }
+
+            wlog("Block ${n} is applied in ${t}, the budget is ${b}, slowest: ${s}",
+                 ("n", block_num)("t", format_millis(block_micros))("b", format_millis(_budget.count()))
+                 ("s", slowest));
+        }
+
+        void block_timing::log_summary() const {
+            const auto r = report();
+
+            std::string block;
+            std::string slowest;
+            uint32_t slowest_count = 0;
+            for (const auto& stat: r.stats) {
+                if (stat.name == "block") {
+                    block = "p50 " + format_millis(stat.p50_us) + ", p99 " + format_millis(stat.p99_us) +
+                            ", max " + format_millis(stat.max_us);
+                } else if (slowest_count < 5) {
+                    slowest += (slowest_count++ ? ", " : "") + stat.name + " " + format_millis(stat.total_us);
+                }
+            }
+
+            ilog("Block timing for last ${n} blocks: ${b}; slowest in total: ${s}",
+                 ("n", r.blocks)("b", block)("s", slowest));
+        }
+
+        block_timing_report block_timing::report() const {
+            block_timing_report result;
+            result.enabled = _enabled;
+
+            std::vector<latency_histogram> merged;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                result.head_block_num = _head_block_num;
+                for (const auto& s: _slots) {
+                    result.blocks += s.blocks;
+                    if (merged.size() < s.histograms.size()) {
+                        merged.resize(s.histograms.size());
+                    }
+                    for (std::size_t i = 0; i < s.histograms.size(); ++i) {
+                        merged[i].merge(s.histograms[i]);
+                    }
+                }
+            }
+
+            for (std::size_t i = 0; i < merged.size(); ++i) {
+                const auto& h = merged[i];
+                if (h.count() == 0) {
+                    continue;
+                }
+
+                block_timing_stat stat;
+                stat.name = key_name(static_cast<key_type>(i));
+                stat.count = h.count();
+                stat.total_us = h.sum();
+                stat.max_us = h.max();
+                stat.p50_us = h.percentile(50);
+                stat.p90_us = h.percentile(90);
+                stat.p99_us = h.percentile(99);
+                result.stats.push_back(std::move(stat));
+            }
+
+            std::sort(result.stats.begin(), result.stats.end(), [](const auto& l, const auto& r) {
+                return l.total_us > r.total_us;
+            });
+            return result;
+        }
+
+} } // graphene::chain
@@ -21,6 +21,7 @@
 #include <graphene/chain/committee_objects.hpp>
 #include <graphene/chain/invite_objects.hpp>
 #include <graphene/chain/paid_subscription_objects.hpp>
+#include <graphene/chain/replay_pipeline.hpp>
 
 #include <fc/smart_ref_impl.hpp>
 
@@ -68,6 +69,17 @@ struct snapshot_items
     vector <snapshot_account> accounts;
 };
 
+/**
+ * State of the replay which is stored in the shared memory directory.
+ * Clean checkpoint means that the shared memory was flushed at the block,
+ * otherwise the replay was in progress and the shared memory can be inconsistent.
+ */
+struct replay_checkpoint {
+    uint32_t block_num = 0;
+    block_id_type block_id;
+    bool is_clean = false;
+};
+
 } } // graphene::chain
 
 FC_REFLECT((graphene::chain::object_schema_repr), (space_type)(type))
@@ -75,6 +87,7 @@ FC_REFLECT((graphene::chain::operation_schema_repr), (id)(type))
 FC_REFLECT((graphene::chain::db_schema), (types)(object_types)(operation_type)(custom_operation_types))
 FC_REFLECT((graphene::chain::snapshot_account), (login)(public_key)(shares_amount))
 FC_REFLECT((graphene::chain::snapshot_items), (accounts))
+FC_REFLECT((graphene::chain::replay_checkpoint), (block_num)(block_id)(is_clean))
 
 
 
@@ -83,6 +96,52 @@ namespace graphene { namespace chain {
         using std::sig_atomic_t;
         using boost::container::flat_set;
 
+        static const char* replay_checkpoint_file = "replay_checkpoint.json";
+
+        static const char* replay_snapshot_dir = "replay_snapshot";
+
+        /// the replaced snapshot is kept here until the new one is renamed into place
+        static const char* old_replay_snapshot_dir = "replay_snapshot.old";
+
+        using detail::sync_file;
+
+        struct operation_timing_key_visitor {
+            typedef block_timing::key_type result_type;
+
+            template<typename T>
+            result_type operator()(const T &) const {
+                static const auto key = block_timing::key("operation." + name_from_type(fc::get_typename<T>::name()));
+                return key;
+            }
+
+            static std::string name_from_type(const std::string &type_name) {
+                auto start = type_name.find_last_of(':');
+                return start == std::string::npos ? type_name : type_name.substr(start + 1);
+            }
+        };
+
+/// measures the maintenance phase of _apply_block as "phase.<name>"
+#define CHAIN_TIMED_PHASE(name, call)                                       \
+        {                                                                   \
+            static const auto phase_key = block_timing::key("phase." #name); \
+            block_timing::scope phase_scope(_block_timing, phase_key);      \
+            call;                                                           \
+        }
+
+        static optional<replay_checkpoint> read_replay_checkpoint(const fc::path &shared_mem_dir) {
+            const auto file = shared_mem_dir / replay_checkpoint_file;
+            if (!fc::exists(file)) {
+                return optional<replay_checkpoint>();
+            }
+            try {
+                return fc::json::from_file(file).as<replay_checkpoint>();
+            } catch (const fc::exception &e) {
+                wlog("Can't read replay checkpoint: ${e}", ("e", e.to_detail_string()));
+                // the unreadable checkpoint is treated as an inconsistent state
+                return replay_checkpoint();
+            }
+        }
+
         inline u256 to256(const fc::uint128_t &t) {
             u256 v(t.hi);
             v <<= 64;
@@ -208,6 +267,38 @@ namespace graphene { namespace chain {
                 wlog("Start opening database. Please wait, don't break application...");
 
                 init_schema();
+
+                bool wipe_requested = false;
+                if (chainbase_flags & chainbase::database::read_write) {
+                    auto checkpoint = read_replay_checkpoint(shared_mem_dir);
+                    if (checkpoint.valid() && !checkpoint->is_clean) {
+                        const auto snapshot_dir = data_dir / replay_snapshot_dir;
+                        const auto old_snapshot_dir = data_dir / old_replay_snapshot_dir;
+                        if (!fc::exists(snapshot_dir / "snapshot.json") && fc::exists(old_snapshot_dir / "snapshot.json")) {
+                            // the crash happened while the snapshot was replaced
+                            fc::remove_all(snapshot_dir);
+                            fc::rename(old_snapshot_dir, snapshot_dir);
+                        }
+                        if (_load_snapshot_dir.empty() && fc::exists(snapshot_dir / "snapshot.json")) {
+                            wlog("Replay was broken after block ${n}, it will be resumed from the replay snapshot",
+                                 ("n", checkpoint->block_num));
+                            _load_snapshot_dir = snapshot_dir;
+                        } else if (_load_snapshot_dir.empty()) {
+                            wlog("Replay was broken after block ${n}, shared memory is inconsistent, "
+                                 "replay will be started from the first block", ("n", checkpoint->block_num));
+                            wipe_requested = true;
+                        }
+                    }
+                }
+
+                const bool load_snapshot_requested = !_load_snapshot_dir.empty() &&
+                    (chainbase_flags & chainbase::database::read_write);
+                if (load_snapshot_requested || wipe_requested) {
+                    wlog("Wiping shared memory...");
+                    chainbase::database::wipe(shared_mem_dir);
+                    fc::remove_all(shared_mem_dir / replay_checkpoint_file);
+                }
+
                 chainbase::database::open(shared_mem_dir, chainbase_flags, shared_file_size);
 
                 initialize_indexes();
@@ -222,11 +313,20 @@ namespace graphene { namespace chain {
 
                     if (!find<dynamic_global_property_object>()) {
                         with_strong_write_lock([&]() {
-                            init_genesis(initial_supply);
+                            if (load_snapshot_requested) {
+                                load_snapshot(_load_snapshot_dir);
+                            } else {
+                                init_genesis(initial_supply);
+                            }
                         });
                     }
+                    _load_snapshot_dir = fc::path();
+
+                    _block_log.open(data_dir / "block_log", _block_log_options);
 
-                    _block_log.open(data_dir / "block_log");
+                    CHAIN_ASSERT(!load_snapshot_requested || _block_log.head_block_num() >= head_block_num(),
+                        block_log_exception, "Block log should contain the head block ${n} of the snapshot",
+                        ("n", head_block_num()));
 
                     // Rewind all undo state. This should return us to the state at the last irreversible block.
                     with_strong_write_lock([&]() {
@@ -288,47 +388,123 @@ namespace graphene { namespace chain {
                         skip_validate_operations | /// no need to validate operations
                         skip_block_log;
 
+                uint64_t apply_micro = 0;
+                uint64_t decode_micro = 0;
+                uint64_t wait_micro = 0;
+
+                // before modification of the state, the checkpoint is marked as inconsistent
+                bool is_checkpoint_clean = true;
+
+                auto write_checkpoint = [&](uint32_t block_num) {
+                    write_replay_checkpoint(shared_mem_dir, true);
+                    is_checkpoint_clean = true;
+
+                    if (_replay_snapshot_interval && block_num % _replay_snapshot_interval == 0) {
+                        // the previous snapshot is kept until the new one is in place, so one of them always exists
+                        const auto snapshot_dir = data_dir / replay_snapshot_dir;
+                        const auto old_snapshot_dir = data_dir / old_replay_snapshot_dir;
+                        const auto tmp_dir = data_dir / (std::string(replay_snapshot_dir) + ".tmp");
+                        fc::remove_all(tmp_dir);
+                        write_snapshot(tmp_dir);
+                        fc::remove_all(old_snapshot_dir);
+                        if (fc::exists(snapshot_dir)) {
+                            fc::rename(snapshot_dir, old_snapshot_dir);
+                        }
+                        fc::rename(tmp_dir, snapshot_dir);
+                        sync_file(data_dir);
+                        fc::remove_all(old_snapshot_dir);
+                    }
+                };
+
                 with_strong_write_lock([&]() {
                     auto cur_block_num = from_block_num;
                     auto last_block_num = _block_log.head()->block_num();
                     auto last_block_pos = _block_log.get_block_pos(last_block_num);
                     int last_reindex_percent = 0;
 
+                    replay_pipeline pipeline(
+                        _block_log, from_block_num, last_block_num,
+                        _replay_decode_threads, _replay_decode_threads * 64);
+
+                    auto apply_decoded_block = [&](const decoded_block &cur_block) {
+                        if (_replay_checkpoint_interval && is_checkpoint_clean) {
+                            write_replay_checkpoint(shared_mem_dir, false);
+                            is_checkpoint_clean = false;
+                        }
+
+                        auto apply_start = fc::time_point::now();
+                        _replay_block = &cur_block;
+                        try {
+                            apply_block(cur_block.block, skip_flags);
+                        } catch (...) {
+                            _replay_block = nullptr;
+                            throw;
+                        }
+                        _replay_block = nullptr;
+                        apply_micro += (fc::time_point::now() - apply_start).count();
+                        pipeline.release();
+                    };
+
+                    auto update_timings = [&]() {
+                        decode_micro = pipeline.decode_micro();
+                        wait_micro = pipeline.wait_micro();
+                    };
+
                     set_reserved_memory(1024*1024*1024); // protect from memory fragmentations ...
                     while (cur_block_num < last_block_num) {
                         if (signal_guard::get_is_interrupted()) {
+                            update_timings();
+                            if (_replay_checkpoint_interval) {
+                                // the next replay continues from this block
+                                write_replay_checkpoint(shared_mem_dir, true);
+                            }
                             return;
                         }
 
-                        auto end = fc::time_point::now();
-                        auto cur_block_pos = _block_log.get_block_pos(cur_block_num);
-                        auto cur_block = *_block_log.read_block_by_num(cur_block_num);
+                        const auto &cur_block = pipeline.next();
 
-                        auto reindex_percent = cur_block_pos * 100 / last_block_pos;
+                        auto end = fc::time_point::now();
+                        auto reindex_percent = cur_block.block_pos * 100 / last_block_pos;
                         if (reindex_percent - last_reindex_percent >= 1) {
                             std::cerr
                                 << "   " << reindex_percent << "%   "
                                 << cur_block_num << " of " << last_block_num
                                 << "   ("  << (free_memory() / (1024 * 1024)) << "M free"
-                                << ", elapsed " << double((end - start).count()) / 1000000.0 << " sec)\n";
+                                << ", elapsed " << double((end - start).count()) / 1000000.0 << " sec"
+                                << ", apply " << double(apply_micro) / 1000000.0 << " sec"
+                                << ", decode " << double(pipeline.decode_micro()) / 1000000.0 << " sec"
+                                << " on " << pipeline.decode_threads() << " threads"
+                                << ", wait " << double(pipeline.wait_micro()) / 1000000.0 << " sec)\n";
 
                             last_reindex_percent = reindex_percent;
                         }
 
-                        apply_block(cur_block, skip_flags);
+                        apply_decoded_block(cur_block);
 
                         if (cur_block_num % 1000 == 0) {
                             set_revision(head_block_num());
                         }
 
-                        check_free_memory(true, cur_block_num);
+                        // resize flushes the shared memory, so it is a cheap point for the checkpoint
+                        const bool is_resized = check_free_memory(true, cur_block_num);
+                        if (_replay_checkpoint_interval &&
+                            (is_resized || cur_block_num % _replay_checkpoint_interval == 0)
+                        ) {
+                            write_checkpoint(cur_block_num);
+                        }
                         cur_block_num++;
                     }
 
-                    auto cur_block = *_block_log.read_block_by_num(cur_block_num);
-                    apply_block(cur_block, skip_flags);
+                    apply_decoded_block(pipeline.next());
+                    update_timings();
                     set_reserved_memory(0);
                     set_revision(head_block_num());
+
+                    if (_replay_checkpoint_interval) {
+                        // replay is finished, the state is maintained in the usual way from now
+                        chainbase::database::flush();
+                        fc::remove_all(shared_mem_dir / replay_checkpoint_file);
+                    }
                 });
 
                 if (signal_guard::get_is_interrupted()) {
@@ -341,8 +517,13 @@ namespace graphene { namespace chain {
                     _fork_db.start_block(*_block_log.head());
                 }
                 auto end = fc::time_point::now();
-                ilog("Done reindexing, elapsed time: ${t} sec", ("t",
-                        double((end - start).count()) / 1000000.0));
+                ilog("Done reindexing, elapsed time: ${t} sec, apply time: ${a} sec, "
+                     "decode time: ${d} sec on ${n} threads, wait for decoding: ${w} sec",
+                     ("t", double((end - start).count()) / 1000000.0)
+                     ("a", double(apply_micro) / 1000000.0)
+                     ("d", double(decode_micro) / 1000000.0)
+                     ("n", _replay_decode_threads)
+                     ("w", double(wait_micro) / 1000000.0));
             }
             FC_CAPTURE_AND_RETHROW((data_dir)(shared_mem_dir))
 
@@ -360,6 +541,46 @@ namespace graphene { namespace chain {
             _block_num_check_free_memory = value;
         }
 
+        void database::set_replay_decode_threads(uint32_t value) {
+            _replay_decode_threads = value;
+        }
+
+        void database::set_block_log_options(const block_log_options &value) {
+            _block_log_options = value;
+        }
+
+        void database::set_replay_checkpoint_interval(uint32_t value) {
+            _replay_checkpoint_interval = value;
+        }
+
+        void database::set_replay_snapshot_interval(uint32_t value) {
+            _replay_snapshot_interval = value;
+        }
+
+        void database::write_replay_checkpoint(const fc::path &shared_mem_dir, bool is_clean) {
+            replay_checkpoint checkpoint;
+            checkpoint.block_num = head_block_num();
+            checkpoint.block_id = head_block_id();
+            checkpoint.is_clean = is_clean;
+
+            if (is_clean) {
+                set_revision(checkpoint.block_num);
+                chainbase::database::flush();
+            }
+
+            // the file is replaced atomically and synced to disk, so a crash can't leave a torn checkpoint
+            const auto file = shared_mem_dir / replay_checkpoint_file;
+            const auto tmp_file = shared_mem_dir / (std::string(replay_checkpoint_file) + ".tmp");
+            fc::json::save_to_file(checkpoint, tmp_file);
+            sync_file(tmp_file);
+            fc::rename(tmp_file, file);
+            sync_file(shared_mem_dir);
+
+            if (is_clean) {
+                ilog("Replay checkpoint is written at block ${n}", ("n", checkpoint.block_num));
+            }
+        }
+
         void database::set_skip_virtual_ops() {
             _skip_virtual_ops = true;
         }
@@ -392,9 +613,9 @@ namespace graphene { namespace chain {
             return true;
         }
 
-        void database::check_free_memory(bool skip_print, uint32_t current_block_num) {
+        bool database::check_free_memory(bool skip_print, uint32_t current_block_num) {
             if (0 != current_block_num % _block_num_check_free_memory) {
-                return;
+                return false;
             }
 
             uint64_t reserved_mem = reserved_memory();
@@ -409,7 +630,7 @@ namespace graphene { namespace chain {
             if (_inc_shared_memory_size != 0 && _min_free_shared_memory_size != 0 &&
                 free_mem < _min_free_shared_memory_size
             ) {
-                _resize(current_block_num);
+                return _resize(current_block_num);
             } else if (!skip_print && _inc_shared_memory_size == 0 && _min_free_shared_memory_size == 0) {
                 uint32_t free_gb = uint32_t(free_mem / (1024 * 1024 * 1024));
                 if ((free_gb < _last_free_gb_printed) || (free_gb > _last_free_gb_printed + 1)) {
@@ -426,11 +647,14 @@ namespace graphene { namespace chain {
                     }
                 }
             }
+
+            return false;
         }
 
         void database::wipe(const fc::path &data_dir, const fc::path &shared_mem_dir, bool include_blocks) {
             close();
             chainbase::database::wipe(shared_mem_dir);
+            fc::remove_all(shared_mem_dir / replay_checkpoint_file);
             if (include_blocks) {
                 fc::remove_all(data_dir / "block_log");
                 fc::remove_all(data_dir / "block_log.index");
@@ -1184,6 +1408,10 @@ namespace graphene { namespace chain {
             notify_post_apply_operation(note);
         }
 
+        void database::notify_pre_apply_block(const signed_block &block) {
+            CHAIN_TRY_NOTIFY(pre_apply_block, block)
+        }
+
         void database::notify_applied_block(const signed_block &block) {
             CHAIN_TRY_NOTIFY(applied_block, block)
         }
@@ -2609,6 +2837,8 @@ namespace graphene { namespace chain {
         }
 
         void database::initialize_indexes() {
+            _snapshot_indexes.clear();
+
             add_core_index<dynamic_global_property_index>(*this);
             add_core_index<account_index>(*this);
             add_core_index<account_authority_index>(*this);
@@ -3091,11 +3321,31 @@ namespace graphene { namespace chain {
             return _block_log;
         }
 
+        block_timing &database::get_block_timing() {
+            return _block_timing;
+        }
+
+        const block_timing &database::get_block_timing() const {
+            return _block_timing;
+        }
+
+        std::atomic<bool> database::_is_read_lock_wait_measured{false};
+
+        void database::set_read_lock_wait_measured(bool value) {
+            _is_read_lock_wait_measured = value;
+        }
+
+        uint64_t &database::read_lock_wait_micros() {
+            static thread_local uint64_t value = 0;
+            return value;
+        }
+
 //////////////////// private methods ////////////////////
 
         void database::apply_block(const signed_block &next_block, uint32_t skip) {
             try {
-                //fc::time_point begin_time = fc::time_point::now();
+                fc::time_point begin_time = fc::time_point::now();
+                _block_timing.begin_block();
 
                 auto block_num = next_block.block_num();
                 if (_checkpoints.size() &&
@@ -3122,8 +3372,7 @@ namespace graphene { namespace chain {
 
                 _apply_block(next_block, skip);
 
-                //fc::time_point end_time = fc::time_point::now();
-                //fc::microseconds dt = end_time - begin_time;
+                _block_timing.end_block(block_num, (fc::time_point::now() - begin_time).count());
                 if (_flush_blocks != 0) {
                     if (_next_flush_block == 0) {
                         uint32_t lep = block_num + 1 + _flush_blocks * 9 / 10;
@@ -3150,6 +3399,22 @@ namespace graphene { namespace chain {
             } FC_CAPTURE_AND_RETHROW((next_block))
         }
 
+        block_id_type database::get_block_id(const signed_block &b) const {
+            if (_replay_block && &_replay_block->block == &b) {
+                return _replay_block->block_id;
+            }
+            return b.id();
+        }
+
+        transaction_id_type database::get_transaction_id(const signed_transaction &trx) const {
+            if (_replay_block && _current_trx_in_block < _replay_block->trx_ids.size() &&
+                &_replay_block->block.transactions[_current_trx_in_block] == &trx
+            ) {
+                return _replay_block->trx_ids[_current_trx_in_block];
+            }
+            return trx.id();
+        }
+
         void database::_apply_block(const signed_block &next_block, uint32_t skip) {
             try {
                 uint32_t next_block_num = next_block.block_num();
@@ -3157,14 +3422,17 @@ namespace graphene { namespace chain {
                 const auto &hardfork_state = get_hardfork_property_object();
                 //block_id_type next_block_id = next_block.id();
 
-                _validate_block(next_block, skip);
+                CHAIN_TIMED_PHASE(validate_block, _validate_block(next_block, skip))
 
-                const witness_object &signing_witness = validate_block_header(skip, next_block);
+                const witness_object *signing_witness = nullptr;
+                CHAIN_TIMED_PHASE(validate_block_header, signing_witness = &validate_block_header(skip, next_block))
 
                 _current_block_num = next_block_num;
                 _current_trx_in_block = 0;
                 _current_virtual_op = 0;
 
+                notify_pre_apply_block(next_block);
+
                 /// modify current witness so transaction evaluators can know who included the transaction,
                 /// this is mostly for POW operations which must pay the current_witness
                 modify(gprops, [&](dynamic_global_property_object &dgp) {
@@ -3191,58 +3459,64 @@ namespace graphene { namespace chain {
                         ("witness", witness)("next_block.witness", next_block.witness)("hardfork_state", hardfork_state)
                 );
 
-                for (const auto &trx : next_block.transactions) {
-                    /* We do not need to push the undo state for each transaction
-                     * because they either all apply and are valid or the
-                     * entire block fails to apply.  We only need an "undo" state
-                     * for transactions when validating broadcast transactions or
-                     * when building a block.
-                     */
-                    apply_transaction(trx, skip);
-                    ++_current_trx_in_block;
+                {
+                    static const auto transactions_key = block_timing::key("phase.apply_transactions");
+                    block_timing::scope transactions_scope(_block_timing, transactions_key);
+
+                    for (const auto &trx : next_block.transactions) {
+                        /* We do not need to push the undo state for each transaction
+                         * because they either all apply and are valid or the
+                         * entire block fails to apply.  We only need an "undo" state
+                         * for transactions when validating broadcast transactions or
+                         * when building a block.
+                         */
+                        apply_transaction(trx, skip);
+                        ++_current_trx_in_block;
+                    }
                 }
 
                 _current_trx_in_block = -1;
                 _current_op_in_trx = 0;
                 _current_virtual_op = 0;
 
-                update_global_dynamic_data(next_block, skip);
-                update_signing_witness(signing_witness, next_block);
+                CHAIN_TIMED_PHASE(update_global_dynamic_data, update_global_dynamic_data(next_block, skip))
+                CHAIN_TIMED_PHASE(update_signing_witness, update_signing_witness(*signing_witness, next_block))
 
-                update_last_irreversible_block(skip);
+                CHAIN_TIMED_PHASE(update_last_irreversible_block, update_last_irreversible_block(skip))
 
-                create_block_summary(next_block);
-                clear_expired_proposals();
-                clear_expired_transactions();
-                clear_expired_delegations();
+                CHAIN_TIMED_PHASE(create_block_summary, create_block_summary(next_block))
+                CHAIN_TIMED_PHASE(clear_expired_proposals, clear_expired_proposals())
+                CHAIN_TIMED_PHASE(clear_expired_transactions, clear_expired_transactions())
+                CHAIN_TIMED_PHASE(clear_expired_delegations, clear_expired_delegations())
                 if(has_hardfork(CHAIN_HARDFORK_9)){
-                    clear_used_invites();
-                    clear_closed_committee_requests();
+                    CHAIN_TIMED_PHASE(clear_used_invites, clear_used_invites())
+                    CHAIN_TIMED_PHASE(clear_closed_committee_requests, clear_closed_committee_requests())
                 }
-                update_bandwidth_reserve_candidates();
-                update_witness_schedule();
+                CHAIN_TIMED_PHASE(update_bandwidth_reserve_candidates, update_bandwidth_reserve_candidates())
+                CHAIN_TIMED_PHASE(update_witness_schedule, update_witness_schedule())
 
                 if(has_hardfork(CHAIN_HARDFORK_4)){
-                    process_inflation_recalc();
-                    expire_award_shares_processing();
+                    CHAIN_TIMED_PHASE(process_inflation_recalc, process_inflation_recalc())
+                    CHAIN_TIMED_PHASE(expire_award_shares_processing, expire_award_shares_processing())
                 }
-                process_funds();
-                process_content_cashout();
-                process_vesting_withdrawals();
+                CHAIN_TIMED_PHASE(process_funds, process_funds())
+                CHAIN_TIMED_PHASE(process_content_cashout, process_content_cashout())
+                CHAIN_TIMED_PHASE(process_vesting_withdrawals, process_vesting_withdrawals())
 
-                account_recovery_processing();
-                expire_escrow_ratification();
+                CHAIN_TIMED_PHASE(account_recovery_processing, account_recovery_processing())
+                CHAIN_TIMED_PHASE(expire_escrow_ratification, expire_escrow_ratification())
 
-                clear_null_account_balance();
-                clear_anonymous_account_balance();
-                claim_committee_account_balance();
+                CHAIN_TIMED_PHASE(clear_null_account_balance, clear_null_account_balance())
+                CHAIN_TIMED_PHASE(clear_anonymous_account_balance, clear_anonymous_account_balance())
+                CHAIN_TIMED_PHASE(claim_committee_account_balance, claim_committee_account_balance())
 
-                committee_processing();
-                paid_subscribe_processing();
-                process_hardforks();
+                CHAIN_TIMED_PHASE(committee_processing, committee_processing())
+                CHAIN_TIMED_PHASE(paid_subscribe_processing, paid_subscribe_processing())
+                CHAIN_TIMED_PHASE(process_hardforks, process_hardforks())
 
-                // notify observers that the block has been applied
-                notify_applied_block(next_block);
+                // notify observers that the block has been applied,
+                // handlers of plugins are measured separately via timed_handler()
+                CHAIN_TIMED_PHASE(notify_applied_block, notify_applied_block(next_block))
 
                 notify_changed_objects();
             } FC_CAPTURE_LOG_AND_RETHROW((next_block.block_num()))
@@ -3301,11 +3575,11 @@ namespace graphene { namespace chain {
 
         void database::_apply_transaction(const signed_transaction &trx, uint32_t skip) {
             try {
-                _current_trx_id = trx.id();
+                auto trx_id = get_transaction_id(trx);
+                _current_trx_id = trx_id;
                 _current_virtual_op = 0;
 
                 auto &trx_idx = get_index<transaction_index>();
-                auto trx_id = trx.id();
                 // idump((trx_id)(skip&skip_transaction_dupe_check));
                 FC_ASSERT((skip & skip_transaction_dupe_check) ||
                           trx_idx.indices().get<by_trx_id>().find(trx_id) == trx_idx.indices().get<by_trx_id>().end(),
@@ -3362,7 +3636,11 @@ namespace graphene { namespace chain {
                 note.virtual_op = _current_virtual_op;
             }
             notify_pre_apply_operation(note);
-            _my->_evaluator_registry.get_evaluator(op).apply(op);
+            {
+                // handlers of plugins are measured separately via timed_handler()
+                block_timing::scope scope(_block_timing, op.visit(operation_timing_key_visitor()));
+                _my->_evaluator_registry.get_evaluator(op).apply(op);
+            }
             notify_post_apply_operation(note);
         }
 
@@ -3396,7 +3674,7 @@ namespace graphene { namespace chain {
             try {
                 block_summary_id_type sid(next_block.block_num() & 0xffff);
                 modify(get<block_summary_object>(sid), [&](block_summary_object &p) {
-                    p.block_id = next_block.id();
+                    p.block_id = get_block_id(next_block);
                 });
             } FC_CAPTURE_AND_RETHROW()
         }
@@ -3457,7 +3735,7 @@ namespace graphene { namespace chain {
                     }
 
                     dgp.head_block_number = b.block_num();
-                    dgp.head_block_id = b.id();
+                    dgp.head_block_id = get_block_id(b);
                     dgp.time = b.timestamp;
                     dgp.current_aslot += missed_blocks + 1;
                     dgp.average_block_size =
@@ -3576,12 +3854,7 @@ namespace graphene { namespace chain {
 
                 if (!(skip & skip_block_log)) {
                     // output to block log based on new last irreverisible block num
-                    const auto &tmp_head = _block_log.head();
-                    uint64_t log_head_num = 0;
-
-                    if (tmp_head) {
-                        log_head_num = tmp_head->block_num();
-                    }
+                    uint64_t log_head_num = _block_log.head_block_num();
 
                     if (log_head_num < dpo.last_irreversible_block_num) {
                         while (log_head_num < dpo.last_irreversible_block_num) {
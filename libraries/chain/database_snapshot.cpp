@@ -0,0 +1,190 @@
+#include <graphene/chain/snapshot.hpp>
+#include <graphene/chain/database_exceptions.hpp>
+
+#include <fc/io/json.hpp>
+
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace graphene { namespace chain {
+
+        namespace detail {
+            void sync_file(const fc::path &path) {
+#ifdef _WIN32
+                // directories can't be flushed on Windows, NTFS journals renames itself
+                if (fc::is_directory(path)) {
+                    return;
+                }
+                HANDLE handle = ::CreateFileW(
+                    path.wstring().c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+                if (handle != INVALID_HANDLE_VALUE) {
+                    ::FlushFileBuffers(handle);
+                    ::CloseHandle(handle);
+                }
+#else
+                int fd = ::open(path.string().c_str(), O_RDONLY);
+                if (fd >= 0) {
+                    ::fsync(fd);
+                    ::close(fd);
+                }
+#endif
+            }
+        }
+
+        namespace {
+            /**
+             * Runs the task for indexes 0..count-1 on the threads, the first exception is rethrown
+             */
+            template<typename Task>
+            void run_parallel(std::size_t count, uint32_t threads, Task&& task) {
+                std::atomic<std::size_t> next{0};
+                std::vector<std::exception_ptr> errors(threads);
+                std::vector<std::thread> workers;
+
+                for (uint32_t t = 0; t < threads && t < count; ++t) {
+                    workers.emplace_back([&, t]() {
+                        try {
+                            for (auto i = next++; i < count; i = next++) {
+                                task(i);
+                            }
+                        } catch (...) {
+                            errors[t] = std::current_exception();
+                            next = count;
+                        }
+                    });
+                }
+
+                for (auto& worker: workers) {
+                    worker.join();
+                }
+
+                for (auto& error: errors) {
+                    if (error) {
+                        std::rethrow_exception(error);
+                    }
+                }
+            }
+        }
+
+        void database::add_snapshot_index(std::unique_ptr<snapshot_index_base> index) {
+            _snapshot_indexes.push_back(std::move(index));
+        }
+
+        void database::set_load_snapshot_dir(const fc::path &dir) {
+            _load_snapshot_dir = dir;
+        }
+
+        void database::set_snapshot_threads(uint32_t value) {
+            _snapshot_threads = std::max<uint32_t>(value, 1);
+        }
+
+        void database::save_snapshot(const fc::path &dir) {
+            with_strong_read_lock([&]() {
+                write_snapshot(dir);
+            });
+        }
+
+        void database::write_snapshot(const fc::path &dir) {
+            try {
+                auto start = fc::time_point::now();
+
+                fc::create_directories(dir);
+                fc::remove_all(dir / "snapshot.json");
+                fc::remove_all(dir / "manifest.tmp");
+
+                snapshot_manifest manifest;
+                manifest.chain_id = CHAIN_ID;
+                manifest.indexes.resize(_snapshot_indexes.size());
+
+                manifest.block_num = head_block_num();
+                manifest.block_id = head_block_id();
+
+                ilog("Writing snapshot at block ${n} to ${d} on ${t} threads",
+                     ("n", manifest.block_num)("d", dir.string())("t", _snapshot_threads));
+
+                run_parallel(_snapshot_indexes.size(), _snapshot_threads, [&](std::size_t i) {
+                    const auto &index = _snapshot_indexes[i];
+                    manifest.indexes[i] = index->write(*this, dir / (std::to_string(i) + ".bin"));
+                    ilog("Snapshot of ${n} is written: ${c} objects",
+                         ("n", manifest.indexes[i].name)("c", manifest.indexes[i].object_count));
+                });
+
+                // the manifest is written last, so a directory without it is an incomplete snapshot,
+                // files of indexes are synced before it, and it is renamed into place after its own sync
+                const auto tmp_manifest_file = dir / "manifest.tmp";
+                fc::json::save_to_file(manifest, tmp_manifest_file);
+                detail::sync_file(tmp_manifest_file);
+                fc::rename(tmp_manifest_file, dir / "snapshot.json");
+                detail::sync_file(dir);
+
+                auto end = fc::time_point::now();
+                ilog("Snapshot is written, elapsed time ${t} sec", ("t", double((end - start).count()) / 1000000.0));
+            }
+            FC_CAPTURE_AND_RETHROW((dir))
+        }
+
+        void database::load_snapshot(const fc::path &dir) {
+            try {
+                auto start = fc::time_point::now();
+
+                const auto manifest_file = dir / "snapshot.json";
+                CHAIN_ASSERT(fc::exists(manifest_file), snapshot_exception,
+                    "Snapshot ${d} has no manifest", ("d", dir.string()));
+
+                auto manifest = fc::json::from_file(manifest_file).as<snapshot_manifest>();
+                CHAIN_ASSERT(manifest.version == snapshot_manifest::current_version, snapshot_exception,
+                    "Unsupported version ${v} of snapshot", ("v", manifest.version));
+                CHAIN_ASSERT(manifest.chain_id == CHAIN_ID, snapshot_exception,
+                    "Snapshot belongs to other chain ${c}", ("c", manifest.chain_id));
+
+                std::vector<const snapshot_index_info *> infos(_snapshot_indexes.size());
+                for (std::size_t i = 0; i < _snapshot_indexes.size(); ++i) {
+                    const auto name = _snapshot_indexes[i]->name();
+                    for (const auto &info: manifest.indexes) {
+                        if (info.name == name) {
+                            infos[i] = &info;
+                            break;
+                        }
+                    }
+                    CHAIN_ASSERT(infos[i], snapshot_exception,
+                        "Snapshot doesn't contain index ${n}", ("n", name));
+                }
+
+                for (const auto &info: manifest.indexes) {
+                    if (std::find(infos.begin(), infos.end(), &info) == infos.end()) {
+                        wlog("Index ${n} of snapshot isn't used by the node, it is skipped", ("n", info.name));
+                    }
+                }
+
+                ilog("Loading snapshot at block ${n} from ${d} on ${t} threads",
+                     ("n", manifest.block_num)("d", dir.string())("t", _snapshot_threads));
+
+                std::mutex create_mutex;
+                run_parallel(_snapshot_indexes.size(), _snapshot_threads, [&](std::size_t i) {
+                    _snapshot_indexes[i]->read(*this, dir / infos[i]->file, *infos[i], create_mutex);
+                    ilog("Snapshot of ${n} is loaded: ${c} objects", ("n", infos[i]->name)("c", infos[i]->object_count));
+                });
+
+                CHAIN_ASSERT(
+                    head_block_num() == manifest.block_num && head_block_id() == manifest.block_id,
+                    snapshot_exception, "Head block of loaded state doesn't match snapshot");
+
+                set_revision(head_block_num());
+
+                auto end = fc::time_point::now();
+                ilog("Snapshot is loaded, elapsed time ${t} sec", ("t", double((end - start).count()) / 1000000.0));
+            }
+            FC_CAPTURE_AND_RETHROW((dir))
+        }
+
+} } // graphene::chain
@@ -31,17 +31,58 @@ namespace graphene {
          * Blocks can be accessed at random via block number through the index file. Seek to 8 * (block_num - 1)
          * to find the position of the block in the main file.
          *
-         * The main file is the only file that needs to persist. The index file can be reconstructed during a
-         * linear scan of the main file.
+         * The main file is the only file that needs to persist. The index file can be reconstructed by
+         * following the back-pointers from the end of the main file, blocks are not unpacked for it.
+         *
+         * Version 2 of the block log starts with a header which describes the compression of blocks and
+         * the step of the index. The header is followed by a trained compression dictionary (it can be empty).
+         * Each block is stored as a record which can be skipped without decompression:
+         *
+         * +--------+------------+-------------+----------+---------+---------------+-----+
+         * | Header | Dictionary | Packed size | Raw size | Block 1 | Pos of record | ... |
+         * +--------+------------+-------------+----------+---------+---------------+-----+
+         *
+         * The index of version 2 is sparse: it contains positions of blocks 1, 1 + step, 1 + 2 * step ...
+         * To find a block, the position of the first block of its chunk is taken from the index and
+         * the records before the block are skipped by their sizes, only the requested block is decompressed.
+         *
+         * A log without the header is the legacy version 1, it is read and appended in the old format.
+         *
+         * Both files grow by preallocated extents, so appending of a block doesn't remap the files.
+         * The end of data is tracked separately from the size of the files, the preallocated tails are
+         * truncated on closing. After a crash the tails are filled by zeros, they are detected and truncated
+         * on opening: the last block is found by walking forward from the last nonzero index entry.
+         *
+         * Readers don't take locks. The appender publishes an immutable state (mappings, end of data, head)
+         * after each block, readers pin the current state via epoch based reclamation. When an extent
+         * is exhausted, the grown file is mapped again, and the old mapping lives until its last reader leaves.
          */
 
+        enum class block_log_compression : uint32_t {
+            none = 0,
+            zstd = 1
+        };
+
+        struct block_log_options {
+            /// format of a new block log, existing logs keep their format
+            uint32_t version = 1;
+            block_log_compression compression = block_log_compression::none;
+            int32_t compression_level = 3;
+            /// the index contains position of each N-th block (only for version 2)
+            uint32_t index_step = 1;
+            /// size of the dictionary which is trained on converting of the block log, 0 - don't use dictionary
+            uint32_t dictionary_size = 0;
+            /// files grow by extents of this size, 0 - grow by each appended block
+            uint64_t extent_size = 64 * 1024 * 1024;
+        };
+
         class block_log {
         public:
             block_log();
 
             ~block_log();
 
-            void open(const fc::path& file);
+            void open(const fc::path& file, const block_log_options& options = block_log_options());
 
             void close();
 
@@ -49,6 +90,11 @@ namespace graphene {
 
             uint64_t append(const signed_block& b);
 
+            /**
+             * Does nothing: appended blocks are written to shared mappings of the files, so they are
+             * in the page cache at once and survive a crash of the process, the OS writes them to disk.
+             * A crash of the OS can lose the tail, it is detected and truncated on opening.
+             */
             void flush();
 
             std::pair<signed_block, uint64_t> read_block(uint64_t file_pos) const;
@@ -62,10 +108,37 @@ namespace graphene {
 
             signed_block read_head() const;
 
-            const optional <signed_block>& head() const;
+            optional <signed_block> head() const;
+
+            /// number of the head block without copying of it, 0 if the log is empty
+            uint32_t head_block_num() const;
+
+            /// version of the opened block log
+            uint32_t version() const;
+
+            /// compression of the opened block log
+            block_log_compression compression() const;
+
+            /// step of the index of the opened block log
+            uint32_t index_step() const;
 
             static const uint64_t npos = std::numeric_limits<uint64_t>::max();
 
+            /**
+             * Check numbers, links to previous blocks and merkle roots of all blocks in the log.
+             * The log is splitted into ranges which are checked in parallel, throws on a broken block.
+             */
+            void verify(uint32_t threads) const;
+
+            /**
+             * Rewrite the block log to the format described by options (version 2 or back to version 1),
+             * the result replaces the original files.
+             * If the compression dictionary is requested, it is trained on a sample of blocks of the original log.
+             * An empty log or a log which already has the requested version, compression and index step
+             * is left as is.
+             */
+            static void convert(const fc::path& file, const block_log_options& options);
+
         private:
             std::unique_ptr<detail::block_log_impl> my;
         };
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <fc/reflect/reflect.hpp>
+#include <fc/time.hpp>
+
+#include <array>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace graphene { namespace chain {
+
+        /**
+         * Histogram of durations in microseconds with log-linear buckets (HDR style).
+         * Values below 8 have own buckets, each next power of two is split into 8 sub-buckets,
+         * so the error of percentiles is below 12.5% in the whole range.
+         */
+        class latency_histogram final {
+        public:
+            static constexpr uint32_t sub_bucket_bits = 3;
+            static constexpr uint32_t sub_buckets = 1 << sub_bucket_bits;
+            static constexpr uint32_t bucket_count = (32 - sub_bucket_bits + 1) * sub_buckets;
+
+            void record(uint64_t value);
+
+            void merge(const latency_histogram& other);
+
+            void reset();
+
+            uint64_t count() const {
+                return _count;
+            }
+
+            uint64_t sum() const {
+                return _sum;
+            }
+
+            uint64_t max() const {
+                return _max;
+            }
+
+            /// upper bound of the bucket which contains the percentile p (0..100)
+            uint64_t percentile(double p) const;
+
+        private:
+            static uint32_t bucket_index(uint64_t value);
+
+            static uint64_t bucket_upper_bound(uint32_t index);
+
+            std::array<uint64_t, bucket_count> _buckets = {};
+            uint64_t _count = 0;
+            uint64_t _sum = 0;
+            uint64_t _max = 0;
+        };
+
+        struct block_timing_stat {
+            std::string name;
+            uint64_t count = 0;
+            uint64_t total_us = 0;
+            uint64_t max_us = 0;
+            uint64_t p50_us = 0;
+            uint64_t p90_us = 0;
+            uint64_t p99_us = 0;
+        };
+
+        struct block_timing_report {
+            bool enabled = false;
+            uint32_t head_block_num = 0;
+            /// number of blocks in the rolling window
+            uint32_t blocks = 0;
+            /// sorted by the total time
+            std::vector<block_timing_stat> stats;
+        };
+
+        /**
+         * Time spent on applying of blocks: the whole block ("block"), maintenance phases of _apply_block
+         * ("phase.*"), evaluators of operations ("operation.*") and signal handlers of plugins ("plugin.*").
+         *
+         * Durations of a block are collected without locks and merged into the rolling window
+         * on end_block(). The window consists of several slots, the oldest slot is dropped when
+         * the current one is full, so the report covers the last window..window * (1 + 1 / slots) blocks.
+         */
+        class block_timing final {
+        public:
+            using key_type = uint32_t;
+
+            static constexpr uint32_t slot_count = 4;
+
+            /// id of the measured item by its name, ids are shared by all instances
+            static key_type key(const std::string& name);
+
+            static std::string key_name(key_type key);
+
+            class scope final {
+            public:
+                scope(block_timing& timing, key_type key)
+                    : _timing(timing.enabled() ? &timing : nullptr), _key(key) {
+                    if (_timing) {
+                        _start = fc::time_point::now();
+                    }
+                }
+
+                ~scope() {
+                    if (_timing) {
+                        _timing->record(_key, (fc::time_point::now() - _start).count());
+                    }
+                }
+
+                scope(const scope&) = delete;
+                scope& operator=(const scope&) = delete;
+
+            private:
+                block_timing* _timing;
+                key_type _key;
+                fc::time_point _start;
+            };
+
+            bool enabled() const {
+                return _enabled;
+            }
+
+            void set_enabled(bool value);
+
+            /// size of the rolling window in blocks
+            void set_window(uint32_t blocks);
+
+            /// the summary of the window is logged every N blocks, 0 disables it
+            void set_log_interval(uint32_t blocks);
+
+            /// blocks applied slower than the budget are logged with their slowest items, 0 disables it
+            void set_budget(fc::microseconds value);
+
+            void begin_block();
+
+            void record(key_type key, int64_t micros) {
+                _pending.emplace_back(key, static_cast<uint64_t>(micros > 0 ? micros : 0));
+            }
+
+            /// the block was applied successfully, its durations are added to the window
+            void end_block(uint32_t block_num, int64_t block_micros);
+
+            block_timing_report report() const;
+
+        private:
+            struct slot {
+                uint32_t blocks = 0;
+                std::vector<latency_histogram> histograms;
+            };
+
+            void log_budget_exceeded(uint32_t block_num, int64_t block_micros) const;
+
+            void log_summary() const;
+
+            bool _enabled = false;
+            uint32_t _window = 1200;
+            uint32_t _log_interval = 0;
+            fc::microseconds _budget;
+
+            std::vector<std::pair<key_type, uint64_t>> _pending;
+
+            mutable std::mutex _mutex;
+            std::array<slot, slot_count> _slots;
+            uint32_t _current_slot = 0;
+            uint32_t _head_block_num = 0;
+        };
+
+} } // graphene::chain
+
+FC_REFLECT((graphene::chain::block_timing_stat), (name)(count)(total_us)(max_us)(p50_us)(p90_us)(p99_us))
+FC_REFLECT((graphene::chain::block_timing_report), (enabled)(head_block_num)(blocks)(stats))
@@ -176,6 +176,26 @@ namespace fc {
         }
     }
 
+    namespace raw {
+        template<typename Stream>
+        inline void pack(Stream &s, const graphene::chain::shared_string &str) {
+            pack(s, unsigned_int(static_cast<uint32_t>(str.size())));
+            if (str.size()) {
+                s.write(str.data(), str.size());
+            }
+        }
+
+        template<typename Stream>
+        inline void unpack(Stream &s, graphene::chain::shared_string &str, uint32_t = 0) {
+            unsigned_int size;
+            unpack(s, size);
+            str.resize(size.value);
+            if (size.value) {
+                s.read(&str[0], size.value);
+            }
+        }
+    }
+
     namespace raw {
         using chainbase::allocator;
 
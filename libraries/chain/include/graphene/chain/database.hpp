@@ -4,6 +4,7 @@
 #include <graphene/chain/node_property_object.hpp>
 #include <graphene/chain/fork_database.hpp>
 #include <graphene/chain/block_log.hpp>
+#include <graphene/chain/block_timing.hpp>
 #include <graphene/chain/hardfork.hpp>
 #include <graphene/protocol/protocol.hpp>
 
@@ -11,6 +12,7 @@
 
 #include <fc/log/logger.hpp>
 
+#include <atomic>
 #include <map>
 
 namespace graphene { namespace chain {
@@ -28,6 +30,10 @@ namespace graphene { namespace chain {
 
         struct operation_notification;
 
+        struct decoded_block;
+
+        class snapshot_index_base;
+
         /**
          *   @class database
          *   @brief tracks the blockchain state in an extensible manner
@@ -93,10 +99,44 @@ namespace graphene { namespace chain {
             void set_min_free_shared_memory_size(size_t);
             void set_inc_shared_memory_size(size_t);
             void set_block_num_check_free_size(uint32_t);
-            void check_free_memory(bool skip_print, uint32_t current_block_num);
+            void set_replay_decode_threads(uint32_t);
+            void set_block_log_options(const block_log_options&);
+
+            /**
+             * During replay the state is flushed and marked as consistent every N blocks (0 disables checkpoints).
+             * The interrupted replay continues from the last checkpoint instead of the first block.
+             */
+            void set_replay_checkpoint_interval(uint32_t);
+
+            /// Every N replayed blocks (multiple of checkpoint interval) the snapshot is saved to recover after crash
+            void set_replay_snapshot_interval(uint32_t);
+
+            /// @return true if the shared memory was resized
+            bool check_free_memory(bool skip_print, uint32_t current_block_num);
 
             void set_skip_virtual_ops();
 
+            /**
+             * Write the state at the head block to the snapshot directory,
+             * files of indexes are written in parallel by the snapshot threads
+             */
+            void save_snapshot(const fc::path &dir);
+
+            /**
+             * The next open() wipes the shared memory and loads the state from the snapshot directory
+             * instead of the genesis. The block log should contain the head block of the snapshot.
+             */
+            void set_load_snapshot_dir(const fc::path &dir);
+
+            void set_snapshot_threads(uint32_t);
+
+            /// Register index for snapshots, it is called for each index added by add_core_index or add_plugin_index
+            void add_snapshot_index(std::unique_ptr<snapshot_index_base> index);
+
+            const std::vector<std::unique_ptr<snapshot_index_base>> &snapshot_indexes() const {
+                return _snapshot_indexes;
+            }
+
             /**
              * @brief wipe Delete database from disk, and potentially the raw chain as well.
              * @param include_blocks If true, delete the raw chain as well as the database.
@@ -239,6 +279,8 @@ namespace graphene { namespace chain {
             void notify_post_apply_operation(const operation_notification &note);
 
             inline const void push_virtual_operation(const operation &op, bool force = false); // vops are not needed for low mem. Force will push them on low mem.
+            void notify_pre_apply_block(const signed_block &block);
+
             void notify_applied_block(const signed_block &block);
 
             void notify_on_pending_transaction(const signed_transaction &tx);
@@ -261,6 +303,12 @@ namespace graphene { namespace chain {
              */
             fc::signal<void(const signed_block &)> applied_block;
 
+            /**
+             *  This signal is emitted before operations of a block are applied. The block can fail
+             *  after it, then it is undone and applied_block isn't emitted.
+             */
+            fc::signal<void(const signed_block &)> pre_apply_block;
+
             /**
              * This signal is emitted any time a new transaction is added to the pending
              * block state.
@@ -284,6 +332,53 @@ namespace graphene { namespace chain {
              */
             //fc::signal<void(const vector<const object*>&)>  removed_objects;
 
+            /**
+             * Wrap the handler of a signal to measure its time as "plugin.<name>" in the block timing:
+             *
+             *   db.post_apply_operation.connect(db.timed_handler("tags.post_apply_operation", [&](...) {...}));
+             */
+            template<typename Handler>
+            auto timed_handler(const std::string &name, Handler handler) {
+                const auto key = block_timing::key("plugin." + name);
+                return [this, key, handler](auto &&... args) {
+                    block_timing::scope scope(_block_timing, key);
+                    handler(std::forward<decltype(args)>(args)...);
+                };
+            }
+
+            /**
+             * The same as chainbase::database::with_weak_read_lock(), but the time of waiting for the lock
+             * is added to read_lock_wait_micros() of the current thread, if it is enabled
+             */
+            template<typename Lambda>
+            decltype(auto) with_weak_read_lock(Lambda &&callback) {
+                if (!_is_read_lock_wait_measured.load(std::memory_order_relaxed)) {
+                    return chainbase::database::with_weak_read_lock(std::forward<Lambda>(callback));
+                }
+                const auto start = fc::time_point::now();
+                return chainbase::database::with_weak_read_lock([&]() -> decltype(auto) {
+                    read_lock_wait_micros() += (fc::time_point::now() - start).count();
+                    return callback();
+                });
+            }
+
+            template<typename Lambda>
+            decltype(auto) with_weak_read_lock(Lambda &&callback) const {
+                if (!_is_read_lock_wait_measured.load(std::memory_order_relaxed)) {
+                    return chainbase::database::with_weak_read_lock(std::forward<Lambda>(callback));
+                }
+                const auto start = fc::time_point::now();
+                return chainbase::database::with_weak_read_lock([&]() -> decltype(auto) {
+                    read_lock_wait_micros() += (fc::time_point::now() - start).count();
+                    return callback();
+                });
+            }
+
+            static void set_read_lock_wait_measured(bool value);
+
+            /// total time which the current thread has spent waiting for weak read locks
+            static uint64_t &read_lock_wait_micros();
+
             //////////////////// db_witness_schedule.cpp ////////////////////
 
             /**
@@ -439,6 +534,10 @@ namespace graphene { namespace chain {
 
             const block_log &get_block_log() const;
 
+            block_timing &get_block_timing();
+
+            const block_timing &get_block_timing() const;
+
         protected:
             //Mark pop_undo() as protected -- we do not want outside calling pop_undo(); it should call pop_block() instead
             //void pop_undo() { object_database::pop_undo(); }
@@ -455,6 +554,10 @@ namespace graphene { namespace chain {
 
             void _apply_block(const signed_block &next_block, uint32_t skip);
 
+            block_id_type get_block_id(const signed_block &b) const;
+
+            transaction_id_type get_transaction_id(const signed_transaction &trx) const;
+
             void _apply_transaction(const signed_transaction &trx, uint32_t skip);
 
             void _validate_transaction(const signed_transaction& trx, uint32_t skip);
@@ -500,6 +603,13 @@ namespace graphene { namespace chain {
 
             bool _resize(uint32_t block_num);
 
+            void load_snapshot(const fc::path &dir);
+
+            /// save_snapshot() without the lock, the caller holds it
+            void write_snapshot(const fc::path &dir);
+
+            void write_replay_checkpoint(const fc::path &shared_mem_dir, bool is_clean);
+
             ///@}
 
             std::unique_ptr<database_impl> _my;
@@ -509,6 +619,11 @@ namespace graphene { namespace chain {
             protocol::hardfork_version _hardfork_versions[CHAIN_NUM_HARDFORKS + 1];
 
             block_log _block_log;
+            block_log_options _block_log_options;
+
+            block_timing _block_timing;
+
+            static std::atomic<bool> _is_read_lock_wait_measured;
 
             // this function needs access to _plugin_index_signal
             template<typename MultiIndexType>
@@ -534,6 +649,18 @@ namespace graphene { namespace chain {
 
             uint32_t _block_num_check_free_memory = 1000;
 
+            uint32_t _replay_decode_threads = 0;
+
+            uint32_t _replay_checkpoint_interval = 0;
+            uint32_t _replay_snapshot_interval = 0;
+
+            std::vector<std::unique_ptr<snapshot_index_base>> _snapshot_indexes;
+            fc::path _load_snapshot_dir;
+            uint32_t _snapshot_threads = 1;
+
+            /// block of replay with ids which are calculated by decoder threads
+            const decoded_block* _replay_block = nullptr;
+
             bool _skip_virtual_ops = false;
             bool _enable_plugins_on_push_transaction = false;
 
@@ -114,6 +114,8 @@ namespace graphene {
         FC_DECLARE_DERIVED_EXCEPTION(database_revision_exception, graphene::chain::chain_exception, 4120000, "database revision exception")
 
         FC_DECLARE_DERIVED_EXCEPTION(database_signal_exception, graphene::chain::chain_exception, 4130000, "database signal exception")
+
+        FC_DECLARE_DERIVED_EXCEPTION(snapshot_exception, graphene::chain::chain_exception, 4140000, "snapshot exception")
     }
 } // graphene::chain
 
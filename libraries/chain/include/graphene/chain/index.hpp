@@ -1,6 +1,7 @@
 #pragma once
 
 #include <graphene/chain/database.hpp>
+#include <graphene/chain/snapshot.hpp>
 
 namespace graphene {
     namespace chain {
@@ -8,6 +9,7 @@ namespace graphene {
         template<typename MultiIndexType>
         void _add_index_impl(database &db) {
             db.add_index<MultiIndexType>();
+            db.add_snapshot_index(std::make_unique<snapshot_index<MultiIndexType>>());
         }
 
         template<typename MultiIndexType>
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <graphene/chain/block_log.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace graphene { namespace chain {
+
+        /**
+         * Block read from the block log together with the hashes which are needed on applying of it.
+         * The ids are calculated on a decoder thread, so the apply thread doesn't spend time on sha hashing.
+         */
+        struct decoded_block {
+            uint32_t block_num = 0;
+            uint64_t block_pos = 0;
+            signed_block block;
+            block_id_type block_id;
+            std::vector<transaction_id_type> trx_ids;
+        };
+
+        /**
+         * Prefetches blocks from the block log on the decoder threads ahead of the replay.
+         *
+         * Blocks are placed into the bounded ring of slots, the slot of block N is N % ring size.
+         * Decoder thread I handles the blocks I, I + threads, I + 2 * threads and so on,
+         * so the threads don't compete for the work. The single consumer takes blocks in order
+         * via next() and frees the slot via release().
+         *
+         * If there are no decoder threads, next() reads the block in the caller thread.
+         */
+        class replay_pipeline final {
+        public:
+            replay_pipeline(
+                const block_log& log, uint32_t from_block_num, uint32_t last_block_num,
+                uint32_t decode_threads, uint32_t ring_size);
+
+            ~replay_pipeline();
+
+            /**
+             * Wait for the next block in order, rethrows an exception of the decoder thread
+             */
+            const decoded_block& next();
+
+            /**
+             * Release the block returned by the last call of next()
+             */
+            void release();
+
+            void stop();
+
+            /// total time of reading and decoding of blocks summed over all decoder threads
+            uint64_t decode_micro() const {
+                return _decode_micro.load(std::memory_order_relaxed);
+            }
+
+            /// time which the consumer spent waiting for the decoder threads
+            uint64_t wait_micro() const {
+                return _wait_micro;
+            }
+
+            uint32_t decode_threads() const {
+                return static_cast<uint32_t>(_threads.size());
+            }
+
+        private:
+            struct slot {
+                bool ready = false;
+                decoded_block data;
+                std::exception_ptr error;
+            };
+
+            void decode(uint32_t block_num, decoded_block& result);
+
+            void decode_loop(uint32_t first_block_num, uint32_t step);
+
+            const block_log& _log;
+            const uint32_t _from_block_num;
+            const uint32_t _last_block_num;
+
+            std::vector<slot> _ring;
+            std::vector<std::thread> _threads;
+
+            std::mutex _mutex;
+            std::condition_variable _ready_cond;
+            std::condition_variable _free_cond;
+
+            uint32_t _next_block_num;
+            bool _is_stopped = false;
+
+            std::atomic<uint64_t> _decode_micro{0};
+            uint64_t _wait_micro = 0;
+        };
+
+} } // graphene::chain
@@ -0,0 +1,271 @@
+#pragma once
+
+#include <graphene/chain/database.hpp>
+
+#include <fc/crypto/sha256.hpp>
+#include <fc/filesystem.hpp>
+#include <fc/io/raw.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace graphene { namespace chain {
+
+        using graphene::protocol::chain_id_type;
+
+        /**
+         * Description of one index in the snapshot
+         */
+        struct snapshot_index_info {
+            std::string name;
+            std::string file;
+            uint64_t object_count = 0;
+            int64_t next_id = 0; /// the last id + 1, ids of objects removed after the last one can be reused after the load
+            fc::sha256 checksum;
+        };
+
+        /**
+         * The snapshot is a directory with the manifest (snapshot.json) and one file per index.
+         * The file of an index is a sequence of objects in order of their ids:
+         *
+         * +----+-------------+---------------------+----+-----+
+         * | Id | Packed size | Packed object (raw) | Id | ... |
+         * +----+-------------+---------------------+----+-----+
+         *
+         * The checksum of each file is kept in the manifest, files are written and read in parallel.
+         */
+        struct snapshot_manifest {
+            static constexpr uint32_t current_version = 1;
+
+            uint32_t version = current_version;
+            chain_id_type chain_id;
+            uint32_t block_num = 0;
+            block_id_type block_id;
+            std::vector<snapshot_index_info> indexes;
+        };
+
+        class snapshot_index_base {
+        public:
+            virtual ~snapshot_index_base() = default;
+
+            virtual std::string name() const = 0;
+
+            virtual snapshot_index_info write(const database& db, const fc::path& file) const = 0;
+
+            /**
+             * Called for the empty index, ids of objects and the next id are restored.
+             * Files are read in parallel, objects are created under the create_mutex,
+             * because chainbase doesn't support concurrent creation of objects.
+             */
+            virtual void read(database& db, const fc::path& file, const snapshot_index_info& info,
+                              std::mutex& create_mutex) const = 0;
+
+            /**
+             * Throws if the object type is larger than its reflected fields with the padding between them,
+             * so some field isn't reflected and would be lost by the snapshot
+             */
+            virtual void check_reflection() const = 0;
+        };
+
+        namespace detail {
+            /// flushes the file or the directory (with renames in it) to disk
+            void sync_file(const fc::path& path);
+
+            /**
+             * Sums sizes of reflected fields, the id is counted if it isn't reflected,
+             * because it is stored by the snapshot itself
+             */
+            class reflected_size_visitor final {
+            public:
+                template<typename Member, class Class, Member (Class::*member)>
+                void operator()(const char* name) const {
+                    size += sizeof(Member);
+                    align = std::max(align, alignof(Member));
+                    has_id = has_id || std::string(name) == "id";
+                    ++count;
+                }
+
+                mutable std::size_t size = 0;
+                mutable std::size_t align = 1;
+                mutable std::size_t count = 0;
+                mutable bool has_id = false;
+            };
+
+            class snapshot_writer final {
+            public:
+                explicit snapshot_writer(const fc::path& file)
+                    : _file(file),
+                      _stream(file.string(), std::ios::out | std::ios::binary | std::ios::trunc) {
+                    FC_ASSERT(_stream, "Can't create snapshot file ${f}", ("f", file.string()));
+                }
+
+                void write(const char* data, std::size_t size) {
+                    _stream.write(data, size);
+                    _encoder.write(data, size);
+                }
+
+                template<typename T>
+                void write_object(int64_t id, const T& object) {
+                    _buffer.resize(fc::raw::pack_size(object));
+                    fc::datastream<char*> ds(_buffer.data(), _buffer.size());
+                    fc::raw::pack(ds, object);
+
+                    const uint32_t size = static_cast<uint32_t>(_buffer.size());
+                    write(reinterpret_cast<const char*>(&id), sizeof(id));
+                    write(reinterpret_cast<const char*>(&size), sizeof(size));
+                    write(_buffer.data(), _buffer.size());
+                }
+
+                /// closes the file and syncs it to disk
+                fc::sha256 finish() {
+                    _stream.close();
+                    FC_ASSERT(_stream, "Can't write snapshot file ${f}", ("f", _file.string()));
+                    sync_file(_file);
+                    return _encoder.result();
+                }
+
+            private:
+                fc::path _file;
+                std::ofstream _stream;
+                fc::sha256::encoder _encoder;
+                std::vector<char> _buffer;
+            };
+
+            class snapshot_reader final {
+            public:
+                explicit snapshot_reader(const fc::path& file)
+                    : _stream(file.string(), std::ios::in | std::ios::binary) {
+                    FC_ASSERT(_stream, "Can't open snapshot file ${f}", ("f", file.string()));
+                }
+
+                void read(char* data, std::size_t size) {
+                    _stream.read(data, size);
+                    FC_ASSERT(_stream, "Snapshot file is truncated");
+                    _encoder.write(data, size);
+                }
+
+                /// reads the next packed object, returns its id
+                int64_t read_object(std::vector<char>& packed_object) {
+                    int64_t id;
+                    uint32_t size;
+                    read(reinterpret_cast<char*>(&id), sizeof(id));
+                    read(reinterpret_cast<char*>(&size), sizeof(size));
+                    packed_object.resize(size);
+                    read(packed_object.data(), packed_object.size());
+                    return id;
+                }
+
+                fc::sha256 finish() {
+                    FC_ASSERT(_stream.peek() == std::ifstream::traits_type::eof(), "Snapshot file has extra data");
+                    return _encoder.result();
+                }
+
+            private:
+                std::ifstream _stream;
+                fc::sha256::encoder _encoder;
+            };
+        }
+
+        template<typename MultiIndexType>
+        class snapshot_index final: public snapshot_index_base {
+        public:
+            using object_type = typename MultiIndexType::value_type;
+
+            std::string name() const override {
+                return fc::get_typename<object_type>::name();
+            }
+
+            snapshot_index_info write(const database& db, const fc::path& file) const override {
+                snapshot_index_info info;
+                info.name = name();
+                info.file = file.filename().string();
+
+                detail::snapshot_writer writer(file);
+                for (const auto& object: db.get_index<MultiIndexType>().indices()) {
+                    writer.write_object(object.id._id, object);
+                    ++info.object_count;
+                    // chainbase doesn't expose the next id of the index, objects are ordered by id
+                    info.next_id = object.id._id + 1;
+                }
+                info.checksum = writer.finish();
+                return info;
+            }
+
+            void read(database& db, const fc::path& file, const snapshot_index_info& info,
+                      std::mutex& create_mutex) const override {
+                detail::snapshot_reader reader(file);
+                std::vector<std::pair<int64_t, std::vector<char>>> batch(create_batch_size);
+                int64_t last_id = -1;
+                int64_t created_count = 0; // the index is empty, so it is the next id of chainbase
+
+                for (uint64_t read_count = 0; read_count < info.object_count;) {
+                    const uint64_t batch_size = std::min(info.object_count - read_count, uint64_t(create_batch_size));
+                    for (uint64_t i = 0; i < batch_size; ++i) {
+                        auto& item = batch[i];
+                        item.first = reader.read_object(item.second);
+                        FC_ASSERT(item.first > last_id && item.first < info.next_id,
+                            "Objects of ${n} aren't ordered by id", ("n", info.name));
+                        last_id = item.first;
+                    }
+                    read_count += batch_size;
+
+                    std::lock_guard<std::mutex> lock(create_mutex);
+                    for (uint64_t i = 0; i < batch_size; ++i) {
+                        const auto& item = batch[i];
+                        // chainbase assigns sequential ids and can't set the next one, so ids of removed
+                        // objects are taken by placeholders, which are removed at once
+                        while (created_count < item.first) {
+                            const auto& placeholder = create(db, item, created_count);
+                            db.remove(placeholder);
+                            ++created_count;
+                        }
+                        create(db, item, item.first);
+                        ++created_count;
+                    }
+                }
+
+                FC_ASSERT(reader.finish() == info.checksum, "Checksum of ${n} doesn't match", ("n", info.name));
+            }
+
+            void check_reflection() const override {
+                detail::reflected_size_visitor visitor;
+                fc::reflector<object_type>::visit(visitor);
+                if (!visitor.has_id) {
+                    visitor.size += sizeof(typename object_type::id_type);
+                    visitor.align = std::max(visitor.align, alignof(typename object_type::id_type));
+                    ++visitor.count;
+                }
+                // padding before each field, after the base object and at the end is less than the alignment
+                const auto max_size = visitor.size + (visitor.count + 2) * (visitor.align - 1);
+                FC_ASSERT(sizeof(object_type) <= max_size,
+                    "Object of ${n} has ${s} bytes, but its reflected fields can take only ${m} bytes",
+                    ("n", name())("s", sizeof(object_type))("m", max_size));
+            }
+
+        private:
+            /// number of objects read from the file before they are created under the lock
+            static constexpr uint64_t create_batch_size = 1024;
+
+            /// creates the object from the packed one, chainbase should assign the expected id to it
+            static const object_type& create(
+                    database& db, const std::pair<int64_t, std::vector<char>>& item, int64_t expected_id) {
+                return db.create<object_type>([&](object_type& o) {
+                    const auto id = o.id;
+                    FC_ASSERT(id._id == expected_id, "Object of ${n} gets id ${i} instead of ${e}",
+                        ("n", fc::get_typename<object_type>::name())("i", id._id)("e", expected_id));
+                    fc::datastream<const char*> ds(item.second.data(), item.second.size());
+                    fc::raw::unpack(ds, o);
+                    o.id = id;
+                });
+            }
+        };
+
+} } // graphene::chain
+
+FC_REFLECT((graphene::chain::snapshot_index_info), (name)(file)(object_count)(next_id)(checksum))
+FC_REFLECT((graphene::chain::snapshot_manifest), (version)(chain_id)(block_num)(block_id)(indexes))
@@ -0,0 +1,141 @@
+#include <graphene/chain/replay_pipeline.hpp>
+#include <graphene/chain/database_exceptions.hpp>
+
+#include <algorithm>
+
+namespace graphene { namespace chain {
+
+        replay_pipeline::replay_pipeline(
+            const block_log& log, uint32_t from_block_num, uint32_t last_block_num,
+            uint32_t decode_threads, uint32_t ring_size
+        ) : _log(log),
+            _from_block_num(from_block_num),
+            _last_block_num(last_block_num),
+            _next_block_num(from_block_num) {
+
+            if (from_block_num > last_block_num) {
+                decode_threads = 0;
+            } else {
+                decode_threads = std::min(decode_threads, last_block_num - from_block_num + 1);
+            }
+
+            // each thread should have at least two free slots to not wait for the consumer
+            _ring.resize(std::max<uint32_t>({ring_size, decode_threads * 2, 1}));
+
+            _threads.reserve(decode_threads);
+            for (uint32_t i = 0; i < decode_threads; ++i) {
+                _threads.emplace_back([this, i, decode_threads]() {
+                    decode_loop(_from_block_num + i, decode_threads);
+                });
+            }
+        }
+
+        replay_pipeline::~replay_pipeline() {
+            stop();
+        }
+
+        void replay_pipeline::decode(uint32_t block_num, decoded_block& result) {
+            auto start = fc::time_point::now();
+
+            auto block = _log.read_block_by_num(block_num);
+            CHAIN_ASSERT(block.valid(), block_log_exception,
+                "Block ${n} not found in block log.", ("n", block_num));
+
+            result.block_num = block_num;
+            result.block_pos = _log.get_block_pos(block_num);
+            result.block = std::move(*block);
+            result.block_id = result.block.id();
+
+            result.trx_ids.clear();
+            result.trx_ids.reserve(result.block.transactions.size());
+            for (const auto& trx: result.block.transactions) {
+                result.trx_ids.push_back(trx.id());
+            }
+
+            _decode_micro.fetch_add((fc::time_point::now() - start).count(), std::memory_order_relaxed);
+        }
+
+        void replay_pipeline::decode_loop(uint32_t first_block_num, uint32_t step) {
+            const uint32_t ring_size = static_cast<uint32_t>(_ring.size());
+
+            for (uint64_t block_num = first_block_num; block_num <= _last_block_num; block_num += step) {
+                auto& s = _ring[block_num % ring_size];
+
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    _free_cond.wait(lock, [&]() {
+                        return _is_stopped || block_num < uint64_t(_next_block_num) + ring_size;
+                    });
+                    if (_is_stopped) {
+                        return;
+                    }
+                }
+
+                // the slot belongs to this thread until it is marked as ready
+                try {
+                    decode(static_cast<uint32_t>(block_num), s.data);
+                } catch (...) {
+                    s.error = std::current_exception();
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    s.ready = true;
+                }
+                _ready_cond.notify_one();
+            }
+        }
+
+        const decoded_block& replay_pipeline::next() {
+            FC_ASSERT(_next_block_num <= _last_block_num, "Replay pipeline is exhausted.");
+
+            auto& s = _ring[_next_block_num % _ring.size()];
+
+            if (_threads.empty()) {
+                decode(_next_block_num, s.data);
+                return s.data;
+            }
+
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                if (!s.ready) {
+                    auto start = fc::time_point::now();
+                    _ready_cond.wait(lock, [&]() {
+                        return s.ready;
+                    });
+                    _wait_micro += (fc::time_point::now() - start).count();
+                }
+            }
+
+            if (s.error) {
+                std::rethrow_exception(s.error);
+            }
+            return s.data;
+        }
+
+        void replay_pipeline::release() {
+            auto& s = _ring[_next_block_num % _ring.size()];
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                s.ready = false;
+                s.error = nullptr;
+                ++_next_block_num;
+            }
+            _free_cond.notify_all();
+        }
+
+        void replay_pipeline::stop() {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _is_stopped = true;
+            }
+            _free_cond.notify_all();
+
+            for (auto& t: _threads) {
+                if (t.joinable()) {
+                    t.join();
+                }
+            }
+        }
+
+} } // graphene::chain
@@ -23,6 +23,8 @@
  */
 #include <graphene/network/core_messages.hpp>
 
+#include <cstring>
+
 
 namespace graphene {
     namespace network {
@@ -46,6 +48,17 @@ namespace graphene {
         const core_message_type_enum check_firewall_reply_message::type = core_message_type_enum::check_firewall_reply_message_type;
         const core_message_type_enum get_current_connections_request_message::type = core_message_type_enum::get_current_connections_request_message_type;
         const core_message_type_enum get_current_connections_reply_message::type = core_message_type_enum::get_current_connections_reply_message_type;
+        const core_message_type_enum compressed_message::type = core_message_type_enum::compressed_message_type;
+        const core_message_type_enum compact_block_message::type = core_message_type_enum::compact_block_message_type;
+        const core_message_type_enum fetch_block_transactions_message::type = core_message_type_enum::fetch_block_transactions_message_type;
+        const core_message_type_enum block_transactions_message::type = core_message_type_enum::block_transactions_message_type;
+
+        uint64_t short_transaction_id(const transaction_id_type &id) {
+            uint64_t result;
+            static_assert(sizeof(result) <= sizeof(id._hash), "transaction id is too short");
+            std::memcpy(&result, id.data(), sizeof(result));
+            return result;
+        }
 
     }
 } // graphene::network
@@ -23,7 +23,13 @@
  */
 #pragma once
 
-#define GRAPHENE_NET_PROTOCOL_VERSION                        106
+#define GRAPHENE_NET_PROTOCOL_VERSION                        107
+
+/**
+ * Peers of this version and later receive recently relayed blocks as compact blocks,
+ * see compact_block_message
+ */
+#define GRAPHENE_NET_COMPACT_BLOCKS_PROTOCOL_VERSION         107
 
 /**
  * Define this to enable debugging code in the p2p network interface.
@@ -55,7 +61,20 @@
 #define GRAPHENE_NET_DEFAULT_DESIRED_CONNECTIONS             20
 #define GRAPHENE_NET_DEFAULT_MAX_CONNECTIONS                 200
 
-#define GRAPHENE_NET_MAXIMUM_QUEUED_MESSAGES_IN_BYTES        (1024 * 1024)
+/**
+ * Limits of bytes queued for sending to a peer, one per send_queue_priority.
+ * The connection is closed when a limit is exceeded, queued transaction inventory
+ * is dropped before that.
+ */
+#define GRAPHENE_NET_MAXIMUM_QUEUED_BLOCK_MESSAGES_IN_BYTES        (1024 * 1024)
+#define GRAPHENE_NET_MAXIMUM_QUEUED_TRANSACTION_MESSAGES_IN_BYTES  (1024 * 1024)
+#define GRAPHENE_NET_MAXIMUM_QUEUED_HOUSEKEEPING_MESSAGES_IN_BYTES (512 * 1024)
+
+/**
+ * Transaction inventory which has waited in the send queue longer than this
+ * number of seconds is dropped, the peer has most likely got it from others
+ */
+#define GRAPHENE_NET_MAXIMUM_TRANSACTION_INVENTORY_QUEUE_TIME 5
 
 /**
  * When we receive a message from the network, we advertise it to
@@ -81,6 +100,25 @@
 
 #define GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING      200
 
+/**
+ * During sync, the number of blocks requested from a peer at once is sized
+ * by the measured throughput of the peer to cover this time of its delivery
+ * plus its round trip time, but not less than the minimum and not more than
+ * the maximum_blocks_per_peer_during_syncing.
+ */
+#define GRAPHENE_NET_MIN_BLOCKS_PER_PEER_DURING_SYNCING      10
+#define GRAPHENE_NET_SYNC_WINDOW_DURATION_MS                 2000
+
+/**
+ * A sync block which is one of the next blocks to push is requested again
+ * from a faster peer when it isn't received after this factor of the time the
+ * peer was expected to deliver it, but not earlier than after the minimum.
+ * Only this many of next blocks of each peer are checked.
+ */
+#define GRAPHENE_NET_SYNC_REQUEST_OVERDUE_FACTOR             3
+#define GRAPHENE_NET_MIN_SYNC_REQUEST_OVERDUE_MS             1000
+#define GRAPHENE_NET_SYNC_BLOCKS_TO_REISSUE_AHEAD            16
+
 /**
  * During normal operation, how many items will be fetched from each
  * peer at a time.  This will only come into play when the network
@@ -103,3 +141,10 @@
 #define GRAPHENE_NET_MIN_BLOCK_IDS_TO_PREFETCH               10000
 
 #define GRAPHENE_NET_MAX_TRX_PER_SECOND                      1000
+
+/**
+ * Messages of at least this size are sent compressed to peers which support
+ * the compression, smaller ones gain almost nothing after padding to 16 bytes.
+ */
+#define GRAPHENE_NET_MIN_COMPRESSED_MESSAGE_SIZE             512
+#define GRAPHENE_NET_MESSAGE_COMPRESSION_LEVEL               3
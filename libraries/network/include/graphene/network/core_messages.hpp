@@ -46,6 +46,7 @@ namespace graphene {
         using graphene::protocol::block_id_type;
         using graphene::protocol::transaction_id_type;
         using graphene::protocol::signed_block;
+        using graphene::protocol::signed_block_header;
 
         typedef fc::ecc::public_key_data node_id_t;
         typedef fc::ripemd160 item_hash_t;
@@ -89,6 +90,10 @@ namespace graphene {
             check_firewall_reply_message_type = 5015,
             get_current_connections_request_message_type = 5016,
             get_current_connections_reply_message_type = 5017,
+            compressed_message_type = 5018,
+            compact_block_message_type = 5019,
+            fetch_block_transactions_message_type = 5020,
+            block_transactions_message_type = 5021,
             core_message_type_last = 5099
         };
 
@@ -419,6 +424,74 @@ namespace graphene {
             std::vector<current_connection_data> current_connections;
         };
 
+        enum class message_compression {
+            none,
+            zstd
+        };
+
+        /**
+         * A message compressed by the connection, it is sent only to peers which announced
+         * the compression in the user data of their hello. The receiving connection restores
+         * the original message, so the node never sees this one.
+         */
+        struct compressed_message {
+            static const core_message_type_enum type;
+
+            fc::enum_type<uint8_t, message_compression> compression;
+            uint32_t msg_type; /// of the original message
+            uint32_t size; /// of the original message
+            std::vector<char> data;
+        };
+
+        /// the first 8 bytes of the transaction id
+        uint64_t short_transaction_id(const transaction_id_type &id);
+
+        /**
+         * A block which is relayed during normal operation, it is sent instead of the block_message
+         * to peers which support it. The peers have received almost all transactions of the block
+         * already, so the block is rebuilt from the cache of transactions, the missing ones are
+         * fetched by fetch_block_transactions_message.
+         */
+        struct compact_block_message {
+            static const core_message_type_enum type;
+
+            item_hash_t item_hash; /// of the block_message, the rebuilt block must have the same
+            signed_block_header header;
+            std::vector<uint64_t> short_transaction_ids;
+
+            compact_block_message() {
+            }
+
+            compact_block_message(const item_hash_t &item_hash, const signed_block &block)
+                    : item_hash(item_hash), header(block) {
+                short_transaction_ids.reserve(block.transactions.size());
+                for (const auto &trx : block.transactions) {
+                    short_transaction_ids.push_back(short_transaction_id(trx.id()));
+                }
+            }
+        };
+
+        struct fetch_block_transactions_message {
+            static const core_message_type_enum type;
+
+            item_hash_t item_hash;
+            std::vector<uint32_t> transaction_indexes;
+
+            fetch_block_transactions_message() {
+            }
+
+            fetch_block_transactions_message(const item_hash_t &item_hash, std::vector<uint32_t> transaction_indexes)
+                    : item_hash(item_hash), transaction_indexes(std::move(transaction_indexes)) {
+            }
+        };
+
+        struct block_transactions_message {
+            static const core_message_type_enum type;
+
+            item_hash_t item_hash;
+            std::vector<signed_transaction> transactions; /// in order of the requested indexes
+        };
+
 
     }
 } // graphene::network
@@ -444,6 +517,10 @@ FC_REFLECT_ENUM(graphene::network::core_message_type_enum,
                 (check_firewall_reply_message_type)
                 (get_current_connections_request_message_type)
                 (get_current_connections_reply_message_type)
+                (compressed_message_type)
+                (compact_block_message_type)
+                (fetch_block_transactions_message_type)
+                (block_transactions_message_type)
                 (core_message_type_last))
 
 FC_REFLECT((graphene::network::trx_message), (trx))
@@ -527,6 +604,19 @@ FC_REFLECT((graphene::network::get_current_connections_reply_message), (upload_r
         (upload_rate_one_hour)
         (download_rate_one_hour)
         (current_connections))
+FC_REFLECT_ENUM(graphene::network::message_compression, (none)
+        (zstd))
+FC_REFLECT((graphene::network::compressed_message), (compression)
+        (msg_type)
+        (size)
+        (data))
+FC_REFLECT((graphene::network::compact_block_message), (item_hash)
+        (header)
+        (short_transaction_ids))
+FC_REFLECT((graphene::network::fetch_block_transactions_message), (item_hash)
+        (transaction_indexes))
+FC_REFLECT((graphene::network::block_transactions_message), (item_hash)
+        (transactions))
 
 #include <unordered_map>
 #include <fc/crypto/city.hpp>
@@ -24,6 +24,7 @@
 #pragma once
 
 #include <fc/network/tcp_socket.hpp>
+#include <graphene/network/core_messages.hpp>
 #include <graphene/network/message.hpp>
 
 namespace graphene {
@@ -33,6 +34,16 @@ namespace graphene {
 
         class message_oriented_connection;
 
+        /** bytes of compressed messages, the totals of the connection count bytes on the wire */
+        struct message_compression_statistics {
+            uint64_t messages_sent = 0;
+            uint64_t bytes_sent_before_compression = 0;
+            uint64_t bytes_sent_after_compression = 0;
+            uint64_t messages_received = 0;
+            uint64_t bytes_received_before_decompression = 0;
+            uint64_t bytes_received_after_decompression = 0;
+        };
+
         /** receives incoming messages from a message_oriented_connection object */
         class message_oriented_connection_delegate {
         public:
@@ -74,6 +85,18 @@ namespace graphene {
 
             fc::sha512 get_shared_secret() const;
 
+            /**
+             * Messages of at least min_size bytes are sent compressed, the peer must support the compression.
+             * Compressed messages are received regardless of this setting.
+             */
+            void enable_compression(message_compression compression, uint32_t min_size);
+
+            message_compression get_compression() const;
+
+            const message_compression_statistics &get_compression_statistics() const;
+
+            static bool is_compression_supported(message_compression compression);
+
         private:
             std::unique_ptr<detail::message_oriented_connection_impl> my;
         };
@@ -82,3 +105,10 @@ namespace graphene {
 
     }
 } // graphene::network
+
+FC_REFLECT((graphene::network::message_compression_statistics), (messages_sent)
+        (bytes_sent_before_compression)
+        (bytes_sent_after_compression)
+        (messages_received)
+        (bytes_received_before_decompression)
+        (bytes_received_after_decompression))
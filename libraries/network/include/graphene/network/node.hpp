@@ -79,6 +79,14 @@ namespace graphene {
             virtual bool handle_block(const graphene::network::block_message &blk_msg, bool sync_mode,
                     std::vector<fc::uint160_t> &contained_transaction_message_ids) = 0;
 
+            /**
+             *  @brief Called on the thread of the node when a sync block is received, before it waits
+             *         in the backlog for handle_block(). The delegate can start work which doesn't depend
+             *         on the state, for example recovery of signatures. It must not block or throw.
+             */
+            virtual void prefetch_block(const graphene::network::block_message &blk_msg) {
+            }
+
             /**
              *  @brief Called when a new transaction comes in from the network
              *
@@ -40,7 +40,8 @@
 #include <boost/multi_index/sequenced_index.hpp>
 #include <boost/multi_index/hashed_index.hpp>
 
-#include <queue>
+#include <array>
+#include <list>
 #include <boost/container/deque.hpp>
 #include <fc/thread/future.hpp>
 
@@ -60,6 +61,57 @@ namespace graphene {
             node_id_t requesting_peer;
         };
 
+        /**
+         * Delivery of sync blocks by the peer, it sizes the window of blocks requested from the peer.
+         * Times are smoothed as TCP does for the round trip time.
+         */
+        struct peer_sync_statistics {
+            uint32_t window = GRAPHENE_NET_MIN_BLOCKS_PER_PEER_DURING_SYNCING; /// number of sync blocks which can be requested from the peer at once
+            fc::microseconds round_trip_time; /// from a request sent when nothing was requested to the first block
+            fc::microseconds block_interval; /// between blocks while requests are outstanding
+            uint64_t blocks_received = 0;
+            uint64_t bytes_received = 0;
+            uint64_t duplicate_blocks = 0; /// blocks which were already received from another peer
+            uint64_t requests_reissued = 0; /// overdue blocks of other peers requested from this peer
+            uint64_t requests_overdue = 0; /// blocks requested from this peer which were requested from another peer
+            fc::time_point first_request_time;
+            fc::time_point last_block_time;
+
+            /// @param outstanding number of blocks requested from the peer before this request
+            void on_request(size_t outstanding, fc::time_point now);
+
+            void on_block(uint32_t size, fc::time_point now);
+
+            void update_window(uint32_t min_window, uint32_t max_window);
+
+            /// time in which the peer is expected to deliver the requested blocks
+            fc::microseconds expected_delivery_time(size_t outstanding) const;
+
+            double blocks_per_second() const;
+
+            fc::variant_object to_variant_object() const;
+        };
+
+        /**
+         * Messages to the peer are sent in order of priority, a message is sent only when
+         * there are no queued messages of higher priorities. Each priority has its own limit
+         * of queued bytes, so a flood of transactions doesn't delay the relay of blocks.
+         */
+        enum class send_queue_priority : uint8_t {
+            blocks,       /// handshake, blocks, their inventory and synchronization
+            transactions, /// transactions and their inventory
+            housekeeping  /// peer lists, time and firewall checks, closing of the connection
+        };
+
+        constexpr size_t send_queue_priority_count = 3;
+
+        struct send_queue_statistics {
+            uint64_t queued_bytes = 0;
+            uint64_t queued_messages = 0;
+            uint64_t messages_sent = 0;
+            uint64_t messages_dropped = 0; /// stale transaction inventory
+        };
+
         class peer_connection;
 
         class peer_connection_delegate {
@@ -116,6 +168,8 @@ namespace graphene {
                 fc::time_point enqueue_time;
                 fc::time_point transmission_start_time;
                 fc::time_point transmission_finish_time;
+                send_queue_priority priority = send_queue_priority::housekeeping;
+                bool droppable = false; /// transaction inventory, which may be dropped instead of being sent
 
                 queued_message(fc::time_point enqueue_time = fc::time_point::now())
                         :
@@ -168,8 +222,13 @@ namespace graphene {
             };
 
 
-            size_t _total_queued_messages_size;
-            std::queue<std::unique_ptr<queued_message>, std::list<std::unique_ptr<queued_message>>> _queued_messages;
+            struct send_queue {
+                std::list<std::unique_ptr<queued_message>> messages;
+                send_queue_statistics statistics; /// the message being sent is counted as queued
+            };
+
+            std::array<send_queue, send_queue_priority_count> _send_queues; /// by send_queue_priority
+            std::unique_ptr<queued_message> _message_being_sent;
             fc::future<void> _send_queued_messages_done;
         public:
             fc::time_point connection_initiation_time;
@@ -239,6 +298,7 @@ namespace graphene {
             item_hash_t last_block_delegate_has_seen; /// the hash of the last block  this peer has told us about that the peer knows
             fc::time_point_sec last_block_time_delegate_has_seen;
             bool inhibit_fetching_sync_blocks;
+            peer_sync_statistics sync_statistics;
             /// @}
 
             /// non-synchronization state data
@@ -265,6 +325,13 @@ namespace graphene {
             timestamped_items_set_type inventory_advertised_to_peer;
 
             item_to_time_map_type items_requested_from_peer;  /// items we've requested from this peer during normal operation.  fetch from another peer if this peer disconnects
+
+            /// a block received as compact block, which waits for its missing transactions from this peer
+            struct compact_block_in_progress {
+                signed_block block;
+                std::vector<uint32_t> missing_transaction_indexes;
+            };
+            std::unordered_map<item_hash_t, compact_block_in_progress> compact_blocks_in_progress; /// by item hash of the block
             /// @}
 
             // if they're flooding us with transactions, we set this to avoid fetching for a few seconds to let the
@@ -332,6 +399,15 @@ namespace graphene {
 
             fc::sha512 get_shared_secret() const;
 
+            void enable_compression(message_compression compression);
+
+            message_compression get_compression() const;
+
+            const message_compression_statistics &get_compression_statistics() const;
+
+            /// statistics of the send queues by name of the priority
+            fc::variant_object get_send_queue_statistics() const;
+
             void clear_old_inventory();
 
             bool is_inventory_advertised_to_us_list_full_for_transactions() const;
@@ -345,6 +421,9 @@ namespace graphene {
         private:
             void send_queued_messages_task();
 
+            /// drops the oldest transaction inventory from the queue until it fits the limit
+            void drop_transaction_inventory(send_queue &queue, size_t maximum_size);
+
             void accept_connection_task();
 
             void connect_to_task(const fc::ip::endpoint &remote_endpoint);
@@ -377,3 +456,11 @@ FC_REFLECT_ENUM(graphene::network::peer_connection::connection_negotiation_statu
         (closed))
 
 FC_REFLECT((graphene::network::peer_connection::timestamped_item_id), (item)(timestamp));
+
+FC_REFLECT_ENUM(graphene::network::send_queue_priority, (blocks)
+        (transactions)
+        (housekeeping))
+FC_REFLECT((graphene::network::send_queue_statistics), (queued_bytes)
+        (queued_messages)
+        (messages_sent)
+        (messages_dropped))
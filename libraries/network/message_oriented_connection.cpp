@@ -30,6 +30,10 @@
 #include <graphene/network/stcp_socket.hpp>
 #include <graphene/network/config.hpp>
 
+#ifdef HAS_ZSTD
+#include <zstd.h>
+#endif
+
 #ifdef DEFAULT_LOGGER
 # undef DEFAULT_LOGGER
 #endif
@@ -44,6 +48,91 @@
 namespace graphene {
     namespace network {
         namespace detail {
+#ifdef HAS_ZSTD
+            // messages are sent and received on the thread of the node, so the contexts are reused by all connections
+            struct zstd_contexts {
+                ZSTD_CCtx *cctx = ZSTD_createCCtx();
+                ZSTD_DCtx *dctx = ZSTD_createDCtx();
+
+                ~zstd_contexts() {
+                    ZSTD_freeCCtx(cctx);
+                    ZSTD_freeDCtx(dctx);
+                }
+            };
+
+            static zstd_contexts &get_zstd_contexts() {
+                static thread_local zstd_contexts contexts;
+                return contexts;
+            }
+#endif
+
+            /// returns nullptr if the message doesn't become smaller
+            static std::unique_ptr<message> compress_message(const message &original, message_compression compression) {
+                compressed_message compressed;
+                compressed.compression = compression;
+                compressed.msg_type = original.msg_type;
+                compressed.size = original.size;
+
+                switch (compression) {
+                    case message_compression::zstd: {
+#ifdef HAS_ZSTD
+                        compressed.data.resize(ZSTD_compressBound(original.data.size()));
+                        std::size_t size = ZSTD_compressCCtx(get_zstd_contexts().cctx,
+                                compressed.data.data(), compressed.data.size(),
+                                original.data.data(), original.data.size(), GRAPHENE_NET_MESSAGE_COMPRESSION_LEVEL);
+                        if (ZSTD_isError(size)) {
+                            wlog("Can't compress message: ${e}", ("e", ZSTD_getErrorName(size)));
+                            return nullptr;
+                        }
+                        compressed.data.resize(size);
+                        break;
+#else
+                        return nullptr;
+#endif
+                    }
+
+                    default:
+                        return nullptr;
+                }
+
+                std::unique_ptr<message> result(new message(compressed));
+                if (result->size >= original.size) {
+                    return nullptr;
+                }
+                return result;
+            }
+
+            static std::unique_ptr<message> decompress_message(const message &received) {
+                const compressed_message compressed = received.as<compressed_message>();
+                FC_ASSERT(compressed.size <= MAX_MESSAGE_SIZE, "", ("size", compressed.size)("MAX_MESSAGE_SIZE", MAX_MESSAGE_SIZE));
+                FC_ASSERT(compressed.msg_type != compressed_message::type, "Compressed message contains compressed message");
+
+                std::unique_ptr<message> result(new message);
+                result->msg_type = compressed.msg_type;
+                result->size = compressed.size;
+
+                switch (compressed.compression.value) {
+                    case message_compression::zstd: {
+#ifdef HAS_ZSTD
+                        result->data.resize(compressed.size);
+                        std::size_t size = ZSTD_decompressDCtx(get_zstd_contexts().dctx,
+                                result->data.data(), result->data.size(),
+                                compressed.data.data(), compressed.data.size());
+                        FC_ASSERT(!ZSTD_isError(size), "Can't decompress message: ${e}", ("e", ZSTD_getErrorName(size)));
+                        FC_ASSERT(size == compressed.size, "Wrong size of decompressed message");
+                        break;
+#else
+                        FC_THROW_EXCEPTION(fc::unsupported_exception, "Message is compressed by zstd, but the node is built without zstd support");
+#endif
+                    }
+
+                    default:
+                        FC_THROW_EXCEPTION(fc::unsupported_exception, "Unknown compression ${c} of message",
+                                ("c", static_cast<uint32_t>(compressed.compression.value)));
+                }
+                return result;
+            }
+
             class message_oriented_connection_impl {
             private:
                 message_oriented_connection *_self;
@@ -59,6 +148,10 @@ namespace graphene {
 
                 bool _send_message_in_progress;
 
+                message_compression _compression;
+                uint32_t _min_compressed_message_size;
+                message_compression_statistics _compression_statistics;
+
 #ifndef NDEBUG
                 fc::thread *_thread;
 #endif
@@ -83,6 +176,8 @@ namespace graphene {
 
                 void send_message(const message &message_to_send);
 
+                void send_frame(const message &message_to_send);
+
                 void close_connection();
 
                 void destroy_connection();
@@ -100,6 +195,22 @@ namespace graphene {
                 }
 
                 fc::sha512 get_shared_secret() const;
+
+                void enable_compression(message_compression compression, uint32_t min_size) {
+                    VERIFY_CORRECT_THREAD();
+                    _compression = compression;
+                    _min_compressed_message_size = min_size;
+                }
+
+                message_compression get_compression() const {
+                    VERIFY_CORRECT_THREAD();
+                    return _compression;
+                }
+
+                const message_compression_statistics &get_compression_statistics() const {
+                    VERIFY_CORRECT_THREAD();
+                    return _compression_statistics;
+                }
             };
 
             message_oriented_connection_impl::message_oriented_connection_impl(message_oriented_connection *self,
@@ -108,7 +219,9 @@ namespace graphene {
                       _delegate(delegate),
                       _bytes_received(0),
                       _bytes_sent(0),
-                      _send_message_in_progress(false)
+                      _send_message_in_progress(false),
+                      _compression(message_compression::none),
+                      _min_compressed_message_size(0)
 #ifndef NDEBUG
                     , _thread(&fc::thread::current())
 #endif
@@ -183,9 +296,19 @@ namespace graphene {
 
                         _last_message_received_time = fc::time_point::now();
 
+                        const message *received_message = &m;
+                        std::unique_ptr<message> decompressed_message;
+                        if (m.msg_type == compressed_message::type) {
+                            decompressed_message = decompress_message(m);
+                            received_message = decompressed_message.get();
+                            ++_compression_statistics.messages_received;
+                            _compression_statistics.bytes_received_before_decompression += m.size;
+                            _compression_statistics.bytes_received_after_decompression += decompressed_message->size;
+                        }
+
                         try {
                             // message handling errors are warnings...
-                            _delegate->on_message(_self, m);
+                            _delegate->on_message(_self, *received_message);
                         }
                             /// Dedicated catches needed to distinguish from general fc::exception
                         catch (const fc::canceled_exception &e) {
@@ -264,24 +387,38 @@ namespace graphene {
                 } _verify_no_send_in_progress(_send_message_in_progress);
 
                 try {
-                    size_t size_of_message_and_header =
-                            sizeof(message_header) + message_to_send.size;
-                    if (message_to_send.size > MAX_MESSAGE_SIZE)
-                        elog("Trying to send a message larger than MAX_MESSAGE_SIZE. This probably won't work...");
-                    //pad the message we send to a multiple of 16 bytes
-                    size_t size_with_padding =
-                            16 * ((size_of_message_and_header + 15) / 16);
-                    std::unique_ptr<char[]> padded_message(new char[size_with_padding]);
-                    memcpy(padded_message.get(), (char *)&message_to_send, sizeof(message_header));
-                    memcpy(padded_message.get() +
-                           sizeof(message_header), message_to_send.data.data(), message_to_send.size);
-                    _sock.write(padded_message.get(), size_with_padding);
-                    _sock.flush();
-                    _bytes_sent += size_with_padding;
-                    _last_message_sent_time = fc::time_point::now();
+                    std::unique_ptr<message> compressed_message_to_send;
+                    if (_compression != message_compression::none &&
+                        message_to_send.size >= _min_compressed_message_size) {
+                        compressed_message_to_send = compress_message(message_to_send, _compression);
+                        if (compressed_message_to_send) {
+                            ++_compression_statistics.messages_sent;
+                            _compression_statistics.bytes_sent_before_compression += message_to_send.size;
+                            _compression_statistics.bytes_sent_after_compression += compressed_message_to_send->size;
+                        }
+                    }
+                    send_frame(compressed_message_to_send ? *compressed_message_to_send : message_to_send);
                 } FC_RETHROW_EXCEPTIONS(warn, "unable to send message");
             }
 
+            void message_oriented_connection_impl::send_frame(const message &message_to_send) {
+                size_t size_of_message_and_header =
+                        sizeof(message_header) + message_to_send.size;
+                if (message_to_send.size > MAX_MESSAGE_SIZE)
+                    elog("Trying to send a message larger than MAX_MESSAGE_SIZE. This probably won't work...");
+                //pad the message we send to a multiple of 16 bytes
+                size_t size_with_padding =
+                        16 * ((size_of_message_and_header + 15) / 16);
+                std::unique_ptr<char[]> padded_message(new char[size_with_padding]);
+                memcpy(padded_message.get(), (char *)&message_to_send, sizeof(message_header));
+                memcpy(padded_message.get() +
+                       sizeof(message_header), message_to_send.data.data(), message_to_send.size);
+                _sock.write(padded_message.get(), size_with_padding);
+                _sock.flush();
+                _bytes_sent += size_with_padding;
+                _last_message_sent_time = fc::time_point::now();
+            }
+
             void message_oriented_connection_impl::close_connection() {
                 VERIFY_CORRECT_THREAD();
                 _sock.close();
@@ -400,5 +537,30 @@ namespace graphene {
             return my->get_shared_secret();
         }
 
+        void message_oriented_connection::enable_compression(message_compression compression, uint32_t min_size) {
+            my->enable_compression(compression, min_size);
+        }
+
+        message_compression message_oriented_connection::get_compression() const {
+            return my->get_compression();
+        }
+
+        const message_compression_statistics &message_oriented_connection::get_compression_statistics() const {
+            return my->get_compression_statistics();
+        }
+
+        bool message_oriented_connection::is_compression_supported(message_compression compression) {
+            switch (compression) {
+                case message_compression::none:
+                    return true;
+#ifdef HAS_ZSTD
+                case message_compression::zstd:
+                    return true;
+#endif
+                default:
+                    return false;
+            }
+        }
+
     }
 } // end namespace graphene::network
@@ -23,9 +23,12 @@
  */
 #include <sstream>
 #include <iomanip>
+#include <cstring>
 #include <deque>
+#include <unordered_map>
 #include <unordered_set>
 #include <list>
+#include <numeric>
 #include <forward_list>
 #include <iostream>
 #include <boost/tuple/tuple.hpp>
@@ -170,6 +173,9 @@ namespace graphene {
 
                 message_propagation_data get_message_propagation_data(const fc::uint160_t &hash_of_message_contents_to_lookup) const;
 
+                /// the transaction whose id starts with the short id, or nullptr
+                const message *find_transaction_message(uint64_t short_id) const;
+
                 size_t size() const {
                     return _message_cache.size();
                 }
@@ -216,6 +222,59 @@ namespace graphene {
                 FC_THROW_EXCEPTION(fc::key_not_found_exception, "Requested message not in cache");
             }
 
+            const message *blockchain_tied_message_cache::find_transaction_message(uint64_t short_id) const {
+                // the short id is the prefix of the transaction id, the index is ordered by bytes of ids
+                fc::uint160_t lowest_id;
+                std::memcpy(lowest_id.data(), &short_id, sizeof(short_id));
+                const auto &index = _message_cache.get<message_contents_hash_index>();
+                for (auto iter = index.lower_bound(lowest_id);
+                     iter != index.end() &&
+                     std::memcmp(iter->message_contents_hash.data(), lowest_id.data(), sizeof(short_id)) == 0; ++iter) {
+                    if (iter->message_body.msg_type == trx_message_type) {
+                        return &iter->message_body;
+                    }
+                }
+                return nullptr;
+            }
+
+            /**
+             * The n most recent accepted blocks in order of acceptance, the lookup is done by the hash index,
+             * it is called for each received block
+             */
+            class recent_block_ids {
+            public:
+                explicit recent_block_ids(size_t capacity)
+                        : _ids(capacity) {
+                }
+
+                void push_back(const item_hash_t &id) {
+                    if (_ids.capacity() == 0) {
+                        return;
+                    }
+                    if (_ids.full()) {
+                        auto iter = _index.find(_ids.front());
+                        if (iter != _index.end()) {
+                            _index.erase(iter);
+                        }
+                    }
+                    _ids.push_back(id);
+                    _index.insert(id);
+                }
+
+                bool contains(const item_hash_t &id) const {
+                    return _index.find(id) != _index.end();
+                }
+
+                void clear() {
+                    _ids.clear();
+                    _index.clear();
+                }
+
+            private:
+                boost::circular_buffer<item_hash_t> _ids;
+                std::unordered_multiset<item_hash_t> _index;
+            };
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 
             // This specifies configuration info for the local node.  It's stored as JSON
@@ -391,6 +450,8 @@ namespace graphene {
 
                 bool handle_block(const graphene::network::block_message &block_message, bool sync_mode, std::vector<fc::uint160_t> &contained_transaction_message_ids) override;
 
+                void prefetch_block(const graphene::network::block_message &block_message) override;
+
                 void handle_transaction(const graphene::network::trx_message &transaction_message) override;
 
                 std::vector<item_hash_t> get_block_ids(const std::vector<item_hash_t> &blockchain_synopsis,
@@ -463,8 +524,8 @@ namespace graphene {
                 typedef std::unordered_map<graphene::network::block_id_type, fc::time_point> active_sync_requests_map;
 
                 active_sync_requests_map _active_sync_requests; /// list of sync blocks we've asked for from peers but have not yet received
-                std::list<graphene::network::block_message> _new_received_sync_items; /// list of sync blocks we've just received but haven't yet tried to process
-                std::list<graphene::network::block_message> _received_sync_items; /// list of sync blocks we've received, but can't yet process because we are still missing blocks that come earlier in the chain
+                /// sync blocks we've received by block id, but can't yet process because we are still missing blocks that come earlier in the chain
+                std::unordered_map<item_hash_t, graphene::network::block_message> _received_sync_items;
                 // @}
 
                 fc::future<void> _process_backlog_of_sync_blocks_done;
@@ -537,7 +598,7 @@ namespace graphene {
                 /** stores connections we've closed, but are still waiting for the OS to notify us that the socket is really closed */
                 std::unordered_set<peer_connection_ptr> _terminating_connections;
 
-                boost::circular_buffer<item_hash_t> _most_recent_blocks_accepted; // the /n/ most recent blocks we've accepted (currently tuned to the max number of connections)
+                recent_block_ids _most_recent_blocks_accepted; // the /n/ most recent blocks we've accepted (currently tuned to the max number of connections)
 
                 uint32_t _sync_item_type;
                 uint32_t _total_number_of_unfetched_items; /// the number of items we still need to fetch while syncing
@@ -592,6 +653,13 @@ namespace graphene {
                 unsigned _maximum_number_of_sync_blocks_to_prefetch;
                 unsigned _maximum_blocks_per_peer_during_syncing;
 
+                bool _message_compression_enabled; /// announce the compression in the hello and compress messages to peers which announced it too
+                bool _compact_blocks_enabled; /// send recently relayed blocks as compact blocks to peers which support it
+
+                uint64_t _compact_blocks_sent;
+                uint64_t _compact_blocks_received;
+                uint64_t _compact_block_transactions_fetched; /// transactions of received compact blocks, which were missing in the cache
+
                 std::list<fc::future<void>> _handle_message_calls_in_progress;
                 std::set<message_hash_type> _message_ids_currently_being_processed;
 
@@ -611,6 +679,13 @@ namespace graphene {
 
                 void request_sync_items_from_peer(const peer_connection_ptr &peer, const std::vector<item_hash_t> &items_to_request);
 
+                bool can_request_sync_items_from_peer(const peer_connection_ptr &peer) const;
+
+                bool is_sync_item_requested_from_other_peer(const peer_connection *peer, const item_hash_t &item) const;
+
+                void schedule_overdue_sync_items(std::map<peer_connection_ptr, std::vector<item_hash_t>> &sync_item_requests_to_send,
+                        std::set<item_hash_t> &sync_items_to_request);
+
                 void fetch_sync_items_loop();
 
                 void trigger_fetch_sync_items_loop();
@@ -715,6 +790,18 @@ namespace graphene {
                 void on_get_current_connections_reply_message(peer_connection *originating_peer,
                         const get_current_connections_reply_message &get_current_connections_reply_message_received);
 
+                void on_compact_block_message(peer_connection *originating_peer,
+                        const compact_block_message &compact_block_message_received);
+
+                void on_fetch_block_transactions_message(peer_connection *originating_peer,
+                        const fetch_block_transactions_message &fetch_block_transactions_message_received);
+
+                void on_block_transactions_message(peer_connection *originating_peer,
+                        const block_transactions_message &block_transactions_message_received);
+
+                void finish_compact_block(peer_connection *originating_peer, const item_hash_t &item_hash,
+                        peer_connection::compact_block_in_progress &&compact_block);
+
                 void on_connection_closed(peer_connection *originating_peer) override;
 
                 void send_sync_block_to_node_delegate(const graphene::network::block_message &block_message_to_send);
@@ -899,7 +986,12 @@ namespace graphene {
                     _node_is_shutting_down(false),
                     _maximum_number_of_blocks_to_handle_at_one_time(MAXIMUM_NUMBER_OF_BLOCKS_TO_HANDLE_AT_ONE_TIME),
                     _maximum_number_of_sync_blocks_to_prefetch(MAXIMUM_NUMBER_OF_BLOCKS_TO_PREFETCH),
-                    _maximum_blocks_per_peer_during_syncing(GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING) {
+                    _maximum_blocks_per_peer_during_syncing(GRAPHENE_NET_MAX_BLOCKS_PER_PEER_DURING_SYNCING),
+                    _message_compression_enabled(true),
+                    _compact_blocks_enabled(true),
+                    _compact_blocks_sent(0),
+                    _compact_blocks_received(0),
+                    _compact_block_transactions_fetched(0) {
                 _rate_limiter.set_actual_rate_time_constant(fc::seconds(2));
                 fc::rand_pseudo_bytes(&_node_id.data[0], (int)_node_id.size());
             }
@@ -1056,22 +1148,17 @@ namespace graphene {
 
             bool node_impl::have_already_received_sync_item(const item_hash_t &item_hash) {
                 VERIFY_CORRECT_THREAD();
-                return std::find_if(_received_sync_items.begin(), _received_sync_items.end(),
-                        [&item_hash](const graphene::network::block_message &message) {
-                            return message.block_id == item_hash;
-                        }) != _received_sync_items.end() ||
-                       std::find_if(_new_received_sync_items.begin(), _new_received_sync_items.end(),
-                               [&item_hash](const graphene::network::block_message &message) {
-                                   return message.block_id == item_hash;
-                               }) != _new_received_sync_items.end();;
+                return _received_sync_items.find(item_hash) != _received_sync_items.end();
             }
 
             void node_impl::request_sync_item_from_peer(const peer_connection_ptr &peer, const item_hash_t &item_to_request) {
                 VERIFY_CORRECT_THREAD();
                 dlog("requesting item ${item_hash} from peer ${endpoint}", ("item_hash", item_to_request)("endpoint", peer->get_remote_endpoint()));
                 item_id item_id_to_request(graphene::network::block_message_type, item_to_request);
-                _active_sync_requests.insert(active_sync_requests_map::value_type(item_to_request, fc::time_point::now()));
-                peer->last_sync_item_received_time = fc::time_point::now();
+                const fc::time_point now = fc::time_point::now();
+                peer->sync_statistics.on_request(peer->sync_items_requested_from_peer.size(), now);
+                _active_sync_requests[item_to_request] = now;
+                peer->last_sync_item_received_time = now;
                 peer->sync_items_requested_from_peer.insert(item_to_request);
                 peer->send_message(fetch_items_message(item_id_to_request.item_type, std::vector<item_hash_t>{
                         item_id_to_request.item_hash
@@ -1082,14 +1169,115 @@ namespace graphene {
                 VERIFY_CORRECT_THREAD();
                 dlog("requesting ${item_count} item(s) ${items_to_request} from peer ${endpoint}",
                         ("item_count", items_to_request.size())("items_to_request", items_to_request)("endpoint", peer->get_remote_endpoint()));
+                const fc::time_point now = fc::time_point::now();
+                peer->sync_statistics.on_request(peer->sync_items_requested_from_peer.size(), now);
                 for (const item_hash_t &item_to_request : items_to_request) {
-                    _active_sync_requests.insert(active_sync_requests_map::value_type(item_to_request, fc::time_point::now()));
-                    peer->last_sync_item_received_time = fc::time_point::now();
+                    // the time of the last request, the item can be requested again from a faster peer
+                    _active_sync_requests[item_to_request] = now;
+                    peer->last_sync_item_received_time = now;
                     peer->sync_items_requested_from_peer.insert(item_to_request);
                 }
                 peer->send_message(fetch_items_message(graphene::network::block_message_type, items_to_request));
             }
 
+            bool node_impl::can_request_sync_items_from_peer(const peer_connection_ptr &peer) const {
+                // sync items are requested while there are no requests of other kinds,
+                // the window of sync items is topped up when a half of it is received
+                return peer->we_need_sync_items_from_peer &&
+                       !peer->inhibit_fetching_sync_blocks &&
+                       peer->items_requested_from_peer.empty() &&
+                       !peer->item_ids_requested_from_peer &&
+                       peer->sync_items_requested_from_peer.size() <= peer->sync_statistics.window / 2;
+            }
+
+            bool node_impl::is_sync_item_requested_from_other_peer(const peer_connection *peer, const item_hash_t &item) const {
+                for (const peer_connection_ptr &other_peer : _active_connections) {
+                    if (other_peer.get() != peer &&
+                        other_peer->sync_items_requested_from_peer.find(item) !=
+                        other_peer->sync_items_requested_from_peer.end()) {
+                            return true;
+                    }
+                }
+                return false;
+            }
+
+            void node_impl::schedule_overdue_sync_items(std::map<peer_connection_ptr, std::vector<item_hash_t>> &sync_item_requests_to_send,
+                    std::set<item_hash_t> &sync_items_to_request) {
+                ASSERT_TASK_NOT_PREEMPTED();
+                // the blocks are pushed in order, so a block which is late stops pushing of all blocks after it.
+                // If one of the next blocks is late, it is requested from a faster peer which has it too,
+                // the block which is received later is dropped
+                const fc::time_point now = fc::time_point::now();
+                const fc::microseconds min_overdue_time = fc::milliseconds(GRAPHENE_NET_MIN_SYNC_REQUEST_OVERDUE_MS);
+                std::set<item_hash_t> checked_items;
+
+                for (const peer_connection_ptr &peer : _active_connections) {
+                    if (!peer->we_need_sync_items_from_peer) {
+                        continue;
+                    }
+                    const size_t count = std::min<size_t>(peer->ids_of_items_to_get.size(), GRAPHENE_NET_SYNC_BLOCKS_TO_REISSUE_AHEAD);
+                    for (size_t i = 0; i < count; ++i) {
+                        const item_hash_t &item = peer->ids_of_items_to_get[i];
+                        if (!checked_items.insert(item).second) {
+                            continue;
+                        }
+                        auto request_iter = _active_sync_requests.find(item);
+                        if (request_iter == _active_sync_requests.end()) {
+                            continue; // it is received or not requested yet
+                        }
+
+                        // the slowest peer which has the request, it is compared with others
+                        peer_connection_ptr holder;
+                        for (const peer_connection_ptr &other_peer : _active_connections) {
+                            if (other_peer->sync_items_requested_from_peer.find(item) !=
+                                other_peer->sync_items_requested_from_peer.end() &&
+                                (!holder ||
+                                 other_peer->sync_statistics.blocks_per_second() < holder->sync_statistics.blocks_per_second())) {
+                                    holder = other_peer;
+                            }
+                        }
+                        if (!holder) {
+                            continue;
+                        }
+
+                        const fc::microseconds expected_time = holder->sync_statistics.expected_delivery_time(
+                                holder->sync_items_requested_from_peer.size());
+                        const fc::microseconds overdue_time = std::max(min_overdue_time,
+                                fc::microseconds(expected_time.count() * GRAPHENE_NET_SYNC_REQUEST_OVERDUE_FACTOR));
+                        if (now - request_iter->second < overdue_time) {
+                            continue;
+                        }
+
+                        // the fastest peer which has the item and room in its window
+                        peer_connection_ptr faster_peer;
+                        for (const peer_connection_ptr &other_peer : _active_connections) {
+                            if (other_peer->sync_statistics.blocks_per_second() > holder->sync_statistics.blocks_per_second() &&
+                                (!faster_peer ||
+                                 other_peer->sync_statistics.blocks_per_second() > faster_peer->sync_statistics.blocks_per_second()) &&
+                                other_peer->sync_items_requested_from_peer.find(item) ==
+                                other_peer->sync_items_requested_from_peer.end() &&
+                                can_request_sync_items_from_peer(other_peer) &&
+                                other_peer->sync_items_requested_from_peer.size() + sync_item_requests_to_send[other_peer].size() <
+                                other_peer->sync_statistics.window &&
+                                std::find(other_peer->ids_of_items_to_get.begin(), other_peer->ids_of_items_to_get.end(), item) !=
+                                other_peer->ids_of_items_to_get.end()) {
+                                    faster_peer = other_peer;
+                            }
+                        }
+                        if (!faster_peer) {
+                            continue;
+                        }
+
+                        fc_dlog(fc::logger::get("sync"), "requesting overdue block ${item} of peer ${holder} from peer ${peer}",
+                                ("item", item)("holder", holder->get_remote_endpoint())("peer", faster_peer->get_remote_endpoint()));
+                        sync_item_requests_to_send[faster_peer].push_back(item);
+                        sync_items_to_request.insert(item);
+                        ++faster_peer->sync_statistics.requests_reissued;
+                        ++holder->sync_statistics.requests_overdue;
+                    }
+                }
+            }
+
             void node_impl::fetch_sync_items_loop() {
                 VERIFY_CORRECT_THREAD();
                 while (!_fetch_sync_items_loop_done.canceled()) {
@@ -1103,35 +1291,29 @@ namespace graphene {
                             ASSERT_TASK_NOT_PREEMPTED();
                             std::set<item_hash_t> sync_items_to_request;
 
-                            // for each idle peer that we're syncing with
+                            schedule_overdue_sync_items(sync_item_requests_to_send, sync_items_to_request);
+
+                            // for each peer that we're syncing with and which has room in its window
                             for (const peer_connection_ptr &peer : _active_connections) {
-                                if (peer->we_need_sync_items_from_peer &&
-                                    sync_item_requests_to_send.find(peer) ==
-                                    sync_item_requests_to_send.end() &&
-                                    // if we've already scheduled a request for this peer, don't consider scheduling another
-                                    peer->idle()) {
-                                    if (!peer->inhibit_fetching_sync_blocks) {
-                                        // loop through the items it has that we don't yet have on our blockchain
-                                        for (unsigned i = 0; i <
-                                                             peer->ids_of_items_to_get.size(); ++i) {
-                                            item_hash_t item_to_potentially_request = peer->ids_of_items_to_get[i];
-                                            // if we don't already have this item in our temporary storage and we haven't requested from another syncing peer
-                                            if (!have_already_received_sync_item(item_to_potentially_request) &&
-                                                // already got it, but for some reson it's still in our list of items to fetch
-                                                sync_items_to_request.find(item_to_potentially_request) ==
-                                                sync_items_to_request.end() &&
-                                                // we have already decided to request it from another peer during this iteration
-                                                _active_sync_requests.find(item_to_potentially_request) ==
-                                                _active_sync_requests.end()) // we've requested it in a previous iteration and we're still waiting for it to arrive
-                                            {
-                                                // then schedule a request from this peer
-                                                sync_item_requests_to_send[peer].push_back(item_to_potentially_request);
-                                                sync_items_to_request.insert(item_to_potentially_request);
-                                                if (sync_item_requests_to_send[peer].size() >=
-                                                    _maximum_blocks_per_peer_during_syncing) {
-                                                        break;
-                                                }
-                                            }
+                                if (can_request_sync_items_from_peer(peer)) {
+                                    std::vector<item_hash_t> &requests = sync_item_requests_to_send[peer];
+                                    const size_t window = peer->sync_statistics.window;
+                                    // loop through the items it has that we don't yet have on our blockchain
+                                    for (unsigned i = 0; i < peer->ids_of_items_to_get.size() &&
+                                                         peer->sync_items_requested_from_peer.size() + requests.size() < window; ++i) {
+                                        item_hash_t item_to_potentially_request = peer->ids_of_items_to_get[i];
+                                        // if we don't already have this item in our temporary storage and we haven't requested from another syncing peer
+                                        if (!have_already_received_sync_item(item_to_potentially_request) &&
+                                            // already got it, but for some reson it's still in our list of items to fetch
+                                            sync_items_to_request.find(item_to_potentially_request) ==
+                                            sync_items_to_request.end() &&
+                                            // we have already decided to request it from another peer during this iteration
+                                            _active_sync_requests.find(item_to_potentially_request) ==
+                                            _active_sync_requests.end()) // we've requested it in a previous iteration and we're still waiting for it to arrive
+                                        {
+                                            // then schedule a request from this peer
+                                            requests.push_back(item_to_potentially_request);
+                                            sync_items_to_request.insert(item_to_potentially_request);
                                         }
                                     }
                                 }
@@ -1140,7 +1322,9 @@ namespace graphene {
 
                         // make all the requests we scheduled in the loop above
                         for (auto sync_item_request : sync_item_requests_to_send) {
-                            request_sync_items_from_peer(sync_item_request.first, sync_item_request.second);
+                            if (!sync_item_request.second.empty()) {
+                                request_sync_items_from_peer(sync_item_request.first, sync_item_request.second);
+                            }
                         }
                         sync_item_requests_to_send.clear();
                     } else
@@ -1149,7 +1333,17 @@ namespace graphene {
                     if (!_sync_items_to_fetch_updated) {
                         dlog("no sync items to fetch right now, going to sleep");
                         _retrigger_fetch_sync_items_loop_promise = fc::promise<void>::ptr(new fc::promise<void>("graphene::network::retrigger_fetch_sync_items_loop"));
-                        _retrigger_fetch_sync_items_loop_promise->wait();
+                        try {
+                            if (_active_sync_requests.empty()) {
+                                _retrigger_fetch_sync_items_loop_promise->wait();
+                            } else {
+                                // wake up to check for overdue requests
+                                _retrigger_fetch_sync_items_loop_promise->wait(fc::milliseconds(GRAPHENE_NET_MIN_SYNC_REQUEST_OVERDUE_MS));
+                            }
+                        }
+                        catch (const fc::timeout_exception &) {
+                            dlog("Resuming fetch_sync_items_loop due to timeout -- checking for overdue sync items");
+                        }
                         _retrigger_fetch_sync_items_loop_promise.reset();
                     }
                 } // while( !canceled )
@@ -1943,6 +2137,15 @@ namespace graphene {
                     case core_message_type_enum::get_current_connections_reply_message_type:
                         on_get_current_connections_reply_message(originating_peer, received_message.as<get_current_connections_reply_message>());
                         break;
+                    case core_message_type_enum::compact_block_message_type:
+                        on_compact_block_message(originating_peer, received_message.as<compact_block_message>());
+                        break;
+                    case core_message_type_enum::fetch_block_transactions_message_type:
+                        on_fetch_block_transactions_message(originating_peer, received_message.as<fetch_block_transactions_message>());
+                        break;
+                    case core_message_type_enum::block_transactions_message_type:
+                        on_block_transactions_message(originating_peer, received_message.as<block_transactions_message>());
+                        break;
 
                     default:
                         // ignore any message in between core_message_type_first and _last that we don't handle above
@@ -1991,6 +2194,12 @@ namespace graphene {
 
                 user_data["chain_id"] = CHAIN_ID;
 
+                // old peers ignore it and never get compressed messages
+                if (_message_compression_enabled &&
+                    message_oriented_connection::is_compression_supported(message_compression::zstd)) {
+                    user_data["compression"] = std::vector<std::string>{"zstd"};
+                }
+
                 return user_data;
             }
 
@@ -2024,6 +2233,16 @@ namespace graphene {
                 if (user_data.contains("chain_id")) {
                     originating_peer->chain_id = user_data["chain_id"].as<graphene::protocol::chain_id_type>();
                 }
+                if (user_data.contains("compression") && user_data["compression"].is_array()) {
+                    // messages we send are compressed only if the peer can decompress them,
+                    // the peer decides the same for messages it sends to us
+                    const auto compressions = user_data["compression"].as<std::vector<std::string>>();
+                    if (_message_compression_enabled &&
+                        message_oriented_connection::is_compression_supported(message_compression::zstd) &&
+                        std::find(compressions.begin(), compressions.end(), "zstd") != compressions.end()) {
+                            originating_peer->enable_compression(message_compression::zstd);
+                    }
+                }
             }
 
             void node_impl::on_hello_message(peer_connection *originating_peer, const hello_message &hello_message_received) {
@@ -2843,11 +3062,23 @@ namespace graphene {
                         dlog("received item request for item ${id} from peer ${endpoint}, returning the item from my message cache",
                                 ("endpoint", originating_peer->get_remote_endpoint())
                                         ("id", requested_message.id()));
-                        reply_messages.push_back(requested_message);
                         if (fetch_items_message_received.item_type ==
                             block_message_type) {
                                 last_block_message_sent = requested_message;
+                                // blocks fetched during sync weren't relayed to the peer, their transactions are unknown to it
+                                if (_compact_blocks_enabled &&
+                                    originating_peer->core_protocol_version >= GRAPHENE_NET_COMPACT_BLOCKS_PROTOCOL_VERSION &&
+                                    !originating_peer->peer_needs_sync_items_from_us &&
+                                    originating_peer->inventory_advertised_to_peer.find(item_id(block_message_type, item_hash)) !=
+                                    originating_peer->inventory_advertised_to_peer.end()) {
+                                        // the block is being relayed now, so the peer has received most of its transactions already
+                                        reply_messages.push_back(compact_block_message(item_hash,
+                                                requested_message.as<graphene::network::block_message>().block));
+                                        ++_compact_blocks_sent;
+                                        continue;
+                                }
                         }
+                        reply_messages.push_back(requested_message);
                         continue;
                     }
                     catch (fc::key_not_found_exception &) {
@@ -2899,6 +3130,7 @@ namespace graphene {
                     originating_peer->items_requested_from_peer.end()) {
                     originating_peer->items_requested_from_peer.erase(regular_item_iter);
                     originating_peer->inventory_peer_advertised_to_us.erase(requested_item);
+                    originating_peer->compact_blocks_in_progress.erase(requested_item.item_hash);
                     if (is_item_in_any_peers_inventory(requested_item)) {
                         _items_to_fetch.insert(prioritized_item_id(requested_item, _items_to_fetch_sequence_counter++));
                     }
@@ -3097,7 +3329,10 @@ namespace graphene {
                 // received yet, reschedule them to be fetched from another peer
                 if (!originating_peer->sync_items_requested_from_peer.empty()) {
                     for (auto sync_item : originating_peer->sync_items_requested_from_peer) {
-                        _active_sync_requests.erase(sync_item);
+                        // unless it is requested from a faster peer too
+                        if (!is_sync_item_requested_from_other_peer(originating_peer, sync_item)) {
+                            _active_sync_requests.erase(sync_item);
+                        }
                     }
                     trigger_fetch_sync_items_loop();
                 }
@@ -3331,54 +3566,53 @@ namespace graphene {
                 std::map<peer_connection_ptr, fc::oexception> peers_with_rejected_block;
 
                 do {
-                    std::copy(std::make_move_iterator(_new_received_sync_items.begin()),
-                            std::make_move_iterator(_new_received_sync_items.end()),
-                            std::front_inserter(_received_sync_items));
-                    _new_received_sync_items.clear();
                     dlog("currently ${count} sync items to consider", ("count", _received_sync_items.size()));
 
+                    // the next block to process is the first block which one of peers wants us to process,
+                    // usually all peers expect the same block after our head, so it is looked up once per peer
                     block_processed_this_iteration = false;
-                    for (auto received_block_iter = _received_sync_items.begin();
-                         received_block_iter != _received_sync_items.end();
-                         ++received_block_iter) {
+                    auto received_block_iter = _received_sync_items.end();
+                    for (const peer_connection_ptr &peer : _active_connections) {
+                        ASSERT_TASK_NOT_PREEMPTED(); // don't yield while iterating over _active_connections
+                        if (!peer->ids_of_items_to_get.empty()) {
+                            received_block_iter = _received_sync_items.find(peer->ids_of_items_to_get.front());
+                            if (received_block_iter != _received_sync_items.end()) {
+                                break;
+                            }
+                        }
+                    }
 
-                        // find out if this block is the next block on the active chain or one of the forks
-                        bool potential_first_block = false;
+                    // if it is, process it, remove it from all sync peers lists
+                    if (received_block_iter != _received_sync_items.end()) {
+                        const item_hash_t block_id = received_block_iter->first;
                         for (const peer_connection_ptr &peer : _active_connections) {
                             ASSERT_TASK_NOT_PREEMPTED(); // don't yield while iterating over _active_connections
                             if (!peer->ids_of_items_to_get.empty() &&
-                                peer->ids_of_items_to_get.front() ==
-                                received_block_iter->block_id) {
-                                potential_first_block = true;
+                                peer->ids_of_items_to_get.front() == block_id) {
                                 peer->ids_of_items_to_get.pop_front();
-                                peer->ids_of_items_being_processed.insert(received_block_iter->block_id);
+                                peer->ids_of_items_being_processed.insert(block_id);
                             }
                         }
 
-                        // if it is, process it, remove it from all sync peers lists
-                        if (potential_first_block) {
-                            // we can get into an interesting situation near the end of synchronization.  We can be in
-                            // sync with one peer who is sending us the last block on the chain via a regular inventory
-                            // message, while at the same time still be synchronizing with a peer who is sending us the
-                            // block through the sync mechanism.  Further, we must request both blocks because
-                            // we don't know they're the same (for the peer in normal operation, it has only told us the
-                            // message id, for the peer in the sync case we only known the block_id).
-                            if (std::find(_most_recent_blocks_accepted.begin(), _most_recent_blocks_accepted.end(),
-                                    received_block_iter->block_id) ==
-                                _most_recent_blocks_accepted.end()) {
-                                graphene::network::block_message block_message_to_process = *received_block_iter;
-                                _received_sync_items.erase(received_block_iter);
-                                _handle_message_calls_in_progress.emplace_back(fc::async([this, block_message_to_process]() {
-                                    send_sync_block_to_node_delegate(block_message_to_process);
-                                }, "send_sync_block_to_node_delegate"));
-                                ++blocks_processed;
-                                block_processed_this_iteration = true;
-                            } else
-                                dlog("Already received and accepted this block (presumably through normal inventory mechanism), treating it as accepted");
-
-                            break; // start iterating _received_sync_items from the beginning
-                        } // end if potential_first_block
-                    } // end for each block in _received_sync_items
+                        graphene::network::block_message block_message_to_process = std::move(received_block_iter->second);
+                        _received_sync_items.erase(received_block_iter);
+                        block_processed_this_iteration = true;
+
+                        // we can get into an interesting situation near the end of synchronization.  We can be in
+                        // sync with one peer who is sending us the last block on the chain via a regular inventory
+                        // message, while at the same time still be synchronizing with a peer who is sending us the
+                        // block through the sync mechanism.  Further, we must request both blocks because
+                        // we don't know they're the same (for the peer in normal operation, it has only told us the
+                        // message id, for the peer in the sync case we only known the block_id).
+                        if (!_most_recent_blocks_accepted.contains(block_id)) {
+                            _handle_message_calls_in_progress.emplace_back(fc::async([this, block_message_to_process]() {
+                                send_sync_block_to_node_delegate(block_message_to_process);
+                            }, "send_sync_block_to_node_delegate"));
+                            ++blocks_processed;
+                        } else {
+                            dlog("Already received and accepted this block (presumably through normal inventory mechanism), treating it as accepted");
+                        }
+                    }
 
                     if (_handle_message_calls_in_progress.size() >=
                         _maximum_number_of_blocks_to_handle_at_one_time) {
@@ -3414,9 +3648,12 @@ namespace graphene {
                 VERIFY_CORRECT_THREAD();
                 dlog("received a sync block from peer ${endpoint}", ("endpoint", originating_peer->get_remote_endpoint()));
 
-                // add it to the front of _received_sync_items, then process _received_sync_items to try to
+                // the client can prepare the block while it waits for the previous ones
+                _delegate->prefetch_block(block_message_to_process);
+
+                // add it to _received_sync_items, then process _received_sync_items to try to
                 // pass as many messages as possible to the client.
-                _new_received_sync_items.push_front(block_message_to_process);
+                _received_sync_items.emplace(block_message_to_process.block_id, block_message_to_process);
                 trigger_process_backlog_of_sync_blocks();
             }
 
@@ -3438,9 +3675,7 @@ namespace graphene {
                     // we don't know they're the same (for the peer in normal operation, it has only told us the
                     // message id, for the peer in the sync case we only known the block_id).
                     fc::time_point message_validated_time;
-                    if (std::find(_most_recent_blocks_accepted.begin(), _most_recent_blocks_accepted.end(),
-                            block_message_to_process.block_id) ==
-                        _most_recent_blocks_accepted.end()) {
+                    if (!_most_recent_blocks_accepted.contains(block_message_to_process.block_id)) {
                         std::vector<fc::uint160_t> contained_transaction_message_ids;
                         _message_ids_currently_being_processed.insert(message_hash);
                         fc_ilog(fc::logger::get("sync"),
@@ -3600,8 +3835,17 @@ namespace graphene {
                         originating_peer->sync_items_requested_from_peer.end()) {
                         originating_peer->sync_items_requested_from_peer.erase(sync_item_iter);
                         originating_peer->last_sync_item_received_time = fc::time_point::now();
-                        _active_sync_requests.erase(block_message_to_process.block_id);
-                        process_block_during_sync(originating_peer, block_message_to_process, message_hash);
+                        originating_peer->sync_statistics.on_block(message_to_process.size, originating_peer->last_sync_item_received_time);
+                        originating_peer->sync_statistics.update_window(GRAPHENE_NET_MIN_BLOCKS_PER_PEER_DURING_SYNCING,
+                                _maximum_blocks_per_peer_during_syncing);
+                        if (_active_sync_requests.erase(block_message_to_process.block_id)) {
+                            process_block_during_sync(originating_peer, block_message_to_process, message_hash);
+                        } else {
+                            // the overdue block was requested from another peer too, and it was faster
+                            ++originating_peer->sync_statistics.duplicate_blocks;
+                            dlog("dropping sync block ${id} from peer ${endpoint}, it was already received from another peer",
+                                    ("id", block_message_to_process.block_id)("endpoint", originating_peer->get_remote_endpoint()));
+                        }
                         if (originating_peer->idle()) {
                             // we have finished fetching a batch of items, so we either need to grab another batch of items
                             // or we need to get another list of item ids.
@@ -3613,6 +3857,9 @@ namespace graphene {
                             } else {
                                     trigger_fetch_sync_items_loop();
                             }
+                        } else if (can_request_sync_items_from_peer(originating_peer->shared_from_this())) {
+                            // a half of the window is received, top it up
+                            trigger_fetch_sync_items_loop();
                         }
                         return;
                     }
@@ -3631,6 +3878,139 @@ namespace graphene {
                 disconnect_from_peer(originating_peer, "You sent me a block that I didn't ask for", true, detailed_error);
             }
 
+            void node_impl::on_compact_block_message(peer_connection *originating_peer,
+                    const compact_block_message &compact_block_message_received) {
+                VERIFY_CORRECT_THREAD();
+                const item_hash_t &item_hash = compact_block_message_received.item_hash;
+                // peers of the first version of compact blocks send them for sync requests too,
+                // the rebuilt block is passed to the sync path by process_block_message()
+                const bool is_requested =
+                        originating_peer->items_requested_from_peer.find(item_id(block_message_type, item_hash)) !=
+                        originating_peer->items_requested_from_peer.end() ||
+                        originating_peer->sync_items_requested_from_peer.find(compact_block_message_received.header.id()) !=
+                        originating_peer->sync_items_requested_from_peer.end();
+                if (!is_requested ||
+                    originating_peer->compact_blocks_in_progress.find(item_hash) !=
+                    originating_peer->compact_blocks_in_progress.end()) {
+                        wlog("received a compact block ${item_hash} I didn't ask for from peer ${endpoint}, disconnecting from peer",
+                                ("endpoint", originating_peer->get_remote_endpoint())("item_hash", item_hash));
+                        disconnect_from_peer(originating_peer, "You sent me a block that I didn't ask for", true,
+                                fc::exception(FC_LOG_MESSAGE(error, "You sent me a compact block that I didn't ask for, item_hash: ${item_hash}",
+                                        ("item_hash", item_hash))));
+                        return;
+                }
+                ++_compact_blocks_received;
+
+                // rebuild the block from the transactions we have relayed
+                peer_connection::compact_block_in_progress compact_block;
+                static_cast<signed_block_header &>(compact_block.block) = compact_block_message_received.header;
+                const auto &short_transaction_ids = compact_block_message_received.short_transaction_ids;
+                compact_block.block.transactions.resize(short_transaction_ids.size());
+                for (uint32_t i = 0; i < short_transaction_ids.size(); ++i) {
+                    const message *transaction_message = _message_cache.find_transaction_message(short_transaction_ids[i]);
+                    if (transaction_message) {
+                        compact_block.block.transactions[i] = transaction_message->as<trx_message>().trx;
+                    } else {
+                        compact_block.missing_transaction_indexes.push_back(i);
+                    }
+                }
+
+                if (compact_block.missing_transaction_indexes.empty()) {
+                    finish_compact_block(originating_peer, item_hash, std::move(compact_block));
+                    return;
+                }
+                dlog("fetching ${count} of ${total} transactions of compact block ${item_hash} from peer ${endpoint}",
+                        ("count", compact_block.missing_transaction_indexes.size())("total", short_transaction_ids.size())
+                                ("item_hash", item_hash)("endpoint", originating_peer->get_remote_endpoint()));
+                _compact_block_transactions_fetched += compact_block.missing_transaction_indexes.size();
+                originating_peer->send_message(fetch_block_transactions_message(item_hash, compact_block.missing_transaction_indexes));
+                originating_peer->compact_blocks_in_progress[item_hash] = std::move(compact_block);
+            }
+
+            void node_impl::on_fetch_block_transactions_message(peer_connection *originating_peer,
+                    const fetch_block_transactions_message &fetch_block_transactions_message_received) {
+                VERIFY_CORRECT_THREAD();
+                const item_hash_t &item_hash = fetch_block_transactions_message_received.item_hash;
+                graphene::network::block_message requested_block;
+                try {
+                    requested_block = _message_cache.get_message(item_hash).as<graphene::network::block_message>();
+                }
+                catch (fc::key_not_found_exception &) {
+                    // the block has left the cache, the peer will fetch the whole block from another peer
+                    originating_peer->send_message(item_not_available_message(item_id(block_message_type, item_hash)));
+                    return;
+                }
+
+                block_transactions_message reply;
+                reply.item_hash = item_hash;
+                reply.transactions.reserve(fetch_block_transactions_message_received.transaction_indexes.size());
+                for (uint32_t index : fetch_block_transactions_message_received.transaction_indexes) {
+                    if (index >= requested_block.block.transactions.size()) {
+                        disconnect_from_peer(originating_peer, "You asked me for a transaction which isn't in the block", true,
+                                fc::exception(FC_LOG_MESSAGE(error, "Invalid transaction index ${index} of block ${block_id}",
+                                        ("index", index)("block_id", requested_block.block_id))));
+                        return;
+                    }
+                    reply.transactions.push_back(requested_block.block.transactions[index]);
+                }
+                originating_peer->send_message(reply);
+            }
+
+            void node_impl::on_block_transactions_message(peer_connection *originating_peer,
+                    const block_transactions_message &block_transactions_message_received) {
+                VERIFY_CORRECT_THREAD();
+                const item_hash_t &item_hash = block_transactions_message_received.item_hash;
+                auto compact_block_iter = originating_peer->compact_blocks_in_progress.find(item_hash);
+                if (compact_block_iter == originating_peer->compact_blocks_in_progress.end()) {
+                    // the block is fetched from another peer already
+                    dlog("received transactions of block ${item_hash} I'm not waiting for from peer ${endpoint}",
+                            ("item_hash", item_hash)("endpoint", originating_peer->get_remote_endpoint()));
+                    return;
+                }
+                peer_connection::compact_block_in_progress compact_block = std::move(compact_block_iter->second);
+                originating_peer->compact_blocks_in_progress.erase(compact_block_iter);
+
+                const auto &transactions = block_transactions_message_received.transactions;
+                if (transactions.size() != compact_block.missing_transaction_indexes.size()) {
+                    disconnect_from_peer(originating_peer, "You sent me a wrong number of block transactions", true,
+                            fc::exception(FC_LOG_MESSAGE(error, "Expected ${expected} transactions of block ${item_hash}, received ${received}",
+                                    ("expected", compact_block.missing_transaction_indexes.size())
+                                            ("received", transactions.size())("item_hash", item_hash))));
+                    return;
+                }
+                for (size_t i = 0; i < transactions.size(); ++i) {
+                    compact_block.block.transactions[compact_block.missing_transaction_indexes[i]] = transactions[i];
+                }
+                finish_compact_block(originating_peer, item_hash, std::move(compact_block));
+            }
+
+            void node_impl::finish_compact_block(peer_connection *originating_peer, const item_hash_t &item_hash,
+                    peer_connection::compact_block_in_progress &&compact_block) {
+                VERIFY_CORRECT_THREAD();
+                message message_to_process = graphene::network::block_message(compact_block.block);
+                if (message_to_process.id() == item_hash) {
+                    process_block_message(originating_peer, message_to_process, item_hash);
+                    return;
+                }
+
+                const uint32_t transaction_count = compact_block.block.transactions.size();
+                if (compact_block.missing_transaction_indexes.size() == transaction_count) {
+                    disconnect_from_peer(originating_peer, "You sent me a block which doesn't match its hash", true,
+                            fc::exception(FC_LOG_MESSAGE(error, "The block rebuilt from the compact block ${item_hash} has hash ${hash}",
+                                    ("item_hash", item_hash)("hash", message_to_process.id()))));
+                    return;
+                }
+
+                // a transaction from the cache has the same short id as the one in the block, fetch all of them
+                wlog("the block rebuilt from the compact block ${item_hash} doesn't match, fetching all of its transactions from peer ${endpoint}",
+                        ("item_hash", item_hash)("endpoint", originating_peer->get_remote_endpoint()));
+                compact_block.missing_transaction_indexes.resize(transaction_count);
+                std::iota(compact_block.missing_transaction_indexes.begin(), compact_block.missing_transaction_indexes.end(), 0);
+                _compact_block_transactions_fetched += transaction_count;
+                originating_peer->send_message(fetch_block_transactions_message(item_hash, compact_block.missing_transaction_indexes));
+                originating_peer->compact_blocks_in_progress[item_hash] = std::move(compact_block);
+            }
+
             void node_impl::on_current_time_request_message(peer_connection *originating_peer,
                     const current_time_request_message &current_time_request_message_received) {
                 VERIFY_CORRECT_THREAD();
@@ -4734,7 +5114,6 @@ namespace graphene {
                 ilog("--------- MEMORY USAGE ------------");
                 ilog("node._active_sync_requests size: ${size}", ("size", _active_sync_requests.size()));
                 ilog("node._received_sync_items size: ${size}", ("size", _received_sync_items.size()));
-                ilog("node._new_received_sync_items size: ${size}", ("size", _new_received_sync_items.size()));
                 ilog("node._items_to_fetch size: ${size}", ("size", _items_to_fetch.size()));
                 ilog("node._new_inventory size: ${size}", ("size", _new_inventory.size()));
                 ilog("node._message_cache size: ${size}", ("size", _message_cache.size()));
@@ -4891,6 +5270,10 @@ namespace graphene {
                     peer_details["current_head_block"] = peer->last_block_delegate_has_seen;
                     peer_details["current_head_block_number"] = _delegate->get_block_number(peer->last_block_delegate_has_seen);
                     peer_details["current_head_block_time"] = peer->last_block_time_delegate_has_seen;
+                    peer_details["sync_statistics"] = peer->sync_statistics.to_variant_object();
+                    peer_details["compression"] = peer->get_compression();
+                    peer_details["compression_statistics"] = peer->get_compression_statistics();
+                    peer_details["send_queues"] = peer->get_send_queue_statistics();
 
                     this_peer_status.info = peer_details;
                     statuses.push_back(this_peer_status);
@@ -4978,6 +5361,13 @@ namespace graphene {
                 if (params.contains("maximum_blocks_per_peer_during_syncing")) {
                     _maximum_blocks_per_peer_during_syncing = params["maximum_blocks_per_peer_during_syncing"].as<uint32_t>();
                 }
+                if (params.contains("message_compression")) {
+                    // applies to new connections
+                    _message_compression_enabled = params["message_compression"].as<bool>();
+                }
+                if (params.contains("compact_blocks")) {
+                    _compact_blocks_enabled = params["compact_blocks"].as<bool>();
+                }
 
                 _desired_number_of_connections = std::min(_desired_number_of_connections, _maximum_number_of_connections);
 
@@ -4998,6 +5388,8 @@ namespace graphene {
                 result["maximum_number_of_blocks_to_handle_at_one_time"] = _maximum_number_of_blocks_to_handle_at_one_time;
                 result["maximum_number_of_sync_blocks_to_prefetch"] = _maximum_number_of_sync_blocks_to_prefetch;
                 result["maximum_blocks_per_peer_during_syncing"] = _maximum_blocks_per_peer_during_syncing;
+                result["message_compression"] = _message_compression_enabled;
+                result["compact_blocks"] = _compact_blocks_enabled;
                 return result;
             }
 
@@ -5064,6 +5456,22 @@ namespace graphene {
                 info["node_public_key"] = _node_public_key;
                 info["node_id"] = _node_id;
                 info["firewalled"] = _is_firewalled;
+
+                uint32_t sync_peers = 0;
+                double sync_blocks_per_second = 0;
+                for (const peer_connection_ptr &peer : _active_connections) {
+                    if (peer->we_need_sync_items_from_peer) {
+                        ++sync_peers;
+                        sync_blocks_per_second += peer->sync_statistics.blocks_per_second();
+                    }
+                }
+                info["sync_peers"] = sync_peers;
+                info["sync_blocks_per_second"] = sync_blocks_per_second;
+                info["sync_blocks_requested"] = _active_sync_requests.size();
+                info["sync_blocks_received"] = _received_sync_items.size();
+                info["compact_blocks_sent"] = _compact_blocks_sent;
+                info["compact_blocks_received"] = _compact_blocks_received;
+                info["compact_block_transactions_fetched"] = _compact_block_transactions_fetched;
                 return info;
             }
 
@@ -5412,6 +5820,11 @@ namespace graphene {
                 INVOKE_AND_COLLECT_STATISTICS(handle_block, block_message, sync_mode, contained_transaction_message_ids);
             }
 
+            void statistics_gathering_node_delegate_wrapper::prefetch_block(const graphene::network::block_message &block_message) {
+                // the delegate handles it on any thread, so the node doesn't wait for the thread of the delegate
+                _node_delegate->prefetch_block(block_message);
+            }
+
             void statistics_gathering_node_delegate_wrapper::handle_transaction(const graphene::network::trx_message &transaction_message) {
                 INVOKE_AND_COLLECT_STATISTICS(handle_transaction, transaction_message);
             }
@@ -23,7 +23,10 @@
  */
 #include <graphene/network/peer_connection.hpp>
 
+#include <algorithm>
+
 #include <fc/thread/thread.hpp>
+#include <fc/variant_object.hpp>
 
 #ifdef DEFAULT_LOGGER
 # undef DEFAULT_LOGGER
@@ -38,6 +41,52 @@
 
 namespace graphene {
     namespace network {
+        static send_queue_priority priority_of_item(uint32_t item_type) {
+            return item_type == block_message_type ? send_queue_priority::blocks : send_queue_priority::transactions;
+        }
+
+        /// the item type is the first field of the inventory, fetch_items and item_not_available messages
+        static uint32_t item_type_of_message(const message &message_to_send) {
+            uint32_t item_type = 0;
+            fc::datastream<const char *> stream(message_to_send.data.data(), message_to_send.data.size());
+            fc::raw::unpack(stream, item_type);
+            return item_type;
+        }
+
+        static send_queue_priority priority_of_message(const message &message_to_send) {
+            switch (message_to_send.msg_type) {
+                case core_message_type_enum::hello_message_type:
+                case core_message_type_enum::connection_accepted_message_type:
+                case core_message_type_enum::connection_rejected_message_type:
+                case core_message_type_enum::block_message_type:
+                case core_message_type_enum::compact_block_message_type:
+                case core_message_type_enum::fetch_block_transactions_message_type:
+                case core_message_type_enum::block_transactions_message_type:
+                case core_message_type_enum::fetch_blockchain_item_ids_message_type:
+                case core_message_type_enum::blockchain_item_ids_inventory_message_type:
+                    return send_queue_priority::blocks;
+                case core_message_type_enum::trx_message_type:
+                    return send_queue_priority::transactions;
+                case core_message_type_enum::item_ids_inventory_message_type:
+                case core_message_type_enum::fetch_items_message_type:
+                case core_message_type_enum::item_not_available_message_type:
+                    return priority_of_item(item_type_of_message(message_to_send));
+                default:
+                    return send_queue_priority::housekeeping;
+            }
+        }
+
+        static size_t maximum_queued_bytes(send_queue_priority priority) {
+            switch (priority) {
+                case send_queue_priority::blocks:
+                    return GRAPHENE_NET_MAXIMUM_QUEUED_BLOCK_MESSAGES_IN_BYTES;
+                case send_queue_priority::transactions:
+                    return GRAPHENE_NET_MAXIMUM_QUEUED_TRANSACTION_MESSAGES_IN_BYTES;
+                default:
+                    return GRAPHENE_NET_MAXIMUM_QUEUED_HOUSEKEEPING_MESSAGES_IN_BYTES;
+            }
+        }
+
         message peer_connection::real_queued_message::get_message(peer_connection_delegate *) {
             if (message_send_time_field_offset != (size_t)-1) {
                 // patch the current time into the message.  Since this operates on the packed version of the structure,
@@ -68,7 +117,6 @@ namespace graphene {
         peer_connection::peer_connection(peer_connection_delegate *delegate) :
                 _node(delegate),
                 _message_connection(this),
-                _total_queued_messages_size(0),
                 direction(peer_connection_direction::unknown),
                 is_firewalled(firewalled_state::unknown),
                 our_state(our_connection_state::disconnected),
@@ -269,9 +317,27 @@ namespace graphene {
                     --_send_message_queue_tasks_counter; /* dlog("leaving peer_connection::send_queued_messages_task()"); */ }
             } concurrent_invocation_counter(_send_message_queue_tasks_running);
 #endif
-            while (!_queued_messages.empty()) {
-                _queued_messages.front()->transmission_start_time = fc::time_point::now();
-                message message_to_send = _queued_messages.front()->get_message(_node);
+            while (true) {
+                auto queue_iter = std::find_if(_send_queues.begin(), _send_queues.end(),
+                        [](const send_queue &queue) { return !queue.messages.empty(); });
+                if (queue_iter == _send_queues.end()) {
+                    break;
+                }
+                send_queue &queue = *queue_iter;
+                _message_being_sent = std::move(queue.messages.front());
+                queue.messages.pop_front();
+
+                _message_being_sent->transmission_start_time = fc::time_point::now();
+                if (_message_being_sent->droppable &&
+                    _message_being_sent->transmission_start_time - _message_being_sent->enqueue_time >
+                    fc::seconds(GRAPHENE_NET_MAXIMUM_TRANSACTION_INVENTORY_QUEUE_TIME)) {
+                        queue.statistics.queued_bytes -= _message_being_sent->get_size_in_queue();
+                        --queue.statistics.queued_messages;
+                        ++queue.statistics.messages_dropped;
+                        _message_being_sent.reset();
+                        continue;
+                }
+                message message_to_send = _message_being_sent->get_message(_node);
                 try {
                     //dlog("peer_connection::send_queued_messages_task() calling message_oriented_connection::send_message() "
                     //     "to send message of type ${type} for peer ${endpoint}",
@@ -300,21 +366,30 @@ namespace graphene {
                 catch (...) {
                     elog("message_oriented_exception::send_message() threw an unhandled exception");
                 }
-                _queued_messages.front()->transmission_finish_time = fc::time_point::now();
-                _total_queued_messages_size -= _queued_messages.front()->get_size_in_queue();
-                _queued_messages.pop();
+                _message_being_sent->transmission_finish_time = fc::time_point::now();
+                queue.statistics.queued_bytes -= _message_being_sent->get_size_in_queue();
+                --queue.statistics.queued_messages;
+                ++queue.statistics.messages_sent;
+                _message_being_sent.reset();
             }
             //dlog("leaving peer_connection::send_queued_messages_task() due to queue exhaustion");
         }
 
         void peer_connection::send_queueable_message(std::unique_ptr<queued_message> &&message_to_send) {
             VERIFY_CORRECT_THREAD();
-            _total_queued_messages_size += message_to_send->get_size_in_queue();
-            _queued_messages.emplace(std::move(message_to_send));
-            if (_total_queued_messages_size >
-                GRAPHENE_NET_MAXIMUM_QUEUED_MESSAGES_IN_BYTES) {
-                elog("send queue exceeded maximum size of ${max} bytes (current size ${current} bytes)",
-                        ("max", GRAPHENE_NET_MAXIMUM_QUEUED_MESSAGES_IN_BYTES)("current", _total_queued_messages_size));
+            const send_queue_priority priority = message_to_send->priority;
+            const size_t maximum_size = maximum_queued_bytes(priority);
+            send_queue &queue = _send_queues[static_cast<size_t>(priority)];
+            queue.statistics.queued_bytes += message_to_send->get_size_in_queue();
+            ++queue.statistics.queued_messages;
+            queue.messages.emplace_back(std::move(message_to_send));
+            if (queue.statistics.queued_bytes > maximum_size) {
+                // the peer can learn about transactions from other peers, so their inventory goes first
+                drop_transaction_inventory(queue, maximum_size);
+            }
+            if (queue.statistics.queued_bytes > maximum_size) {
+                elog("send queue of ${priority} messages exceeded maximum size of ${max} bytes (current size ${current} bytes)",
+                        ("priority", priority)("max", maximum_size)("current", queue.statistics.queued_bytes));
                 try {
                     close_connection();
                 }
@@ -342,6 +417,9 @@ namespace graphene {
             //dlog("peer_connection::send_message() enqueueing message of type ${type} for peer ${endpoint}",
             //     ("type", message_to_send.msg_type)("endpoint", get_remote_endpoint()));
             std::unique_ptr<queued_message> message_to_enqueue(new real_queued_message(message_to_send, message_send_time_field_offset));
+            message_to_enqueue->priority = priority_of_message(message_to_send);
+            message_to_enqueue->droppable = message_to_send.msg_type == core_message_type_enum::item_ids_inventory_message_type &&
+                                            message_to_enqueue->priority == send_queue_priority::transactions;
             send_queueable_message(std::move(message_to_enqueue));
         }
 
@@ -350,9 +428,26 @@ namespace graphene {
             //dlog("peer_connection::send_item() enqueueing message of type ${type} for peer ${endpoint}",
             //     ("type", item_to_send.item_type)("endpoint", get_remote_endpoint()));
             std::unique_ptr<queued_message> message_to_enqueue(new virtual_queued_message(item_to_send));
+            message_to_enqueue->priority = priority_of_item(item_to_send.item_type);
             send_queueable_message(std::move(message_to_enqueue));
         }
 
+        void peer_connection::drop_transaction_inventory(send_queue &queue, size_t maximum_size) {
+            VERIFY_CORRECT_THREAD();
+            auto iter = queue.messages.begin();
+            while (iter != queue.messages.end() &&
+                   queue.statistics.queued_bytes > maximum_size) {
+                if ((*iter)->droppable) {
+                    queue.statistics.queued_bytes -= (*iter)->get_size_in_queue();
+                    --queue.statistics.queued_messages;
+                    ++queue.statistics.messages_dropped;
+                    iter = queue.messages.erase(iter);
+                } else {
+                    ++iter;
+                }
+            }
+        }
+
         void peer_connection::close_connection() {
             VERIFY_CORRECT_THREAD();
             negotiation_status = connection_negotiation_status::closing;
@@ -425,6 +520,31 @@ namespace graphene {
             return _message_connection.get_shared_secret();
         }
 
+        void peer_connection::enable_compression(message_compression compression) {
+            VERIFY_CORRECT_THREAD();
+            _message_connection.enable_compression(compression, GRAPHENE_NET_MIN_COMPRESSED_MESSAGE_SIZE);
+        }
+
+        message_compression peer_connection::get_compression() const {
+            VERIFY_CORRECT_THREAD();
+            return _message_connection.get_compression();
+        }
+
+        const message_compression_statistics &peer_connection::get_compression_statistics() const {
+            VERIFY_CORRECT_THREAD();
+            return _message_connection.get_compression_statistics();
+        }
+
+        fc::variant_object peer_connection::get_send_queue_statistics() const {
+            VERIFY_CORRECT_THREAD();
+            fc::mutable_variant_object result;
+            for (size_t i = 0; i < _send_queues.size(); ++i) {
+                result[fc::reflector<send_queue_priority>::to_string(static_cast<send_queue_priority>(i))] =
+                        _send_queues[i].statistics;
+            }
+            return result;
+        }
+
         void peer_connection::clear_old_inventory() {
             VERIFY_CORRECT_THREAD();
             fc::time_point_sec oldest_inventory_to_keep(fc::time_point::now() -
@@ -472,6 +592,64 @@ namespace graphene {
                    firewall_check_state->requesting_peer != node_id_t();
         }
 
+        static fc::microseconds smooth(fc::microseconds average, fc::microseconds sample) {
+            if (average.count() == 0) {
+                return sample;
+            }
+            return fc::microseconds((average.count() * 7 + sample.count()) / 8);
+        }
+
+        void peer_sync_statistics::on_request(size_t outstanding, fc::time_point now) {
+            if (outstanding == 0) {
+                first_request_time = now;
+            }
+        }
+
+        void peer_sync_statistics::on_block(uint32_t size, fc::time_point now) {
+            if (first_request_time != fc::time_point()) {
+                round_trip_time = smooth(round_trip_time, now - first_request_time);
+                first_request_time = fc::time_point();
+            } else if (last_block_time != fc::time_point()) {
+                block_interval = smooth(block_interval, now - last_block_time);
+            }
+            last_block_time = now;
+            ++blocks_received;
+            bytes_received += size;
+        }
+
+        void peer_sync_statistics::update_window(uint32_t min_window, uint32_t max_window) {
+            min_window = std::min(min_window, max_window);
+            if (block_interval.count() <= 0) {
+                window = std::max(std::min(window, max_window), min_window);
+                return;
+            }
+            // the window covers the round trip and the time of delivery, so the peer doesn't wait for requests
+            const int64_t duration = fc::milliseconds(GRAPHENE_NET_SYNC_WINDOW_DURATION_MS).count() + round_trip_time.count();
+            const int64_t blocks = duration / block_interval.count();
+            window = uint32_t(std::max<int64_t>(min_window, std::min<int64_t>(max_window, blocks)));
+        }
+
+        fc::microseconds peer_sync_statistics::expected_delivery_time(size_t outstanding) const {
+            return round_trip_time + fc::microseconds(block_interval.count() * int64_t(outstanding));
+        }
+
+        double peer_sync_statistics::blocks_per_second() const {
+            return block_interval.count() > 0 ? 1000000.0 / block_interval.count() : 0;
+        }
+
+        fc::variant_object peer_sync_statistics::to_variant_object() const {
+            fc::mutable_variant_object result;
+            result["window"] = window;
+            result["round_trip_time_ms"] = round_trip_time.count() / 1000;
+            result["blocks_per_second"] = blocks_per_second();
+            result["blocks_received"] = blocks_received;
+            result["bytes_received"] = bytes_received;
+            result["duplicate_blocks"] = duplicate_blocks;
+            result["requests_reissued"] = requests_reissued;
+            result["requests_overdue"] = requests_overdue;
+            return result;
+        }
+
         fc::optional<fc::ip::endpoint> peer_connection::get_endpoint_for_connecting() const {
             if (inbound_port) {
                 return fc::ip::endpoint(inbound_address, inbound_port);
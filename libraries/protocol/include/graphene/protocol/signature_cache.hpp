@@ -0,0 +1,75 @@
+#pragma once
+
+#include <graphene/protocol/types.hpp>
+
+#include <array>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace graphene { namespace protocol {
+
+    struct signature_cache_stats {
+        uint64_t capacity = 0;
+        uint64_t size = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+
+    /**
+     * Bounded LRU cache of public keys recovered from signatures.
+     *
+     * The same transaction is validated several times: on receiving via API or p2p,
+     * on generating of a block and on applying of a block. The cache allows to make
+     * ECDSA recovery only once for each pair of (signature digest, signature).
+     *
+     * The cache is splitted into shards with own locks to reduce contention between threads.
+     * Capacity 0 disables the cache.
+     */
+    class signature_cache final {
+    public:
+        static signature_cache& instance();
+
+        void set_capacity(std::size_t capacity);
+
+        std::size_t capacity() const;
+
+        /**
+         * Returns public key for the signature from the cache or recovers it
+         */
+        public_key_type recover(const digest_type& digest, const signature_type& signature);
+
+        signature_cache_stats get_stats() const;
+
+    private:
+        signature_cache() = default;
+
+        using key_type = std::pair<digest_type, signature_type>;
+
+        struct key_hash {
+            std::size_t operator()(const key_type& key) const;
+        };
+
+        struct shard {
+            using lru_list = std::list<std::pair<key_type, public_key_type>>;
+
+            mutable std::mutex mutex;
+            lru_list items;
+            std::unordered_map<key_type, lru_list::iterator, key_hash> index;
+        };
+
+        static constexpr std::size_t shard_count = 16;
+
+        shard& get_shard(const key_type& key);
+
+        std::array<shard, shard_count> _shards;
+        std::atomic<std::size_t> _shard_capacity{0};
+
+        std::atomic<uint64_t> _hits{0};
+        std::atomic<uint64_t> _misses{0};
+    };
+
+} } // graphene::protocol
+
+FC_REFLECT((graphene::protocol::signature_cache_stats), (capacity)(size)(hits)(misses))
@@ -0,0 +1,91 @@
+#include <graphene/protocol/signature_cache.hpp>
+
+#include <cstring>
+
+namespace graphene { namespace protocol {
+
+    signature_cache& signature_cache::instance() {
+        static signature_cache cache;
+        return cache;
+    }
+
+    std::size_t signature_cache::key_hash::operator()(const key_type& key) const {
+        // digests and signatures are uniformly distributed, so a part of their bytes is enough
+        std::size_t digest_part;
+        std::size_t signature_part;
+        std::memcpy(&digest_part, key.first.data(), sizeof(digest_part));
+        std::memcpy(&signature_part, key.second.begin() + 1, sizeof(signature_part));
+        return digest_part ^ signature_part;
+    }
+
+    signature_cache::shard& signature_cache::get_shard(const key_type& key) {
+        return _shards[key_hash()(key) % shard_count];
+    }
+
+    void signature_cache::set_capacity(std::size_t capacity) {
+        std::size_t shard_capacity = (capacity + shard_count - 1) / shard_count;
+        _shard_capacity = shard_capacity;
+
+        for (auto& s: _shards) {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            while (s.items.size() > shard_capacity) {
+                s.index.erase(s.items.back().first);
+                s.items.pop_back();
+            }
+        }
+    }
+
+    std::size_t signature_cache::capacity() const {
+        return _shard_capacity * shard_count;
+    }
+
+    public_key_type signature_cache::recover(const digest_type& digest, const signature_type& signature) {
+        const std::size_t shard_capacity = _shard_capacity;
+        if (!shard_capacity) {
+            return fc::ecc::public_key(signature, digest);
+        }
+
+        key_type key(digest, signature);
+        auto& s = get_shard(key);
+
+        {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            auto itr = s.index.find(key);
+            if (itr != s.index.end()) {
+                s.items.splice(s.items.begin(), s.items, itr->second);
+                ++_hits;
+                return itr->second->second;
+            }
+        }
+
+        ++_misses;
+
+        // recovery is the expensive part, it shouldn't block other threads
+        public_key_type result = fc::ecc::public_key(signature, digest);
+
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (s.index.find(key) == s.index.end()) {
+            s.items.emplace_front(key, result);
+            s.index.emplace(std::move(key), s.items.begin());
+
+            while (s.items.size() > shard_capacity) {
+                s.index.erase(s.items.back().first);
+                s.items.pop_back();
+            }
+        }
+        return result;
+    }
+
+    signature_cache_stats signature_cache::get_stats() const {
+        signature_cache_stats result;
+        result.capacity = capacity();
+        result.hits = _hits;
+        result.misses = _misses;
+        for (const auto& s: _shards) {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            result.size += s.items.size();
+        }
+        return result;
+    }
+
+} } // graphene::protocol
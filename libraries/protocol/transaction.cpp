@@ -1,6 +1,7 @@
 
 #include <graphene/protocol/transaction.hpp>
 #include <graphene/protocol/exceptions.hpp>
+#include <graphene/protocol/signature_cache.hpp>
 
 #include <fc/bitutil.hpp>
 #include <fc/smart_ref_impl.hpp>
@@ -225,10 +226,11 @@ namespace graphene {
         flat_set<public_key_type> signed_transaction::get_signature_keys(const chain_id_type &chain_id) const {
             try {
                 auto d = sig_digest(chain_id);
+                auto &cache = signature_cache::instance();
                 flat_set<public_key_type> result;
                 for (const auto &sig : signatures) {
                     CHAIN_ASSERT(
-                        result.insert(fc::ecc::public_key(sig, d)).second,
+                        result.insert(cache.recover(d, sig)).second,
                         tx_duplicate_sig,
                         "Duplicate Signature detected");
                 }
@@ -51,6 +51,7 @@ namespace graphene { namespace plugins { namespace account_history {
     using plugins::json_rpc::msg_pack_transfer;
 
     DEFINE_API_ARGS(get_account_history, msg_pack, get_account_history_return_type)
+    DEFINE_API_ARGS(subscribe_operations, msg_pack, void_type)
 
    /**
     *  This plugin is designed to track a range of operations by account so that one node
@@ -88,6 +89,15 @@ namespace graphene { namespace plugins { namespace account_history {
              *  @param limit - the maximum number of items that can be queried (0 to 1000], must be less than from
              */
             (get_account_history)
+
+            /**
+             *  Subscribes the websocket connection to operations of applied blocks, each operation is sent
+             *  as applied_operation with the id of the request until the connection is closed.
+             *
+             *  @param types - names of operations (transfer or transfer_operation), empty array means all operations
+             *  @param accounts - operations which impact any of the accounts are sent, empty array means all accounts
+             */
+            (subscribe_operations)
         )
 
     private:
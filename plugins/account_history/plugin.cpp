@@ -16,6 +16,28 @@ namespace graphene { namespace plugins { namespace account_history {
     struct operation_visitor_filter;
     void operation_get_impacted_accounts(const operation &op, flat_set<graphene::chain::account_name_type> &result);
 
+    /// transfer_operation and graphene::protocol::transfer_operation are transfer
+    std::string operation_type_name(std::string name) {
+        static const std::string prefix = "graphene::protocol::";
+        static const std::string suffix = "_operation";
+        if (name.compare(0, prefix.size(), prefix) == 0) {
+            name.erase(0, prefix.size());
+        }
+        if (name.size() > suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0) {
+            name.erase(name.size() - suffix.size());
+        }
+        return name;
+    }
+
+    struct operation_name_visitor final {
+        using result_type = std::string;
+
+        template<typename T>
+        std::string operator()(const T&) const {
+            return operation_type_name(fc::get_typename<T>::name());
+        }
+    };
+
 using namespace graphene::protocol;
 using namespace graphene::chain;
 //
@@ -113,10 +135,85 @@ if( options.count(name) ) { \
             return result;
         }
 
+        /// operations of a failed block or of pending transactions are dropped on start of the next block
+        void clear_operations() {
+            block_operations.clear();
+        }
+
+        /// operations are published after their block is applied, so operations of pending transactions are skipped
+        void collect_operation(const graphene::chain::operation_notification& note) {
+            if (!subscriptions->has_subscribers(operation_channel)) {
+                return;
+            }
+
+            auto op = std::make_shared<applied_operation>();
+            op->trx_id = note.trx_id;
+            op->block = note.block;
+            op->trx_in_block = note.trx_in_block;
+            op->op_in_trx = note.op_in_trx;
+            op->virtual_op = note.virtual_op;
+            op->timestamp = database.head_block_time();
+            op->op = note.op;
+            block_operations.push_back(std::move(op));
+        }
+
+        void publish_operations(const signed_block& block) {
+            const auto block_num = block.block_num();
+            for (auto& op: block_operations) {
+                // operations of pending transactions have the number of the previous block
+                if (op->block != block_num) {
+                    continue;
+                }
+                subscriptions->publish(operation_channel, [op](json_rpc::subscription_event& event) {
+                    event.type = op->op.visit(operation_name_visitor());
+
+                    fc::flat_set<graphene::chain::account_name_type> impacted;
+                    operation_get_impacted_accounts(op->op, impacted);
+                    for (const auto& account: impacted) {
+                        event.accounts.insert(std::string(account));
+                    }
+
+                    json_rpc::json_writer writer;
+                    writer.write(*op);
+                    event.payload = std::make_shared<const std::string>(writer.release());
+                    return true;
+                });
+            }
+            block_operations.clear();
+        }
+
         fc::flat_map<std::string, std::string> tracked_accounts;
         graphene::chain::database& database;
+
+        json_rpc::subscription_hub* subscriptions = nullptr;
+        json_rpc::subscription_hub::channel_type operation_channel = 0;
+        std::vector<std::shared_ptr<applied_operation>> block_operations;
     };
 
+    DEFINE_API(plugin, subscribe_operations) {
+        CHECK_ARG_SIZE(2)
+
+        json_rpc::subscription_filter filter;
+        for (const auto& type: args.args->at(0).as<std::vector<std::string>>()) {
+            filter.types.insert(operation_type_name(type));
+        }
+        for (const auto& account: args.args->at(1).as<std::vector<std::string>>()) {
+            filter.accounts.insert(account);
+        }
+
+        auto connection = args.connection();
+        FC_ASSERT(connection, "Subscriptions require a websocket connection");
+        auto id = args.rpc_id();
+        pimpl->subscriptions->subscribe(
+            pimpl->operation_channel, std::move(connection), fc::json::to_string(id.valid() ? *id : fc::variant()),
+            std::move(filter));
+
+        // operations are responded by the subscription hub
+        msg_pack_transfer transfer(args);
+        transfer.complete();
+        return {};
+    }
+
     DEFINE_API(plugin, get_account_history) {
         CHECK_ARG_SIZE(3)
         auto account = args.args->at(0).as<std::string>();
@@ -390,18 +487,35 @@ if( options.count(name) ) { \
         ilog("account_history plugin: plugin_initialize() begin");
         pimpl = std::make_unique<plugin_impl>();
         // this is worked, because the appbase initialize required plugins at first
-        pimpl->database.pre_apply_operation.connect([&](graphene::chain::operation_notification& note){
-            pimpl->on_operation(note);
-        });
+        pimpl->database.pre_apply_operation.connect(pimpl->database.timed_handler(
+            "account_history.pre_apply_operation", [&](graphene::chain::operation_notification& note){
+                pimpl->on_operation(note);
+            }));
 
         graphene::chain::add_plugin_index<account_history_index>(pimpl->database);
 
+        pimpl->subscriptions = &appbase::app().get_plugin<json_rpc::plugin>().subscriptions();
+        pimpl->operation_channel = pimpl->subscriptions->add_channel("operations");
+        pimpl->database.pre_apply_block.connect(pimpl->database.timed_handler(
+            "account_history.clear_operations", [&](const signed_block&) {
+                pimpl->clear_operations();
+            }));
+        pimpl->database.post_apply_operation.connect(pimpl->database.timed_handler(
+            "account_history.collect_operation", [&](const graphene::chain::operation_notification& note) {
+                pimpl->collect_operation(note);
+            }));
+        pimpl->database.applied_block.connect(pimpl->database.timed_handler(
+            "account_history.publish_operations", [&](const signed_block& block) {
+                pimpl->publish_operations(block);
+            }));
+
         using pairstring = std::pair<std::string, std::string>;
         LOAD_VALUE_SET(options, "track-account-range", pimpl->tracked_accounts, pairstring);
 
         ilog("account_history: tracked_accounts ${s}", ("s", pimpl->tracked_accounts));
 
         JSON_RPC_REGISTER_API(name());
+        JSON_RPC_REGISTER_BINARY_METHODS(name(), (get_account_history))
         ilog("account_history plugin: plugin_initialize() end");
     }
 
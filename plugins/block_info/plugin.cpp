@@ -137,11 +137,25 @@ void plugin::plugin_initialize(const boost::program_options::variables_map &opti
 
     my.reset(new plugin_impl);
 
-    my->applied_block_conn_ = db.applied_block.connect([this](const protocol::signed_block &b) {
-        on_applied_block(b);
-    });
+    my->applied_block_conn_ = db.applied_block.connect(db.timed_handler("block_info.applied_block",
+        [this](const protocol::signed_block &b) {
+            on_applied_block(b);
+        }));
 
     JSON_RPC_REGISTER_API ( name() ) ;
+
+    // the range of blocks can't change when its last block is irreversible
+    auto is_irreversible_range = [this](const json_rpc::msg_pack &args) {
+        auto start_block_num = args.args->at(0).as<uint32_t>();
+        auto count = args.args->at(1).as<uint32_t>();
+        auto &db = my->database();
+        return count > 0 && db.with_weak_read_lock([&]() {
+            return uint64_t(start_block_num) + count - 1 <= db.last_non_undoable_block_num();
+        });
+    };
+    auto &json_rpc_plugin = appbase::app().get_plugin<json_rpc::plugin>();
+    json_rpc_plugin.set_cacheable_method(name(), "get_block_info", is_irreversible_range);
+    json_rpc_plugin.set_cacheable_method(name(), "get_blocks_with_info", is_irreversible_range);
 }
 
 void plugin::plugin_startup() {
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <boost/program_options.hpp>
+#include <appbase/application.hpp>
+#include <graphene/plugins/chain/plugin.hpp>
+#include <graphene/plugins/json_rpc/utility.hpp>
+#include <graphene/plugins/json_rpc/plugin.hpp>
+#include <graphene/chain/block_timing.hpp>
+
+namespace graphene {
+namespace plugins {
+namespace block_timing_api {
+
+using graphene::plugins::json_rpc::msg_pack;
+
+/**
+ * Histograms of block application time from the rolling window, see block-timing options of the chain plugin.
+ * The optional argument is a prefix of names: "block", "phase.", "operation." or "plugin.".
+ */
+DEFINE_API_ARGS ( get_block_timing, msg_pack, graphene::chain::block_timing_report )
+
+class plugin final : public appbase::plugin<plugin> {
+public:
+    APPBASE_PLUGIN_REQUIRES(
+        (chain::plugin)
+        (json_rpc::plugin)
+    )
+
+    constexpr const static char *plugin_name = "block_timing_api";
+
+    static const std::string &name() {
+        static std::string name = plugin_name;
+        return name;
+    }
+
+    plugin();
+
+    ~plugin();
+
+    void set_program_options(
+        boost::program_options::options_description &cli,
+        boost::program_options::options_description &cfg) override {
+    }
+
+    void plugin_initialize(const boost::program_options::variables_map &options) override;
+
+    void plugin_startup() override;
+
+    void plugin_shutdown() override;
+
+    DECLARE_API (
+        (get_block_timing)
+    )
+
+private:
+    struct plugin_impl;
+
+    std::unique_ptr<plugin_impl> my;
+};
+
+} } } // graphene::plugins::block_timing_api
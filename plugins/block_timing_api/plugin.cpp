@@ -0,0 +1,62 @@
+#include <graphene/plugins/block_timing_api/plugin.hpp>
+#include <graphene/chain/database.hpp>
+
+#include <algorithm>
+
+namespace graphene {
+namespace plugins {
+namespace block_timing_api {
+
+struct plugin::plugin_impl {
+public:
+    plugin_impl() : db_(appbase::app().get_plugin<plugins::chain::plugin>().db()) {
+    }
+
+    graphene::chain::block_timing_report get_block_timing(const std::string &prefix) const;
+
+private:
+    graphene::chain::database & db_;
+};
+
+graphene::chain::block_timing_report plugin::plugin_impl::get_block_timing(const std::string &prefix) const {
+    // the report has own lock, so the database lock isn't needed
+    auto result = db_.get_block_timing().report();
+    if (!prefix.empty()) {
+        result.stats.erase(
+            std::remove_if(result.stats.begin(), result.stats.end(), [&](const auto &stat) {
+                return stat.name.compare(0, prefix.size(), prefix) != 0;
+            }),
+            result.stats.end());
+    }
+    return result;
+}
+
+DEFINE_API ( plugin, get_block_timing ) {
+    std::string prefix;
+    if (args.args.valid() && !args.args->empty()) {
+        prefix = args.args->at(0).as<std::string>();
+    }
+    return my->get_block_timing(prefix);
+}
+
+plugin::plugin() {
+}
+
+plugin::~plugin() {
+}
+
+void plugin::plugin_initialize(const boost::program_options::variables_map &options) {
+    my.reset(new plugin_impl);
+    JSON_RPC_REGISTER_API ( name() ) ;
+}
+
+void plugin::plugin_startup() {
+    if (!appbase::app().get_plugin<plugins::chain::plugin>().db().get_block_timing().enabled()) {
+        wlog("block_timing_api: block timing is disabled, enable it by block-timing option");
+    }
+}
+
+void plugin::plugin_shutdown() {
+}
+
+} } } // graphene::plugins::block_timing_api
@@ -43,6 +43,13 @@ namespace graphene {
 
                 bool accept_block(const protocol::signed_block &block, bool currently_syncing = false, uint32_t skip = 0);
 
+                /**
+                 * Starts recovery of keys from signatures of the block on the recovery threads and returns at once,
+                 * the keys are kept in the signature cache for accept_block(). It is called for received blocks
+                 * which wait for their turn, so keys are recovered ahead of applying. It can be called from any thread.
+                 */
+                void prefetch_signature_keys(const protocol::signed_block &block, uint32_t skip = 0);
+
                 void accept_transaction(const protocol::signed_transaction &trx);
 
                 bool block_is_on_preferred_chain(const protocol::block_id_type &block_id);
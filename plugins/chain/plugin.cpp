@@ -8,7 +8,14 @@
 #include <iostream>
 #include <graphene/protocol/protocol.hpp>
 #include <graphene/protocol/types.hpp>
+#include <graphene/protocol/signature_cache.hpp>
 #include <future>
+#include <atomic>
+#include <mutex>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
 
 namespace graphene {
 namespace plugins {
@@ -48,12 +55,38 @@ namespace chain {
 
         uint32_t block_num_check_free_size = 0;
 
+        uint32_t replay_decode_threads = 0;
+        uint32_t replay_checkpoint_interval = 0;
+        uint32_t replay_snapshot_interval = 0;
+
+        bool block_timing = false;
+        uint32_t block_timing_window = 0;
+        uint32_t block_timing_log_interval = 0;
+        uint32_t block_timing_budget_ms = 0;
+
+        graphene::chain::block_log_options block_log_options;
+        bool convert_block_log = false;
+
+        boost::filesystem::path load_snapshot_dir;
+        boost::filesystem::path save_snapshot_dir;
+        uint32_t snapshot_threads = 1;
+
         bool skip_virtual_ops = false;
 
         graphene::chain::database db;
 
         bool single_write_thread = false;
 
+        uint32_t signature_recovery_threads = 0;
+        uint32_t signature_cache_size = 0;
+        boost::asio::io_service signature_recovery_ios;
+        std::mutex signature_recovery_mutex; /// guards the work, nothing is posted after the stop
+        std::unique_ptr<boost::asio::io_service::work> signature_recovery_work;
+        boost::thread_group signature_recovery_pool;
+        /// posted transactions which keys aren't recovered yet, blocks aren't posted over the limit,
+        /// so keys of blocks far ahead don't evict keys of the next blocks from the signature cache
+        std::atomic<uint32_t> pending_signature_recoveries{0};
+
         plugin_impl() {
             // get default settings
             read_wait_micro = db.read_wait_micro();
@@ -79,7 +112,11 @@ namespace chain {
         }
 
         void check_time_in_block(const protocol::signed_block &block);
+        void start_signature_recovery();
+        void stop_signature_recovery();
+        void recover_signature_keys(const protocol::signed_block &block, uint32_t skip);
         bool accept_block(const protocol::signed_block &block, bool currently_syncing, uint32_t skip);
+        bool push_block(const protocol::signed_block &block, uint32_t skip);
         void accept_transaction(const protocol::signed_transaction &trx);
         void wipe_db(const bfs::path &data_dir, bool wipe_block_log);
         void replay_db(const bfs::path &data_dir, bool force_replay);
@@ -93,6 +130,67 @@ namespace chain {
         FC_ASSERT(block.timestamp.sec_since_epoch() <= max_accept_time);
     }
 
+    void plugin::plugin_impl::start_signature_recovery() {
+        if (!signature_recovery_threads) {
+            return;
+        }
+        if (!signature_cache_size) {
+            wlog("Signature recovery threads are disabled, because the signature cache is disabled");
+            return;
+        }
+
+        signature_recovery_work.reset(new boost::asio::io_service::work(signature_recovery_ios));
+        for (uint32_t i = 0; i < signature_recovery_threads; ++i) {
+            signature_recovery_pool.create_thread(
+                boost::bind(&boost::asio::io_service::run, &signature_recovery_ios));
+        }
+    }
+
+    void plugin::plugin_impl::stop_signature_recovery() {
+        {
+            std::lock_guard<std::mutex> lock(signature_recovery_mutex);
+            if (!signature_recovery_work) {
+                return;
+            }
+            signature_recovery_work.reset();
+        }
+
+        // the threads leave run() when the posted recoveries are done, so no accept_block waits forever
+        signature_recovery_pool.join_all();
+    }
+
+    void plugin::plugin_impl::recover_signature_keys(const protocol::signed_block &block, uint32_t skip) {
+        if ((skip & graphene::chain::database::skip_transaction_signatures) ||
+            block.transactions.empty() ||
+            pending_signature_recoveries.load() >= signature_cache_size / 2
+        ) {
+            return;
+        }
+
+        // the caller doesn't wait for the recovery, so tasks share own copy of the block
+        auto shared_block = std::make_shared<const protocol::signed_block>(block);
+
+        std::lock_guard<std::mutex> lock(signature_recovery_mutex);
+        if (!signature_recovery_work) {
+            return;
+        }
+
+        const protocol::chain_id_type chain_id = CHAIN_ID;
+        pending_signature_recoveries += shared_block->transactions.size();
+        // the write thread checks transactions from the first one, so they are posted from the last one
+        for (auto i = shared_block->transactions.size(); i-- > 0;) {
+            signature_recovery_ios.post([this, shared_block, chain_id, i]() {
+                try {
+                    // the keys are kept in the signature cache, so the write thread doesn't recover them
+                    shared_block->transactions[i].get_signature_keys(chain_id);
+                } catch (...) {
+                    // the error will be thrown again on applying of the transaction
+                }
+                --pending_signature_recoveries;
+            });
+        }
+    }
+
     bool plugin::plugin_impl::accept_block(const protocol::signed_block &block, bool currently_syncing, uint32_t skip) {
         if (currently_syncing && block.block_num() % 10000 == 0) {
             ilog("Syncing Blockchain --- Got block: #${n} time: ${t} producer: ${p}",
@@ -103,6 +201,13 @@ namespace chain {
 
         skip = db.validate_block(block, skip);
 
+        // keys which aren't recovered by the threads yet are recovered by the write thread, it doesn't wait for them
+        recover_signature_keys(block, skip);
+
+        return push_block(block, skip);
+    }
+
+    bool plugin::plugin_impl::push_block(const protocol::signed_block &block, uint32_t skip) {
         if (single_write_thread) {
             std::promise<bool> promise;
             auto result = promise.get_future();
@@ -204,6 +309,37 @@ namespace chain {
             ) (
                 "flush-state-interval", boost::program_options::value<uint32_t>(),
                 "flush shared memory changes to disk every N blocks"
+            ) (
+                "block-log-version", boost::program_options::value<uint32_t>()->default_value(1),
+                "format of a new block log: 1 - legacy, 2 - with compression of blocks and sparse index. "
+                "Existing block log keeps its format until it is converted by --convert-block-log"
+            ) (
+                "block-log-compression", boost::program_options::value<std::string>()->default_value("none"),
+                "compression of blocks in the block log version 2: none or zstd"
+            ) (
+                "block-log-compression-level", boost::program_options::value<int32_t>()->default_value(3),
+                "level of compression of blocks in the block log version 2"
+            ) (
+                "block-log-index-step", boost::program_options::value<uint32_t>()->default_value(1),
+                "the index of the block log version 2 stores position of each N-th block"
+            ) (
+                "block-log-dictionary-size", boost::program_options::value<std::string>()->default_value("0"),
+                "size of the compression dictionary which is trained on converting of the block log, 0 - don't use dictionary"
+            ) (
+                "block-log-extent-size", boost::program_options::value<std::string>()->default_value("64M"),
+                "the block log files grow by preallocated extents of this size, 0 - grow by each block"
+            ) (
+                "block-timing", boost::program_options::bool_switch()->default_value(false),
+                "measure time of maintenance phases, operations and plugin handlers on applying of blocks"
+            ) (
+                "block-timing-window", boost::program_options::value<uint32_t>()->default_value(1200),
+                "number of the last blocks which are covered by histograms of block timing"
+            ) (
+                "block-timing-log-interval", boost::program_options::value<uint32_t>()->default_value(1200),
+                "log the summary of block timing every N blocks, 0 - don't log"
+            ) (
+                "block-timing-budget-ms", boost::program_options::value<uint32_t>()->default_value(0),
+                "log the slowest phases of each block which is applied longer than this, 0 - don't log"
             ) (
                 "read-wait-micro", boost::program_options::value<uint64_t>(),
                 "maximum microseconds for trying to get read lock"
@@ -219,6 +355,14 @@ namespace chain {
             ) (
                 "single-write-thread", boost::program_options::value<bool>()->default_value(false),
                 "push blocks and transactions from one thread"
+            ) (
+                "signature-recovery-threads", boost::program_options::value<uint32_t>()->default_value(4),
+                "number of threads which recover public keys from transaction signatures of received blocks "
+                "into the signature cache ahead of applying of them, 0 - recover keys in the write thread"
+            ) (
+                "signature-cache-size", boost::program_options::value<uint32_t>()->default_value(100000),
+                "number of public keys recovered from transaction signatures which are cached "
+                "between validation of pending transactions and applying of blocks, 0 - disable cache"
             ) (
                 "clear-votes-before-block", boost::program_options::value<uint32_t>()->default_value(0),
                 "remove votes before defined block, should speedup initial synchronization"
@@ -242,6 +386,34 @@ namespace chain {
             ) (
                 "resync-blockchain", boost::program_options::bool_switch()->default_value(false),
                 "clear chain database and block log"
+            ) (
+                "replay-decode-threads", boost::program_options::value<uint32_t>()->default_value(4),
+                "number of threads which read and decode blocks from block log ahead of applying on replay, "
+                "0 - read blocks in the replay thread"
+            ) (
+                "replay-checkpoint-interval", boost::program_options::value<uint32_t>()->default_value(100000),
+                "flush the state on replay every N blocks, the interrupted replay continues from the last flushed "
+                "block, 0 - disable checkpoints"
+            ) (
+                "replay-snapshot-interval", boost::program_options::value<uint32_t>()->default_value(1000000),
+                "save the snapshot to replay_snapshot in data dir every N blocks on replay, the replay broken by a "
+                "crash continues from it instead of the first block, N should be a multiple of "
+                "replay-checkpoint-interval, because snapshots are taken on checkpoints, 0 - disable"
+            ) (
+                "convert-block-log", boost::program_options::bool_switch()->default_value(false),
+                "convert the block log to the format defined by block-log-* options before start, "
+                "a log which already has this format is left as is"
+            ) (
+                "load-snapshot", boost::program_options::value<boost::filesystem::path>(),
+                "clear chain database and load the state from the snapshot directory (absolute path or relative "
+                "to application data dir), the block log should contain the head block of the snapshot"
+            ) (
+                "save-snapshot", boost::program_options::value<boost::filesystem::path>(),
+                "write the state to the snapshot directory (absolute path or relative to application data dir) "
+                "after opening of the database"
+            ) (
+                "snapshot-threads", boost::program_options::value<uint32_t>()->default_value(4),
+                "number of threads which write or read indexes of the snapshot"
             ) (
                 "check-locks", boost::program_options::bool_switch()->default_value(false),
                 "Check correctness of chainbase locking"
@@ -279,6 +451,9 @@ namespace chain {
         }
 
         my->single_write_thread = options.at("single-write-thread").as<bool>();
+        my->signature_recovery_threads = options.at("signature-recovery-threads").as<uint32_t>();
+        my->signature_cache_size = options.at("signature-cache-size").as<uint32_t>();
+        protocol::signature_cache::instance().set_capacity(my->signature_cache_size);
 
         my->enable_plugins_on_push_transaction = options.at("enable-plugins-on-push-transaction").as<bool>();
 
@@ -295,6 +470,60 @@ namespace chain {
         my->replay_if_corrupted = options.at("replay-if-corrupted").as<bool>();
         my->force_replay = options.at("force-replay-blockchain").as<bool>();
         my->resync = options.at("resync-blockchain").as<bool>();
+        my->replay_decode_threads = options.at("replay-decode-threads").as<uint32_t>();
+        my->replay_checkpoint_interval = options.at("replay-checkpoint-interval").as<uint32_t>();
+        my->replay_snapshot_interval = options.at("replay-snapshot-interval").as<uint32_t>();
+        if (options.at("replay-snapshot-interval").defaulted() && my->replay_snapshot_interval &&
+            (!my->replay_checkpoint_interval || my->replay_snapshot_interval % my->replay_checkpoint_interval != 0)
+        ) {
+            // only the explicit value is an error, the default one is dropped for custom checkpoints
+            my->replay_snapshot_interval = 0;
+        }
+        if (!my->replay_snapshot_interval) {
+            wlog("Replay snapshots are disabled: a replay broken by a crash will be started from the first block, "
+                 "set replay-snapshot-interval to a multiple of replay-checkpoint-interval to resume it");
+        }
+        FC_ASSERT(
+            !my->replay_snapshot_interval ||
+            (my->replay_checkpoint_interval && my->replay_snapshot_interval % my->replay_checkpoint_interval == 0),
+            "replay-snapshot-interval ${s} should be a multiple of replay-checkpoint-interval ${c}, "
+            "because snapshots are taken on checkpoints",
+            ("s", my->replay_snapshot_interval)("c", my->replay_checkpoint_interval));
+
+        my->block_log_options.version = options.at("block-log-version").as<uint32_t>();
+        auto compression = options.at("block-log-compression").as<std::string>();
+        if (compression == "none") {
+            my->block_log_options.compression = graphene::chain::block_log_compression::none;
+        } else if (compression == "zstd") {
+            my->block_log_options.compression = graphene::chain::block_log_compression::zstd;
+        } else {
+            FC_THROW("Unknown block log compression ${c}", ("c", compression));
+        }
+        my->block_log_options.compression_level = options.at("block-log-compression-level").as<int32_t>();
+        my->block_log_options.index_step = options.at("block-log-index-step").as<uint32_t>();
+        my->block_log_options.dictionary_size = fc::parse_size(options.at("block-log-dictionary-size").as<std::string>());
+        my->block_log_options.extent_size = fc::parse_size(options.at("block-log-extent-size").as<std::string>());
+        my->convert_block_log = options.at("convert-block-log").as<bool>();
+
+        my->block_timing = options.at("block-timing").as<bool>();
+        my->block_timing_window = options.at("block-timing-window").as<uint32_t>();
+        my->block_timing_log_interval = options.at("block-timing-log-interval").as<uint32_t>();
+        my->block_timing_budget_ms = options.at("block-timing-budget-ms").as<uint32_t>();
+
+        auto get_snapshot_dir = [&](const char* name) {
+            auto dir = options.at(name).as<boost::filesystem::path>();
+            if (dir.is_relative()) {
+                dir = appbase::app().data_dir() / dir;
+            }
+            return dir;
+        };
+        if (options.count("load-snapshot")) {
+            my->load_snapshot_dir = get_snapshot_dir("load-snapshot");
+        }
+        if (options.count("save-snapshot")) {
+            my->save_snapshot_dir = get_snapshot_dir("save-snapshot");
+        }
+        my->snapshot_threads = options.at("snapshot-threads").as<uint32_t>();
         my->check_locks = options.at("check-locks").as<bool>();
         my->validate_invariants = options.at("validate-database-invariants").as<bool>();
         if (options.count("flush-state-interval")) {
@@ -324,6 +553,12 @@ namespace chain {
         }
 
         my->db.set_flush_interval(my->flush_interval);
+
+        auto &timing = my->db.get_block_timing();
+        timing.set_enabled(my->block_timing);
+        timing.set_window(my->block_timing_window);
+        timing.set_log_interval(my->block_timing_log_interval);
+        timing.set_budget(fc::milliseconds(my->block_timing_budget_ms));
         my->db.add_checkpoints(my->loaded_checkpoints);
         my->db.set_require_locking(my->check_locks);
 
@@ -343,8 +578,24 @@ namespace chain {
             my->db.set_block_num_check_free_size(my->block_num_check_free_size);
         }
 
+        my->db.set_replay_decode_threads(my->replay_decode_threads);
+        my->db.set_replay_checkpoint_interval(my->replay_checkpoint_interval);
+        my->db.set_replay_snapshot_interval(my->replay_snapshot_interval);
+        my->db.set_block_log_options(my->block_log_options);
+
+        if (my->convert_block_log && bfs::exists(data_dir / "block_log")) {
+            ilog("Converting block log to version ${v}", ("v", my->block_log_options.version));
+            graphene::chain::block_log::convert(data_dir / "block_log", my->block_log_options);
+        }
+
         my->db.enable_plugins_on_push_transaction(my->enable_plugins_on_push_transaction);
 
+        my->db.set_snapshot_threads(my->snapshot_threads);
+        if (!my->load_snapshot_dir.empty()) {
+            ilog("Loading snapshot from ${path}", ("path", my->load_snapshot_dir.generic_string()));
+            my->db.set_load_snapshot_dir(my->load_snapshot_dir);
+        }
+
         try {
             ilog("Opening shared memory from ${path}", ("path", my->shared_memory_dir.generic_string()));
             my->db.open(data_dir, my->shared_memory_dir, CHAIN_INIT_SUPPLY, my->shared_memory_size, chainbase::database::read_write/*, my->validate_invariants*/ );
@@ -385,11 +636,19 @@ namespace chain {
             }
         }
 
+        if (!my->save_snapshot_dir.empty()) {
+            my->db.save_snapshot(my->save_snapshot_dir);
+        }
+
+        my->start_signature_recovery();
+
         ilog("Started on blockchain with ${n} blocks", ("n", my->db.head_block_num()));
         on_sync();
     }
 
     void plugin::plugin_shutdown() {
+        my->stop_signature_recovery();
+
         ilog("closing chain database");
         my->db.close();
         ilog("database closed successfully");
@@ -399,6 +658,10 @@ namespace chain {
         return my->accept_block(block, currently_syncing, skip);
     }
 
+    void plugin::prefetch_signature_keys(const protocol::signed_block &block, uint32_t skip) {
+        my->recover_signature_keys(block, skip);
+    }
+
     void plugin::accept_transaction(const protocol::signed_transaction &trx) {
         my->accept_transaction(trx);
     }
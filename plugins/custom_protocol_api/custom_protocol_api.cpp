@@ -91,9 +91,10 @@ namespace graphene { namespace plugins { namespace custom_protocol_api {
     void custom_protocol_api_plugin::plugin_initialize(const boost::program_options::variables_map& options) {
         pimpl = std::make_unique<impl>();
         auto& db = pimpl->database();
-        db.post_apply_operation.connect([&](const operation_notification& note) {
-            pimpl->on_operation(note);
-        });
+        db.post_apply_operation.connect(db.timed_handler("custom_protocol_api.post_apply_operation",
+            [&](const operation_notification& note) {
+                pimpl->on_operation(note);
+            }));
         add_plugin_index<custom_protocol_api::custom_protocol_index>(db);
 
         if (options.count("custom-protocol-store-size")) {
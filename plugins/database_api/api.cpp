@@ -128,6 +128,9 @@ public:
     block_applied_callback_info::cont active_block_applied_callback;
     block_applied_callback_info::cont free_block_applied_callback;
 
+    /// applied blocks for subscribers of websocket connections
+    json_rpc::subscription_hub::channel_type block_channel = 0;
+
 private:
 
     graphene::chain::database &_db;
@@ -241,6 +244,18 @@ optional<signed_block> plugin::api_impl::get_block(uint32_t block_num) const {
 DEFINE_API(plugin, set_block_applied_callback) {
     CHECK_ARG_SIZE(1)
 
+    auto connection = args.connection();
+    if (connection) {
+        auto id = args.rpc_id();
+        appbase::app().get_plugin<json_rpc::plugin>().subscriptions().subscribe(
+            my->block_channel, std::move(connection), fc::json::to_string(id.valid() ? *id : fc::variant()));
+
+        // blocks are responded by the subscription hub
+        msg_pack_transfer transfer(args);
+        transfer.complete();
+        return {};
+    }
+
     // Delegate connection handlers to callback
     msg_pack_transfer transfer(args);
 
@@ -786,6 +801,13 @@ DEFINE_API(plugin, get_database_info) {
     return info;
 }
 
+DEFINE_API(plugin, get_signature_cache_stats) {
+    CHECK_ARG_SIZE(0);
+
+    // the cache has own locks
+    return signature_cache::instance().get_stats();
+}
+
 std::vector<proposal_api_object> plugin::api_impl::get_proposed_transactions(
     const std::string& a, uint32_t from, uint32_t limit
 ) const {
@@ -842,9 +864,40 @@ void plugin::plugin_initialize(const boost::program_options::variables_map &opti
     ilog("database_api plugin: plugin_initialize() begin");
     my = std::make_unique<api_impl>();
     JSON_RPC_REGISTER_API(plugin_name)
-    my->database().applied_block.connect([this](const protocol::signed_block &) {
-        this->clear_block_applied_callback();
-    });
+    JSON_RPC_REGISTER_BINARY_METHODS(plugin_name, (get_block_header)(get_block))
+    auto &json_rpc_plugin = appbase::app().get_plugin<json_rpc::plugin>();
+    json_rpc_plugin.set_serial_method(plugin_name, "set_block_applied_callback");
+
+    // blocks can't change after they become irreversible
+    auto is_irreversible_block = [this](const json_rpc::msg_pack &args) {
+        auto block_num = args.args->at(0).as<uint32_t>();
+        return my->database().with_weak_read_lock([&]() {
+            return block_num <= my->database().last_non_undoable_block_num();
+        });
+    };
+    json_rpc_plugin.set_cacheable_method(plugin_name, "get_block", is_irreversible_block);
+    json_rpc_plugin.set_cacheable_method(plugin_name, "get_block_header", is_irreversible_block);
+
+    // the block is copied on the write thread, it is serialized once on the thread pool for all subscribers
+    auto &subscriptions = json_rpc_plugin.subscriptions();
+    my->block_channel = subscriptions.add_channel("blocks");
+    my->database().applied_block.connect(my->database().timed_handler("database_api.publish_block",
+        [&subscriptions, channel = my->block_channel](const protocol::signed_block &block) {
+            if (!subscriptions.has_subscribers(channel)) {
+                return;
+            }
+            auto copy = std::make_shared<const protocol::signed_block>(block);
+            subscriptions.publish(channel, [copy](json_rpc::subscription_event &event) {
+                json_rpc::json_writer writer;
+                writer.write(*copy);
+                event.payload = std::make_shared<const std::string>(writer.release());
+                return true;
+            });
+        }));
+    my->database().applied_block.connect(my->database().timed_handler("database_api.applied_block",
+        [this](const protocol::signed_block &) {
+            this->clear_block_applied_callback();
+        }));
     ilog("database_api plugin: plugin_initialize() end");
 }
 
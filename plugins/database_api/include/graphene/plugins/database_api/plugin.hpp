@@ -17,6 +17,8 @@
 
 #include <graphene/api/chain_api_properties.hpp>
 
+#include <graphene/protocol/signature_cache.hpp>
+
 #include "forward.hpp"
 
 namespace graphene { namespace plugins { namespace database_api {
@@ -150,6 +152,7 @@ DEFINE_API_ARGS(get_potential_signatures,         msg_pack, std::set<public_key_
 DEFINE_API_ARGS(verify_authority,                 msg_pack, bool)
 DEFINE_API_ARGS(verify_account_authority,         msg_pack, bool)
 DEFINE_API_ARGS(get_database_info,                msg_pack, database_info)
+DEFINE_API_ARGS(get_signature_cache_stats,        msg_pack, signature_cache_stats)
 DEFINE_API_ARGS(get_proposed_transactions,        msg_pack, std::vector<proposal_api_object>)
 
 DEFINE_API_ARGS(get_accounts_on_sale,             msg_pack, std::vector<account_on_sale_api_object>)
@@ -239,6 +242,8 @@ public:
         /**
          * @brief Set callback which is triggered on each generated block
          * @param callback function which should be called
+         *
+         * Websocket connections receive blocks from the subscription hub, a block is serialized once for all of them.
          */
         (set_block_applied_callback)
 
@@ -357,6 +362,11 @@ public:
 
         (get_database_info)
 
+        /**
+         * @brief Get hit and miss counters of the cache of public keys recovered from signatures
+         */
+        (get_signature_cache_stats)
+
         (get_proposed_transactions)
 
         /**
@@ -128,11 +128,12 @@ void plugin::plugin_initialize( const boost::program_options::variables_map& opt
     }
 
     // connect needed signals
-    my->applied_block_connection = my->database().applied_block.connect( [this](const graphene::chain::signed_block& b){
-        my->on_applied_block(b);
-    });
+    my->applied_block_connection = my->database().applied_block.connect(my->database().timed_handler(
+        "debug_node.applied_block", [this](const graphene::chain::signed_block& b){
+            my->on_applied_block(b);
+        }));
 
-    JSON_RPC_REGISTER_API ( name() );
+    JSON_RPC_REGISTER_SERIAL_API ( name() );
 }
 
 void plugin::plugin_startup() {
@@ -13,6 +13,7 @@
 #include <graphene/chain/content_object.hpp>
 #include <memory>
 #include <graphene/plugins/json_rpc/plugin.hpp>
+#include <graphene/plugins/json_rpc/call_deadline.hpp>
 #include <graphene/chain/index.hpp>
 
 #define CHECK_ARG_SIZE(s) \
@@ -310,12 +311,14 @@ namespace graphene {
                     auto &db = pimpl->database();
                     pimpl->plugin_initialize(*this);
 
-                    db.pre_apply_operation.connect([&](operation_notification &o) {
-                        pimpl->pre_operation(o, *this);
-                    });
-                    db.post_apply_operation.connect([&](const operation_notification &o) {
-                        pimpl->post_operation(o, *this);
-                    });
+                    db.pre_apply_operation.connect(db.timed_handler("follow.pre_apply_operation",
+                        [&](operation_notification &o) {
+                            pimpl->pre_operation(o, *this);
+                        }));
+                    db.post_apply_operation.connect(db.timed_handler("follow.post_apply_operation",
+                        [&](const operation_notification &o) {
+                            pimpl->post_operation(o, *this);
+                        }));
                     graphene::chain::add_plugin_index<follow_index>(db);
                     graphene::chain::add_plugin_index<feed_index>(db);
                     graphene::chain::add_plugin_index<blog_index>(db);
@@ -328,6 +331,11 @@ namespace graphene {
                     }
 
                     JSON_RPC_REGISTER_API ( name() ) ;
+
+                    // feeds and blogs are built from content objects, they are executed apart from cheap calls
+                    auto &json_rpc_plugin = appbase::app().get_plugin<json_rpc::plugin>();
+                    json_rpc_plugin.set_expensive_method(name(), "get_feed");
+                    json_rpc_plugin.set_expensive_method(name(), "get_blog");
                 } FC_CAPTURE_AND_RETHROW()
             }
 
@@ -425,6 +433,7 @@ namespace graphene {
                 auto itr = feed_idx.lower_bound(boost::make_tuple(account, entry_id));
 
                 while (itr != feed_idx.end() && itr->account == account && result.size() < limit) {
+                    json_rpc::call_deadline::check();
                     const auto &content = db.get(itr->content);
                     feed_entry entry;
                     entry.author = content.author;
@@ -464,6 +473,7 @@ namespace graphene {
                 auto itr = feed_idx.lower_bound(boost::make_tuple(account, entry_id));
 
                 while (itr != feed_idx.end() && itr->account == account && result.size() < limit) {
+                    json_rpc::call_deadline::check();
                     const auto &content = db.get(itr->content);
                     content_feed_entry entry;
                     entry.content = content_api_object(content, db);
@@ -502,6 +512,7 @@ namespace graphene {
                 auto itr = blog_idx.lower_bound(boost::make_tuple(account, entry_id));
 
                 while (itr != blog_idx.end() && itr->account == account && result.size() < limit) {
+                    json_rpc::call_deadline::check();
                     const auto &content = db.get(itr->content);
                     blog_entry entry;
                     entry.author = content.author;
@@ -536,6 +547,7 @@ namespace graphene {
                 auto itr = blog_idx.lower_bound(boost::make_tuple(account, entry_id));
 
                 while (itr != blog_idx.end() && itr->account == account && result.size() < limit) {
+                    json_rpc::call_deadline::check();
                     const auto &content = db.get(itr->content);
                     content_blog_entry entry;
                     entry.content = content_api_object(content, db);
@@ -0,0 +1,33 @@
+#include <graphene/plugins/json_rpc/call_deadline.hpp>
+
+#include <algorithm>
+
+namespace graphene {
+    namespace plugins {
+        namespace json_rpc {
+
+            constexpr uint32_t call_deadline::check_interval;
+
+            thread_local fc::time_point call_deadline::_deadline = fc::time_point::maximum();
+            thread_local uint32_t call_deadline::_counter = 0;
+
+            call_deadline::call_deadline(fc::microseconds limit)
+                : _previous_deadline(_deadline) {
+                if (limit.count() > 0) {
+                    _deadline = std::min(_deadline, fc::time_point::now() + limit);
+                }
+            }
+
+            call_deadline::~call_deadline() {
+                _deadline = _previous_deadline;
+            }
+
+            void call_deadline::check_now() {
+                if (fc::time_point::now() > _deadline) {
+                    FC_THROW_EXCEPTION(fc::timeout_exception, "Deadline of the call is exceeded");
+                }
+            }
+
+        }
+    }
+} // graphene::plugins::json_rpc
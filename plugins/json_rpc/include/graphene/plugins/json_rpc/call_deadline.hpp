@@ -0,0 +1,49 @@
+#pragma once
+
+#include <fc/exception/exception.hpp>
+#include <fc/time.hpp>
+
+#include <cstdint>
+
+namespace graphene {
+    namespace plugins {
+        namespace json_rpc {
+
+            /**
+             * The deadline of the call in the current thread, it is set by json_rpc for the time of the call.
+             *
+             * Long scans of indexes call check() in their loops, it throws fc::timeout_exception
+             * after the deadline, so the call ends with error and releases the read lock and the thread.
+             * The clock is read only once per check_interval calls of check().
+             */
+            class call_deadline final {
+            public:
+                static constexpr uint32_t check_interval = 64;
+
+                /// zero limit means no deadline, the previous deadline is restored by the destructor
+                explicit call_deadline(fc::microseconds limit);
+
+                ~call_deadline();
+
+                call_deadline(const call_deadline &) = delete;
+
+                call_deadline &operator=(const call_deadline &) = delete;
+
+                static void check() {
+                    if (_deadline != fc::time_point::maximum() && ++_counter % check_interval == 0) {
+                        check_now();
+                    }
+                }
+
+                static void check_now();
+
+            private:
+                static thread_local fc::time_point _deadline;
+                static thread_local uint32_t _counter;
+
+                const fc::time_point _previous_deadline;
+            };
+
+        }
+    }
+} // graphene::plugins::json_rpc
@@ -0,0 +1,287 @@
+#pragma once
+
+#include <fc/io/json.hpp>
+#include <fc/optional.hpp>
+#include <fc/reflect/reflect.hpp>
+#include <fc/reflect/variant.hpp>
+#include <fc/safe.hpp>
+#include <fc/uint128.hpp>
+#include <fc/variant.hpp>
+
+#include <boost/container/flat_set.hpp>
+
+#include <cstdint>
+#include <deque>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace graphene { namespace protocol {
+    struct asset;
+    struct version;
+    struct hardfork_version;
+    struct public_key_type;
+    struct extended_public_key_type;
+    struct extended_private_key_type;
+} } // graphene::protocol
+
+namespace graphene {
+    namespace plugins {
+        namespace json_rpc {
+
+            /**
+             * Reflected types which have own to_variant() are written via fc::variant,
+             * otherwise the writer would output their reflected members
+             */
+            template<typename T>
+            struct json_writer_use_variant: std::false_type {};
+
+            template<> struct json_writer_use_variant<graphene::protocol::asset>: std::true_type {};
+            template<> struct json_writer_use_variant<graphene::protocol::version>: std::true_type {};
+            template<> struct json_writer_use_variant<graphene::protocol::hardfork_version>: std::true_type {};
+            template<> struct json_writer_use_variant<graphene::protocol::public_key_type>: std::true_type {};
+            template<> struct json_writer_use_variant<graphene::protocol::extended_public_key_type>: std::true_type {};
+            template<> struct json_writer_use_variant<graphene::protocol::extended_private_key_type>: std::true_type {};
+            template<> struct json_writer_use_variant<fc::uint128_t>: std::true_type {};
+            template<typename T> struct json_writer_use_variant<fc::safe<T>>: std::true_type {};
+
+            /**
+             * Writes FC_REFLECTed objects to JSON directly, without building of fc::variant tree.
+             * The output is the same as fc::json::to_string(fc::variant(value)):
+             * members of objects are written in order of reflection, invalid optional members are skipped,
+             * integers which don't fit into 32 bits, doubles and strings with special characters
+             * are written by fc, types without reflection are written via fc::variant.
+             *
+             * The buffer can be reused by clear(), it keeps the allocated memory.
+             */
+            class json_writer final {
+            public:
+                json_writer() = default;
+
+                explicit json_writer(std::size_t reserve) {
+                    _out.reserve(reserve);
+                }
+
+                template<typename T>
+                json_writer& write(const T& value) {
+                    write_value(value);
+                    return *this;
+                }
+
+                /// appends the already serialized JSON
+                json_writer& write_raw(const std::string& json) {
+                    _out.append(json);
+                    return *this;
+                }
+
+                json_writer& write_raw(const char* json) {
+                    _out.append(json);
+                    return *this;
+                }
+
+                const std::string& str() const {
+                    return _out;
+                }
+
+                /// moves the buffer out of the writer
+                std::string release() {
+                    std::string result;
+                    result.swap(_out);
+                    return result;
+                }
+
+                void clear() {
+                    _out.clear();
+                }
+
+            private:
+                template<typename T>
+                struct use_reflection: std::integral_constant<bool,
+                    fc::reflector<T>::is_defined::value &&
+                    !fc::reflector<T>::is_enum::value &&
+                    !json_writer_use_variant<T>::value> {};
+
+                template<typename T>
+                class member_visitor final {
+                public:
+                    member_visitor(json_writer& writer, const T& object)
+                        : _writer(writer), _object(object) {
+                    }
+
+                    template<typename Member, class Class, Member (Class::*member)>
+                    void operator()(const char* name) const {
+                        add(name, _object.*member);
+                    }
+
+                private:
+                    template<typename M>
+                    void add(const char* name, const fc::optional<M>& value) const {
+                        if (value.valid()) {
+                            add(name, *value);
+                        }
+                    }
+
+                    template<typename M>
+                    void add(const char* name, const M& value) const {
+                        if (!_is_first) {
+                            _writer._out.push_back(',');
+                        }
+                        _is_first = false;
+                        _writer._out.push_back('"');
+                        _writer._out.append(name);
+                        _writer._out.append("\":");
+                        _writer.write_value(value);
+                    }
+
+                    json_writer& _writer;
+                    const T& _object;
+                    mutable bool _is_first = true;
+                };
+
+                template<typename T>
+                void write_value(const T& value) {
+                    write_value(value, use_reflection<T>());
+                }
+
+                template<typename T>
+                void write_value(const T& value, std::true_type /* reflection */) {
+                    _out.push_back('{');
+                    fc::reflector<T>::visit(member_visitor<T>(*this, value));
+                    _out.push_back('}');
+                }
+
+                template<typename T>
+                void write_value(const T& value, std::false_type /* reflection */) {
+                    write_variant(value);
+                }
+
+                template<typename T>
+                void write_variant(const T& value) {
+                    fc::variant v;
+                    fc::to_variant(value, v);
+                    _out.append(fc::json::to_string(v));
+                }
+
+                void write_value(bool value) {
+                    _out.append(value ? "true" : "false");
+                }
+
+                void write_value(int16_t value) {
+                    write_signed(value);
+                }
+
+                void write_value(int32_t value) {
+                    write_signed(value);
+                }
+
+                void write_value(int64_t value) {
+                    write_signed(value);
+                }
+
+                void write_value(uint16_t value) {
+                    write_unsigned(value);
+                }
+
+                void write_value(uint32_t value) {
+                    write_unsigned(value);
+                }
+
+                void write_value(uint64_t value) {
+                    write_unsigned(value);
+                }
+
+                void write_signed(int64_t value) {
+                    // fc writes large integers as strings
+                    if (value > int64_t(0xffffffff) || value < -int64_t(0xffffffff)) {
+                        write_variant(value);
+                    } else {
+                        _out.append(std::to_string(value));
+                    }
+                }
+
+                void write_unsigned(uint64_t value) {
+                    if (value > uint64_t(0xffffffff)) {
+                        write_variant(value);
+                    } else {
+                        _out.append(std::to_string(value));
+                    }
+                }
+
+                void write_value(const std::string& value) {
+                    for (auto c: value) {
+                        // escaping of special and non-ASCII characters is left to fc
+                        if (c < 0x20 || c > 0x7e || c == '"' || c == '\\') {
+                            write_variant(value);
+                            return;
+                        }
+                    }
+                    _out.push_back('"');
+                    _out.append(value);
+                    _out.push_back('"');
+                }
+
+                void write_value(const std::vector<char>& value) {
+                    // fc writes bytes as hex string
+                    write_variant(value);
+                }
+
+                template<typename T>
+                void write_value(const fc::optional<T>& value) {
+                    if (value.valid()) {
+                        write_value(*value);
+                    } else {
+                        _out.append("null");
+                    }
+                }
+
+                template<typename A, typename B>
+                void write_value(const std::pair<A, B>& value) {
+                    _out.push_back('[');
+                    write_value(value.first);
+                    _out.push_back(',');
+                    write_value(value.second);
+                    _out.push_back(']');
+                }
+
+                template<typename T, typename... Rest>
+                void write_value(const std::vector<T, Rest...>& value) {
+                    write_array(value);
+                }
+
+                template<typename T, typename... Rest>
+                void write_value(const std::deque<T, Rest...>& value) {
+                    write_array(value);
+                }
+
+                template<typename T, typename... Rest>
+                void write_value(const std::set<T, Rest...>& value) {
+                    write_array(value);
+                }
+
+                template<typename T, typename... Rest>
+                void write_value(const boost::container::flat_set<T, Rest...>& value) {
+                    write_array(value);
+                }
+
+                template<typename Container>
+                void write_array(const Container& value) {
+                    _out.push_back('[');
+                    bool is_first = true;
+                    for (const auto& item: value) {
+                        if (!is_first) {
+                            _out.push_back(',');
+                        }
+                        is_first = false;
+                        write_value(item);
+                    }
+                    _out.push_back(']');
+                }
+
+                std::string _out;
+            };
+
+        }
+    }
+} // graphene::plugins::json_rpc
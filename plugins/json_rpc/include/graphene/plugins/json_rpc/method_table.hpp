@@ -0,0 +1,155 @@
+#pragma once
+
+#include <fc/exception/exception.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace graphene {
+    namespace plugins {
+        namespace json_rpc {
+
+            /**
+             * Read-only hash table of methods with the perfect hash (hash and displace):
+             * keys are grouped into buckets by the first hash, each bucket gets the seed
+             * of the second hash which places all its keys into free slots.
+             *
+             * The lookup computes two hashes and compares one key, there are no collisions to resolve.
+             * The table is built once after registration of APIs, it isn't modified by lookups,
+             * so it can be read from any thread.
+             */
+            template<typename Value>
+            class method_table final {
+            public:
+                using item_type = std::pair<std::string, Value>;
+
+                /// keys must be unique and non-empty
+                void build(std::vector<item_type> items) {
+                    for (std::size_t slot_count = 2; ; slot_count *= 2) {
+                        if (slot_count < items.size() * 2) {
+                            continue;
+                        }
+                        if (try_build(items, slot_count)) {
+                            return;
+                        }
+                        FC_ASSERT(slot_count < (std::size_t(1) << 24), "Can't build hash table of methods");
+                    }
+                }
+
+                const Value *find(const char *name, std::size_t size) const {
+                    // empty slots have empty keys
+                    if (_slots.empty() || size == 0) {
+                        return nullptr;
+                    }
+
+                    const auto bucket = hash(name, size, 0) % _seeds.size();
+                    const auto &slot = _slots[hash(name, size, _seeds[bucket]) & (_slots.size() - 1)];
+                    if (slot.first.size() != size || std::memcmp(slot.first.data(), name, size) != 0) {
+                        return nullptr;
+                    }
+                    return &slot.second;
+                }
+
+                const Value *find(const std::string &name) const {
+                    return find(name.data(), name.size());
+                }
+
+                std::size_t size() const {
+                    return _size;
+                }
+
+            private:
+                static uint32_t hash(const char *data, std::size_t size, uint32_t seed) {
+                    // FNV-1a with the final mix, the low bits are used as index of the slot
+                    uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u);
+                    for (std::size_t i = 0; i < size; ++i) {
+                        h ^= static_cast<unsigned char>(data[i]);
+                        h *= 16777619u;
+                    }
+                    h ^= h >> 16;
+                    h *= 0x85ebca6bu;
+                    h ^= h >> 13;
+                    h *= 0xc2b2ae35u;
+                    h ^= h >> 16;
+                    return h;
+                }
+
+                bool try_build(std::vector<item_type> &items, std::size_t slot_count) {
+                    const std::size_t bucket_count = items.size() / 2 + 1;
+                    std::vector<std::vector<std::size_t>> buckets(bucket_count);
+                    for (std::size_t i = 0; i < items.size(); ++i) {
+                        const auto &key = items[i].first;
+                        buckets[hash(key.data(), key.size(), 0) % bucket_count].push_back(i);
+                    }
+
+                    // the largest buckets are placed first, while the table is empty
+                    std::vector<std::size_t> order(bucket_count);
+                    for (std::size_t i = 0; i < bucket_count; ++i) {
+                        order[i] = i;
+                    }
+                    std::stable_sort(order.begin(), order.end(), [&](std::size_t l, std::size_t r) {
+                        return buckets[l].size() > buckets[r].size();
+                    });
+
+                    std::vector<uint32_t> seeds(bucket_count, 0);
+                    std::vector<bool> is_used(slot_count, false);
+                    std::vector<std::size_t> positions;
+
+                    for (auto b: order) {
+                        const auto &bucket = buckets[b];
+                        if (bucket.empty()) {
+                            break;
+                        }
+
+                        bool is_placed = false;
+                        for (uint32_t seed = 1; seed < 65536 && !is_placed; ++seed) {
+                            positions.clear();
+                            for (auto i: bucket) {
+                                const auto &key = items[i].first;
+                                const auto position = hash(key.data(), key.size(), seed) & (slot_count - 1);
+                                if (is_used[position] ||
+                                    std::find(positions.begin(), positions.end(), position) != positions.end()) {
+                                    break;
+                                }
+                                positions.push_back(position);
+                            }
+
+                            if (positions.size() == bucket.size()) {
+                                seeds[b] = seed;
+                                for (auto position: positions) {
+                                    is_used[position] = true;
+                                }
+                                is_placed = true;
+                            }
+                        }
+
+                        if (!is_placed) {
+                            return false;
+                        }
+                    }
+
+                    _slots.clear();
+                    _slots.resize(slot_count);
+                    for (std::size_t b = 0; b < bucket_count; ++b) {
+                        for (auto i: buckets[b]) {
+                            const auto &key = items[i].first;
+                            _slots[hash(key.data(), key.size(), seeds[b]) & (slot_count - 1)] = std::move(items[i]);
+                        }
+                    }
+                    _seeds = std::move(seeds);
+                    _size = items.size();
+                    return true;
+                }
+
+                std::vector<uint32_t> _seeds;
+                std::vector<item_type> _slots;
+                std::size_t _size = 0;
+            };
+
+        }
+    }
+} // graphene::plugins::json_rpc
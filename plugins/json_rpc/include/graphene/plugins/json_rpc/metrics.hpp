@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace graphene {
+    namespace plugins {
+        namespace json_rpc {
+
+            /**
+             * Histogram with fixed upper bounds of buckets, it is updated without locks
+             * and written in Prometheus text format
+             */
+            class metrics_histogram final {
+            public:
+                explicit metrics_histogram(std::vector<uint64_t> bounds);
+
+                void observe(uint64_t value);
+
+                /// values are divided by the scale on output, for example microseconds to seconds
+                void write(std::string &out, const std::string &name, const std::string &labels, double scale) const;
+
+            private:
+                std::vector<uint64_t> _bounds;
+                /// the last bucket is +Inf
+                std::unique_ptr<std::atomic<uint64_t>[]> _buckets;
+                std::atomic<uint64_t> _sum{0};
+                std::atomic<uint64_t> _count{0};
+            };
+
+            /// metrics of one API method, they are shared by all threads
+            struct method_metrics final {
+                method_metrics();
+
+                std::atomic<uint64_t> calls{0};
+                std::atomic<uint64_t> errors{0};
+                std::atomic<int64_t> in_flight{0};
+
+                /// time of the call in the thread which executes it, in microseconds
+                metrics_histogram duration;
+                /// size of serialized response in bytes
+                metrics_histogram response_size;
+                /// time of waiting for the weak read lock of the database during the call, in microseconds
+                metrics_histogram read_lock_wait;
+            };
+
+            using method_metrics_map = std::map<std::string, std::unique_ptr<method_metrics>>;
+
+            /// writes metrics of all methods in Prometheus text format
+            std::string write_prometheus_metrics(const method_metrics_map &metrics);
+
+        }
+    }
+} // graphene::plugins::json_rpc
@@ -2,13 +2,19 @@
 
 #include <appbase/application.hpp>
 #include <graphene/plugins/json_rpc/utility.hpp>
+#include <graphene/plugins/json_rpc/json_writer.hpp>
+#include <graphene/plugins/json_rpc/response_cache.hpp>
+#include <graphene/plugins/json_rpc/subscription_hub.hpp>
 #include <fc/variant.hpp>
 #include <fc/io/json.hpp>
+#include <fc/io/raw.hpp>
 #include <fc/reflect/variant.hpp>
 #include <fc/exception/exception.hpp>
 
 #include <boost/config.hpp>
 #include <boost/any.hpp>
+#include <boost/preprocessor/seq/for_each.hpp>
+#include <boost/preprocessor/stringize.hpp>
 
 /**
  * This plugin holds bindings for all APIs and their methods
@@ -33,6 +39,33 @@
  *
  * For methods that do not require arguments, use api_void_args
  * as the argument type.
+ *
+ * Results of methods listed in the json-rpc-streamed-methods option are written
+ * to JSON by json_writer directly from API objects, without fc::variant.
+ *
+ * Results of methods which can't change after some moment (for example, blocks become irreversible)
+ * are kept serialized in the response cache. The plugin of the method defines when its result is immutable
+ * by set_cacheable_method(), the cache is enabled per method by the json-rpc-cache-methods option.
+ *
+ * When metrics are enabled (see webserver-metrics-path), calls, errors, calls in flight, time of calls,
+ * size of responses and time of waiting for the read lock are collected per method.
+ *
+ * Calls of a batch request are executed in parallel on the batch executor,
+ * a call rejected by the executor responds with JSON_RPC_SERVER_OVERLOADED.
+ * Methods which change the state or depend on order of calls should be
+ * registered by JSON_RPC_REGISTER_SERIAL_API or set_serial_method(),
+ * such calls of a batch are executed one by one in order of the batch.
+ *
+ * Methods which scan large indexes are registered by set_expensive_method() or listed
+ * in the json-rpc-expensive-methods option. Their calls are moved to the expensive executor,
+ * so they don't occupy threads of cheap calls. A call can have a deadline (see call_deadline),
+ * long scans check it and the call ends with JSON_RPC_DEADLINE_EXCEEDED.
+ *
+ * Websocket connections can subscribe to channels of the subscription hub, events are serialized once
+ * and sent to all subscribers of the channel (see subscription_hub).
+ *
+ * Methods registered by JSON_RPC_REGISTER_BINARY_METHODS can be called by binary websocket messages
+ * with fc::raw packed args and results (see graphene/binary_rpc/protocol.hpp and its client library).
  */
 
 #define JSON_RPC_PLUGIN_NAME "json_rpc"
@@ -43,6 +76,25 @@
    for_each_api( vtor );                                                                        \
 }
 
+#define JSON_RPC_REGISTER_SERIAL_API(API_NAME)                                                \
+{                                                                                               \
+   graphene::plugins::json_rpc::detail::register_api_method_visitor vtor( API_NAME, false );     \
+   for_each_api( vtor );                                                                        \
+}
+
+#define JSON_RPC_BINARY_METHOD_HELPER(r, API_NAME, METHOD)                                    \
+   appbase::app().get_plugin<graphene::plugins::json_rpc::plugin>().add_binary_method(          \
+      API_NAME, BOOST_PP_STRINGIZE(METHOD),                                                     \
+      [this](graphene::plugins::json_rpc::msg_pack &args, std::vector<char> &result) {          \
+         result = fc::raw::pack(this->METHOD(args));                                            \
+      });
+
+/// the return types of methods must be packable by fc::raw
+#define JSON_RPC_REGISTER_BINARY_METHODS(API_NAME, METHODS)                                   \
+{                                                                                               \
+   BOOST_PP_SEQ_FOR_EACH(JSON_RPC_BINARY_METHOD_HELPER, API_NAME, METHODS)                      \
+}
+
 #define JSON_RPC_PARSE_ERROR        (-32700)
 #define JSON_RPC_INVALID_REQUEST    (-32600)
 #define JSON_RPC_METHOD_NOT_FOUND   (-32601)
@@ -52,6 +104,8 @@
 #define JSON_RPC_NO_PARAMS          (-32001)
 #define JSON_RPC_PARSE_PARAMS_ERROR (-32002)
 #define JSON_RPC_ERROR_DURING_CALL  (-32003)
+#define JSON_RPC_SERVER_OVERLOADED  (-32004)
+#define JSON_RPC_DEADLINE_EXCEEDED  (-32005)
 
 namespace graphene {
     namespace plugins {
@@ -67,6 +121,15 @@ namespace graphene {
              */
             using api_method = std::function<fc::variant(msg_pack &)>;
 
+            /// the same as api_method, but the result is written to JSON by json_writer
+            using api_stream_method = std::function<void(msg_pack &, json_writer &)>;
+
+            /// the same as api_method, but the result is packed by fc::raw for binary RPC
+            using api_binary_method = std::function<void(msg_pack &, std::vector<char> &)>;
+
+            /// returns true if the result of the call with its args can't change anymore
+            using cache_predicate = std::function<bool(const msg_pack &)>;
+
             /**
              * @brief An API, containing APIs and Methods
              *
@@ -83,7 +146,12 @@ namespace graphene {
 
             class plugin final : public appbase::plugin<plugin> {
             public:
-                using response_handler_type = std::function<void (const std::string &)>;
+                using response_handler_type = std::function<void (std::string &&)>;
+
+                using task_executor_type = std::function<void (std::function<void()>)>;
+
+                /// returns false if the task is rejected because the queue or the limit of the client is full
+                using pool_executor_type = std::function<bool (std::function<void()>)>;
 
                 plugin();
 
@@ -92,8 +160,7 @@ namespace graphene {
                 APPBASE_PLUGIN_REQUIRES();
 
                 void set_program_options(boost::program_options::options_description &,
-                                         boost::program_options::options_description &) override {
-                }
+                                         boost::program_options::options_description &) override;
 
                 static const std::string &name() {
                     static std::string name = JSON_RPC_PLUGIN_NAME;
@@ -107,10 +174,48 @@ namespace graphene {
                 void plugin_shutdown() override;
 
                 void add_api_method(const string &api_name, const string &method_name,
-                                    const api_method &api/*, const api_method_signature& sig */);
+                                    const api_method &api/*, const api_method_signature& sig */,
+                                    bool is_concurrent = true, const api_stream_method &stream_api = {});
+
+                /// the method can be called by binary RPC, it must be added by add_api_method() too
+                void add_binary_method(const string &api_name, const string &method_name, api_binary_method);
+
+                /// calls of the method in a batch are executed in order of the batch
+                void set_serial_method(const string &api_name, const string &method_name);
+
+                /// results of the method are cached when the predicate is true, if the method is in json-rpc-cache-methods
+                void set_cacheable_method(const string &api_name, const string &method_name, cache_predicate);
+
+                /// calls of a batch are posted to the executor, without it they are executed in the caller thread
+                void set_batch_executor(pool_executor_type);
+
+                /// calls of the method are executed on the expensive executor
+                void set_expensive_method(const string &api_name, const string &method_name);
+
+                /// without the executor, expensive methods are executed in the caller thread
+                void set_expensive_executor(pool_executor_type);
 
                 void call(const string &body, response_handler_type);
 
+                /// the call from the connection which can receive messages of subscriptions
+                void call(const string &body, response_handler_type, std::shared_ptr<subscriber_connection>);
+
+                /// the call of binary RPC, the message and the response are fc::raw packed
+                void call_binary(const string &message, response_handler_type);
+
+                /// the packed error response to the binary request, it has the id of the request if it is valid
+                std::string binary_error(const string &message, int32_t code, const string &text) const;
+
+                /// subscriptions of websocket connections, plugins add channels on initialization
+                subscription_hub &subscriptions();
+
+                /// collects metrics of methods, the counter returns the total time of waiting for the read lock
+                /// by the current thread in microseconds
+                void enable_metrics(std::function<uint64_t()> read_lock_wait_counter = {});
+
+                /// metrics of methods in Prometheus text format
+                std::string get_metrics() const;
+
             private:
                 class impl;
 
@@ -120,8 +225,9 @@ namespace graphene {
             namespace detail {
                 class register_api_method_visitor {
                 public:
-                    register_api_method_visitor(const std::string &api_name) : _api_name(api_name),
-                            _json_rpc_plugin(appbase::app().get_plugin< json_rpc::plugin >()) {
+                    register_api_method_visitor(const std::string &api_name, bool is_concurrent = true)
+                            : _api_name(api_name), _is_concurrent(is_concurrent),
+                              _json_rpc_plugin(appbase::app().get_plugin< json_rpc::plugin >()) {
                     }
 
                     template<typename Plugin, typename Method, typename Args, typename Ret>
@@ -130,12 +236,16 @@ namespace graphene {
                         _json_rpc_plugin.add_api_method(_api_name, method_name,
                                                         [&plugin, method](msg_pack &args) -> fc::variant {
                                                             return fc::variant((plugin.*method)(args));
+                                                        }, _is_concurrent,
+                                                        [&plugin, method](msg_pack &args, json_writer &writer) {
+                                                            writer.write((plugin.*method)(args));
                                                         });
                         /*api_method_signature{ fc::variant( Args() ), fc::variant( Ret() ) }*/ //);
                     }
 
                 private:
                     std::string _api_name;
+                    bool _is_concurrent;
                     json_rpc::plugin &_json_rpc_plugin;
                 };
             }
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace graphene {
+    namespace plugins {
+        namespace json_rpc {
+
+            /// the raw JSON value inside of a message, the message must outlive it
+            struct json_slice {
+                const char *begin = nullptr;
+                const char *end = nullptr;
+
+                bool empty() const {
+                    return begin == end;
+                }
+
+                std::size_t size() const {
+                    return end - begin;
+                }
+
+                std::string str() const {
+                    return std::string(begin, end);
+                }
+
+                bool equals(const char *value) const {
+                    return size() == std::strlen(value) && std::memcmp(begin, value, size()) == 0;
+                }
+
+                /// the string value without escapes, its content is returned without quotes
+                bool get_simple_string(json_slice &content) const;
+            };
+
+            /**
+             * Finds members of JSON-RPC request ("jsonrpc", "id", "method" and "params") without parsing of their values,
+             * so the request is parsed only as much as the call needs: params aren't parsed until the method is found.
+             *
+             * The scanner only tracks nesting of values, the values are validated by fc when they are parsed.
+             * Messages which aren't objects, have escaped names of members or duplicated members of the envelope
+             * aren't accepted, they are left to fc::json.
+             */
+            class request_envelope final {
+            public:
+                bool parse(const char *begin, const char *end);
+
+                bool parse(const std::string &message) {
+                    return parse(message.data(), message.data() + message.size());
+                }
+
+                json_slice jsonrpc;
+                json_slice id;
+                json_slice method;
+                json_slice params;
+            };
+
+            /// splits the JSON array into its items, returns false if the message isn't an array
+            bool split_json_array(const char *begin, const char *end, std::vector<json_slice> &items);
+
+            inline bool split_json_array(const std::string &message, std::vector<json_slice> &items) {
+                return split_json_array(message.data(), message.data() + message.size(), items);
+            }
+
+        }
+    }
+} // graphene::plugins::json_rpc
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <fc/reflect/reflect.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace graphene {
+    namespace plugins {
+        namespace json_rpc {
+
+            struct response_cache_method_stats {
+                std::string method;
+                uint64_t hits = 0;
+                uint64_t misses = 0;
+                /// results which weren't stored, because they can change (the block isn't irreversible)
+                uint64_t uncacheable = 0;
+                uint64_t insertions = 0;
+                uint64_t evictions = 0;
+            };
+
+            struct response_cache_stats {
+                uint64_t max_bytes = 0;
+                uint64_t bytes = 0;
+                uint64_t entries = 0;
+                uint32_t shards = 0;
+                std::vector<response_cache_method_stats> methods;
+            };
+
+            /**
+             * Serialized results of calls which can't change, for example blocks which are irreversible.
+             * The key is the method with its args, the value is JSON of the result without the envelope,
+             * so the same value serves requests with different ids.
+             *
+             * The cache is split into shards by hash of the key, each shard has own lock and LRU list,
+             * the memory limit is divided between shards.
+             */
+            class response_cache final {
+            public:
+                using value_type = std::shared_ptr<const std::string>;
+
+                /// zero max_bytes disables the cache, it can be configured only before adding of values
+                void configure(std::size_t max_bytes, uint32_t shards);
+
+                bool enabled() const {
+                    return !_shards.empty();
+                }
+
+                /// registers the method for the stats, the returned index is passed to other calls
+                uint32_t add_method(const std::string &name);
+
+                /// counts the hit or the miss
+                value_type find(uint32_t method, const std::string &key);
+
+                void insert(uint32_t method, std::string key, value_type value);
+
+                /// counts the result which isn't stored
+                void skip(uint32_t method);
+
+                response_cache_stats stats() const;
+
+            private:
+                struct node {
+                    value_type value;
+                    uint32_t method = 0;
+                    std::list<const std::string *>::iterator lru_position;
+                };
+
+                struct shard {
+                    std::mutex mutex;
+                    /// keys of the map, the most recently used is the first
+                    std::list<const std::string *> lru;
+                    std::unordered_map<std::string, node> nodes;
+                    std::size_t bytes = 0;
+                };
+
+                struct counters {
+                    std::atomic<uint64_t> hits{0};
+                    std::atomic<uint64_t> misses{0};
+                    std::atomic<uint64_t> uncacheable{0};
+                    std::atomic<uint64_t> insertions{0};
+                    std::atomic<uint64_t> evictions{0};
+                };
+
+                static std::size_t size_of(const std::string &key, const value_type &value);
+
+                shard &shard_of(const std::string &key);
+
+                std::vector<std::unique_ptr<shard>> _shards;
+                std::size_t _max_bytes = 0;
+                std::size_t _shard_max_bytes = 0;
+
+                std::vector<std::string> _method_names;
+                std::deque<counters> _counters;
+            };
+
+        }
+    }
+} // graphene::plugins::json_rpc
+
+FC_REFLECT((graphene::plugins::json_rpc::response_cache_method_stats),
+           (method)(hits)(misses)(uncacheable)(insertions)(evictions))
+FC_REFLECT((graphene::plugins::json_rpc::response_cache_stats), (max_bytes)(bytes)(entries)(shards)(methods))
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace graphene {
+    namespace plugins {
+        namespace json_rpc {
+
+            /// the connection which receives messages of subscriptions, it is implemented by the transport
+            class subscriber_connection {
+            public:
+                virtual ~subscriber_connection() = default;
+
+                /// the identity of the connection, it is the same for all requests of the connection
+                virtual const void *id() const = 0;
+
+                /// queues the message for sending, returns false if the connection is closed
+                virtual bool send(const std::string &message) = 0;
+
+                /// size of messages which are queued but aren't written to the socket yet
+                virtual std::size_t buffered_amount() const = 0;
+
+                /// closes the connection which doesn't read its messages
+                virtual void close(const std::string &reason) = 0;
+            };
+
+            /// the event is serialized once for all subscribers
+            struct subscription_event {
+                std::shared_ptr<const std::string> payload;
+                /// the type of the event, for example the name of the operation
+                std::string type;
+                /// accounts which are related to the event
+                std::set<std::string> accounts;
+            };
+
+            /// the subscriber receives events which match both sets, the empty set matches any event
+            struct subscription_filter {
+                std::set<std::string> types;
+                std::set<std::string> accounts;
+
+                bool match(const subscription_event &) const;
+            };
+
+            /**
+             * Delivers events of channels (applied blocks, operations) to subscribed connections.
+             *
+             * The publisher (the write thread of the database) only copies the source of the event and posts it,
+             * events are produced (serialized) once and fanned out on the executor one by one, so they are
+             * delivered in order of publishing. Each message is built from the shared payload and the id
+             * of the subscribing request.
+             *
+             * Messages are queued by the transport of the connection. The connection which has more than
+             * max_buffered_bytes unsent is closed as the slow consumer, so it can't consume memory of the node.
+             * Events are dropped when max_pending_events are waiting for the fan-out.
+             */
+            class subscription_hub final {
+            public:
+                using channel_type = uint32_t;
+                using executor_type = std::function<void(std::function<void()>)>;
+                /// fills the event on the thread of the fan-out, returns false if the event isn't sent
+                using event_producer = std::function<bool(subscription_event &)>;
+
+                struct limits {
+                    std::size_t max_buffered_bytes = 16 * 1024 * 1024;
+                    uint32_t max_subscriptions_per_connection = 16;
+                    uint32_t max_pending_events = 10000;
+                };
+
+                void configure(limits);
+
+                /// without the executor events are fanned out in the thread of the publisher
+                void set_executor(executor_type);
+
+                /// channels are added on initialization of plugins, before events are published
+                channel_type add_channel(const std::string &name);
+
+                /// messages of the subscription are JSON-RPC responses with the id of the subscribing request
+                void subscribe(
+                    channel_type, std::shared_ptr<subscriber_connection>, std::string rpc_id,
+                    subscription_filter = subscription_filter());
+
+                /// removes all subscriptions of the closed connection
+                void remove_connection(const void *connection_id);
+
+                /// the publisher checks it before it copies the source of the event
+                bool has_subscribers(channel_type channel) const {
+                    return _channels[channel]->subscription_count.load(std::memory_order_relaxed) != 0;
+                }
+
+                void publish(channel_type, event_producer);
+
+                /// metrics in Prometheus text format
+                std::string get_metrics() const;
+
+            private:
+                struct subscription {
+                    std::shared_ptr<subscriber_connection> connection;
+                    std::string rpc_id;
+                    subscription_filter filter;
+                };
+
+                struct channel_state {
+                    std::string name;
+                    std::atomic<uint32_t> subscription_count{0};
+                    std::vector<std::shared_ptr<const subscription>> subscriptions;
+                };
+
+                struct pending_event {
+                    channel_type channel = 0;
+                    event_producer producer;
+                };
+
+                void dispatch();
+
+                void fan_out(pending_event &);
+
+                /// returns false if the connection is closed or is too slow, it should be removed
+                bool deliver(const subscription &, const subscription_event &);
+
+                limits _limits;
+                executor_type _executor;
+                std::vector<std::unique_ptr<channel_state>> _channels;
+
+                mutable std::mutex _mutex;
+                /// number of subscriptions by connection
+                std::map<const void *, uint32_t> _connections;
+                std::deque<pending_event> _events;
+                bool _is_dispatching = false;
+
+                std::atomic<uint64_t> _published_events{0};
+                std::atomic<uint64_t> _dropped_events{0};
+                std::atomic<uint64_t> _sent_messages{0};
+                std::atomic<uint64_t> _slow_consumer_disconnects{0};
+            };
+
+        }
+    }
+} // graphene::plugins::json_rpc
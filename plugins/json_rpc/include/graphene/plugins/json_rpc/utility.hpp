@@ -43,6 +43,9 @@ api_name ## _return class :: api_name ( api_name ## _args& args )
 namespace graphene {
     namespace plugins {
         namespace json_rpc {
+            struct method_metrics;
+            class subscriber_connection;
+
             class msg_pack final {
             public:
                 fc::variant id;
@@ -75,6 +78,9 @@ namespace graphene {
 
                 void unsafe_result(fc::optional<fc::variant> result);
 
+                // Pass result which is already serialized to JSON (see json_writer)
+                void raw_result(std::string json);
+
                 fc::optional<fc::variant> result() const;
 
                 // Pass error to remote connection
@@ -88,6 +94,14 @@ namespace graphene {
 
                 fc::optional<std::string> error() const;
 
+                // Metrics of the called method, the size of responses is recorded to them
+                void metrics(method_metrics *);
+
+                // The connection of the request, it is absent for HTTP requests and calls of batches
+                std::shared_ptr<subscriber_connection> connection() const;
+
+                void connection(std::shared_ptr<subscriber_connection>);
+
             private:
                 struct impl;
                 std::unique_ptr<impl> pimpl;
@@ -0,0 +1,121 @@
+#include <graphene/plugins/json_rpc/metrics.hpp>
+
+#include <cstdio>
+
+namespace graphene {
+    namespace plugins {
+        namespace json_rpc {
+
+            namespace {
+                std::string format_number(double value) {
+                    char buf[32];
+                    snprintf(buf, sizeof(buf), "%.9g", value);
+                    return buf;
+                }
+
+                void write_header(std::string &out, const char *name, const char *type, const char *help) {
+                    out.append("# HELP ").append(name).append(" ").append(help).append("\n");
+                    out.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+                }
+
+                std::string method_label(const std::string &method) {
+                    // names of methods don't contain quotes or backslashes, they are registered by plugins
+                    return "method=\"" + method + "\"";
+                }
+            }
+
+            metrics_histogram::metrics_histogram(std::vector<uint64_t> bounds)
+                : _bounds(std::move(bounds)),
+                  _buckets(new std::atomic<uint64_t>[_bounds.size() + 1]) {
+                for (std::size_t i = 0; i <= _bounds.size(); ++i) {
+                    _buckets[i] = 0;
+                }
+            }
+
+            void metrics_histogram::observe(uint64_t value) {
+                std::size_t i = 0;
+                while (i < _bounds.size() && value > _bounds[i]) {
+                    ++i;
+                }
+                _buckets[i].fetch_add(1, std::memory_order_relaxed);
+                _sum.fetch_add(value, std::memory_order_relaxed);
+                _count.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            void metrics_histogram::write(
+                std::string &out, const std::string &name, const std::string &labels, double scale
+            ) const {
+                uint64_t cumulative = 0;
+                for (std::size_t i = 0; i <= _bounds.size(); ++i) {
+                    cumulative += _buckets[i].load(std::memory_order_relaxed);
+                    out.append(name).append("_bucket{").append(labels).append(labels.empty() ? "le=\"" : ",le=\"");
+                    out.append(i < _bounds.size() ? format_number(_bounds[i] / scale) : "+Inf");
+                    out.append("\"} ").append(std::to_string(cumulative)).append("\n");
+                }
+                out.append(name).append("_sum");
+                if (!labels.empty()) {
+                    out.append("{").append(labels).append("}");
+                }
+                out.append(" ");
+                out.append(format_number(_sum.load(std::memory_order_relaxed) / scale)).append("\n");
+                // the count is taken from buckets, so the histogram is consistent for a scraper
+                out.append(name).append("_count");
+                if (!labels.empty()) {
+                    out.append("{").append(labels).append("}");
+                }
+                out.append(" ");
+                out.append(std::to_string(cumulative)).append("\n");
+            }
+
+            method_metrics::method_metrics()
+                : duration({50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000,
+                            250000, 500000, 1000000, 2500000, 5000000}),
+                  response_size({128, 512, 2048, 8192, 32768, 131072, 524288, 2097152, 8388608}),
+                  read_lock_wait({10, 50, 100, 500, 1000, 5000, 10000, 50000, 100000, 500000, 1000000}) {
+            }
+
+            std::string write_prometheus_metrics(const method_metrics_map &metrics) {
+                std::string out;
+                out.reserve(metrics.size() * 4096);
+
+                write_header(out, "vizd_rpc_calls_total", "counter", "Number of calls of the API method");
+                for (const auto &item: metrics) {
+                    out.append("vizd_rpc_calls_total{").append(method_label(item.first)).append("} ");
+                    out.append(std::to_string(item.second->calls.load(std::memory_order_relaxed))).append("\n");
+                }
+
+                write_header(out, "vizd_rpc_errors_total", "counter", "Number of calls which responded with error");
+                for (const auto &item: metrics) {
+                    out.append("vizd_rpc_errors_total{").append(method_label(item.first)).append("} ");
+                    out.append(std::to_string(item.second->errors.load(std::memory_order_relaxed))).append("\n");
+                }
+
+                write_header(out, "vizd_rpc_in_flight", "gauge", "Number of calls which are executed now");
+                for (const auto &item: metrics) {
+                    out.append("vizd_rpc_in_flight{").append(method_label(item.first)).append("} ");
+                    out.append(std::to_string(item.second->in_flight.load(std::memory_order_relaxed))).append("\n");
+                }
+
+                write_header(out, "vizd_rpc_call_duration_seconds", "histogram", "Time of execution of the call");
+                for (const auto &item: metrics) {
+                    item.second->duration.write(out, "vizd_rpc_call_duration_seconds", method_label(item.first), 1e6);
+                }
+
+                write_header(out, "vizd_rpc_response_size_bytes", "histogram", "Size of the serialized response");
+                for (const auto &item: metrics) {
+                    item.second->response_size.write(out, "vizd_rpc_response_size_bytes", method_label(item.first), 1);
+                }
+
+                write_header(out, "vizd_rpc_read_lock_wait_seconds", "histogram",
+                             "Time of waiting for the read lock of the database during the call");
+                for (const auto &item: metrics) {
+                    item.second->read_lock_wait.write(
+                        out, "vizd_rpc_read_lock_wait_seconds", method_label(item.first), 1e6);
+                }
+
+                return out;
+            }
+
+        }
+    }
+} // graphene::plugins::json_rpc
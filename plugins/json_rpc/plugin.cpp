@@ -1,7 +1,20 @@
 #include <graphene/plugins/json_rpc/plugin.hpp>
 #include <graphene/plugins/json_rpc/utility.hpp>
-
-#include <boost/algorithm/string.hpp>
+#include <graphene/plugins/json_rpc/method_table.hpp>
+#include <graphene/plugins/json_rpc/request_parser.hpp>
+#include <graphene/plugins/json_rpc/response_cache.hpp>
+#include <graphene/plugins/json_rpc/metrics.hpp>
+#include <graphene/plugins/json_rpc/call_deadline.hpp>
+#include <graphene/plugins/json_rpc/subscription_hub.hpp>
+
+#include <graphene/binary_rpc/protocol.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <set>
 
 #include <fc/log/logger_config.hpp>
 #include <fc/exception/exception.hpp>
@@ -29,13 +42,36 @@ namespace graphene {
                 fc::optional<fc::variant> result;
                 fc::optional<json_rpc_error> error;
                 fc::variant id;
+
+                /// the whole response which is written by json_writer, it isn't reflected
+                fc::optional<std::string> raw_response;
+
+                method_metrics *metrics = nullptr;
             };
 
+            std::string to_json(json_rpc_response &response) {
+                std::string result;
+                if (response.raw_response.valid() && !response.error.valid()) {
+                    result = std::move(*response.raw_response);
+                } else {
+                    result = fc::json::to_string(response);
+                }
+
+                if (response.metrics) {
+                    response.metrics->response_size.observe(result.size());
+                    if (response.error.valid()) {
+                        response.metrics->errors.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+                return result;
+            }
+
             struct msg_pack::impl final {
                 using handler_type = std::function<void (json_rpc_response &)>;
 
                 json_rpc_response response;
                 handler_type handler;
+                std::shared_ptr<subscriber_connection> connection;
             };
 
             msg_pack::msg_pack() {
@@ -103,6 +139,18 @@ namespace graphene {
                 }
             }
 
+            void msg_pack::raw_result(std::string json) {
+                // Pimpl can absent in case if msg_pack delegated its handlers to other msg_pack (see move constructor)
+                FC_ASSERT(valid(), "The msg_pack delegated its handlers");
+                pimpl->response.raw_response = std::move(json);
+                try {
+                    pimpl->handler(pimpl->response);
+                } catch (const websocketpp::exception &) {
+                    // Can't send data via socket -
+                    //    don't pass exception to upper level, because it doesn't have handler for exception
+                }
+            }
+
             fc::optional<fc::variant> msg_pack::result() const {
                 // Pimpl can absent in case if msg_pack delegated its handlers to other msg_pack (see move constructor)
                 if (valid()) {
@@ -135,6 +183,25 @@ namespace graphene {
                 error(code, e.to_string(), fc::variant(*(e.dynamic_copy_exception())));
             }
 
+            void msg_pack::metrics(method_metrics *value) {
+                if (valid()) {
+                    pimpl->response.metrics = value;
+                }
+            }
+
+            std::shared_ptr<subscriber_connection> msg_pack::connection() const {
+                if (valid()) {
+                    return pimpl->connection;
+                }
+                return {};
+            }
+
+            void msg_pack::connection(std::shared_ptr<subscriber_connection> value) {
+                if (valid()) {
+                    pimpl->connection = std::move(value);
+                }
+            }
+
             fc::optional<std::string> msg_pack::error() const {
                 // Pimpl can absent in case if msg_pack delegated its handlers to other msg_pack (see move constructor)
                 if (valid() || pimpl->response.error.valid()) {
@@ -143,6 +210,137 @@ namespace graphene {
                 return fc::optional<std::string>();
             }
 
+            /**
+             * Responses of a batch are placed into the slots by index of calls,
+             * the reply is sent once when the last slot is filled
+             */
+            struct batch_state final {
+                batch_state(vector<std::string> msgs, plugin::response_handler_type handler)
+                    : messages(std::move(msgs)),
+                      parsed(messages.size()),
+                      responses(messages.size()),
+                      filled(new std::atomic<bool>[messages.size()]),
+                      remaining(messages.size()),
+                      response_handler(std::move(handler)) {
+                    for (std::size_t i = 0; i < messages.size(); ++i) {
+                        filled[i] = false;
+                    }
+                }
+
+                /// @return false if the slot was already filled
+                bool fill(std::size_t index, json_rpc_response &response) {
+                    // subscriptions can respond many times, only the first response is a part of the batch
+                    if (filled[index].exchange(true)) {
+                        return false;
+                    }
+                    responses[index] = to_json(response);
+                    if (--remaining == 0) {
+                        response_handler(join());
+                    }
+                    return true;
+                }
+
+                std::string join() const {
+                    std::size_t size = responses.size() + 1;
+                    for (const auto &response: responses) {
+                        size += response.size();
+                    }
+
+                    std::string result;
+                    result.reserve(size);
+                    result.push_back('[');
+                    for (std::size_t i = 0; i < responses.size(); ++i) {
+                        if (i) {
+                            result.push_back(',');
+                        }
+                        result.append(responses[i]);
+                    }
+                    result.push_back(']');
+                    return result;
+                }
+
+                /// the message is parsed once, by the check of serial calls or by its call
+                struct parsed_message {
+                    bool is_parsed = false;
+                    /// slices of the envelope point into the message
+                    bool is_envelope = false;
+                    request_envelope envelope;
+                    /// the message which isn't accepted by the envelope parser, it is null if fc can't parse it too
+                    fc::variant data;
+                };
+
+                const vector<std::string> messages;
+                vector<parsed_message> parsed;
+                /// serialized responses
+                vector<std::string> responses;
+                std::unique_ptr<std::atomic<bool>[]> filled;
+                std::atomic<std::size_t> remaining;
+                plugin::response_handler_type response_handler;
+            };
+
+            /// the resolved method, the table of them is built on startup
+            struct method_entry {
+                string api;
+                string method;
+                /// callables are copied by each rebuild of the tables, so registration doesn't change them during calls
+                std::shared_ptr<const api_method> call;
+                /// not null if the method is enabled in json-rpc-streamed-methods
+                std::shared_ptr<const api_stream_method> stream;
+                /// not null if the method is enabled in json-rpc-cache-methods
+                std::shared_ptr<const cache_predicate> cacheable;
+                /// not null if the method can be called by binary RPC
+                std::shared_ptr<const api_binary_method> binary;
+                uint32_t cache_index = 0;
+                /// not null if metrics are enabled
+                method_metrics *metrics = nullptr;
+                bool is_serial = false;
+                /// the call is moved to the expensive executor
+                bool is_expensive = false;
+                /// zero means no deadline
+                fc::microseconds deadline;
+            };
+
+            using method_entry_ptr = std::shared_ptr<const method_entry>;
+
+            /**
+             * Lookup tables of registered methods. APIs can be registered after the start, while calls are served,
+             * so the tables aren't changed: new tables are built aside and replace the current ones atomically.
+             */
+            struct method_tables {
+                method_table<method_entry> methods;
+                std::set<string> apis;
+                bool has_serial_methods = false;
+                /// methods of binary RPC by id, they are resolved with the method table
+                std::vector<method_entry> binary_methods;
+                std::map<string, uint32_t> binary_method_ids;
+            };
+
+            /// observes the call in the current thread
+            class call_observer final {
+            public:
+                call_observer(method_metrics &metrics, const std::function<uint64_t()> &read_lock_wait_counter)
+                    : _metrics(metrics),
+                      _read_lock_wait_counter(read_lock_wait_counter),
+                      _read_lock_wait_start(read_lock_wait_counter ? read_lock_wait_counter() : 0) {
+                    _metrics.calls.fetch_add(1, std::memory_order_relaxed);
+                    _metrics.in_flight.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                ~call_observer() {
+                    _metrics.duration.observe((fc::time_point::now() - _start).count());
+                    if (_read_lock_wait_counter) {
+                        _metrics.read_lock_wait.observe(_read_lock_wait_counter() - _read_lock_wait_start);
+                    }
+                    _metrics.in_flight.fetch_sub(1, std::memory_order_relaxed);
+                }
+
+            private:
+                method_metrics &_metrics;
+                const std::function<uint64_t()> &_read_lock_wait_counter;
+                const uint64_t _read_lock_wait_start;
+                const fc::time_point _start = fc::time_point::now();
+            };
+
             using get_methods_args     = void_type;
             using get_methods_return   = vector<string>;
             using get_signature_args   = string;
@@ -157,29 +355,175 @@ namespace graphene {
                 }
 
                 void add_api_method(const string &api_name, const string &method_name,
-                                    const api_method &api/*, const api_method_signature& sig*/ ) {
+                                    const api_method &api/*, const api_method_signature& sig*/, bool is_concurrent,
+                                    const api_stream_method &stream_api) {
+                    std::lock_guard<std::mutex> lock(_registration_mutex);
                     _registered_apis[api_name][method_name] = api;
+                    if (stream_api) {
+                        _stream_apis[api_name + '.' + method_name] = stream_api;
+                    }
+                    if (!is_concurrent) {
+                        _serial_methods.insert(api_name + '.' + method_name);
+                    }
                     // _method_sigs[ api_name ][ method_name ] = sig;
                     add_method_reindex(api_name, method_name);
                     std::stringstream canonical_name;
                     canonical_name << api_name << '.' << method_name;
                     _methods.push_back(canonical_name.str());
+                    if (_is_started) {
+                        update_method_table();
+                    }
+                }
+
+                /// it is called under the registration mutex
+                void update_method_table() {
+                    auto tables = std::make_shared<method_tables>();
+                    tables->has_serial_methods = !_serial_methods.empty();
+                    std::vector<method_table<method_entry>::item_type> items;
+                    // the id is the index, 0 is reserved for get_methods
+                    std::vector<method_entry> binary_methods(1);
+                    std::map<string, uint32_t> binary_method_ids;
+                    for (auto &api: _registered_apis) {
+                        tables->apis.insert(api.first);
+                        for (auto &method: api.second) {
+                            auto name = api.first + '.' + method.first;
+
+                            method_entry entry;
+                            entry.api = api.first;
+                            entry.method = method.first;
+                            entry.call = std::make_shared<const api_method>(method.second);
+                            entry.is_serial = _serial_methods.count(name) != 0;
+                            entry.is_expensive = _expensive_methods.count(name) != 0;
+
+                            auto deadline_itr = _method_deadlines.find(name);
+                            if (deadline_itr != _method_deadlines.end()) {
+                                entry.deadline = deadline_itr->second;
+                            } else if (entry.is_expensive) {
+                                entry.deadline = _expensive_deadline;
+                            }
+
+                            auto stream_itr = _streamed_methods.find(name);
+                            if (stream_itr != _streamed_methods.end()) {
+                                entry.stream = std::make_shared<const api_stream_method>(stream_itr->second);
+                            }
+
+                            auto cache_itr = _cached_methods.find(name);
+                            if (cache_itr != _cached_methods.end()) {
+                                entry.cacheable = std::make_shared<const cache_predicate>(_cache_predicates.at(name));
+                                entry.cache_index = cache_itr->second;
+                            }
+
+                            if (_is_metrics_enabled) {
+                                auto &metrics = _metrics[name];
+                                if (!metrics) {
+                                    metrics.reset(new method_metrics());
+                                }
+                                entry.metrics = metrics.get();
+                            }
+
+                            auto binary_itr = _binary_apis.find(name);
+                            if (binary_itr != _binary_apis.end()) {
+                                entry.binary = std::make_shared<const api_binary_method>(binary_itr->second);
+                                binary_method_ids[name] = static_cast<uint32_t>(binary_methods.size());
+                                binary_methods.push_back(entry);
+                            }
+
+                            items.emplace_back(std::move(name), std::move(entry));
+                        }
+                    }
+                    tables->methods.build(std::move(items));
+                    tables->binary_methods = std::move(binary_methods);
+                    tables->binary_method_ids = std::move(binary_method_ids);
+                    std::atomic_store(&_tables, std::shared_ptr<const method_tables>(std::move(tables)));
                 }
 
-                api_method *find_api_method(std::string api, std::string method) {
-                    auto api_itr = _registered_apis.find(api);
-                    FC_ASSERT(api_itr != _registered_apis.end(), "Could not find API ${api}", ("api", api));
+                std::shared_ptr<const method_tables> tables() const {
+                    return std::atomic_load(&_tables);
+                }
 
-                    auto method_itr = api_itr->second.find(method);
-                    FC_ASSERT(method_itr != api_itr->second.end(), "Could not find method ${method}",
-                              ("method", method));
+                /// content of the string value, the escaped value is unescaped by fc into the holder
+                static json_slice string_content(const json_slice &value, std::string &holder) {
+                    json_slice content;
+                    if (!value.get_simple_string(content)) {
+                        holder = fc::json::from_string(value.str()).as_string();
+                        content = to_slice(holder);
+                    }
+                    return content;
+                }
 
-                    return &(method_itr->second);
+                static json_slice to_slice(const std::string &value) {
+                    json_slice result;
+                    result.begin = value.data();
+                    result.end = value.data() + value.size();
+                    return result;
                 }
 
-                api_method *process_params(string method, const fc::variant_object &request, msg_pack &func_args) {
-                    api_method *ret = nullptr;
+                static std::vector<fc::variant> parse_args(const json_slice &args) {
+                    return fc::json::from_string(args.str()).as<std::vector<fc::variant>>();
+                }
+
+                /// the entry keeps the tables alive, they can be replaced while the method is called
+                method_entry_ptr find_method(const json_slice &api, const json_slice &method) const {
+                    std::string name;
+                    name.reserve(api.size() + method.size() + 1);
+                    name.append(api.begin, api.size());
+                    name.push_back('.');
+                    name.append(method.begin, method.size());
+
+                    auto current = tables();
+                    auto entry = current->methods.find(name);
+                    if (!entry) {
+                        FC_ASSERT(current->apis.count(api.str()), "Could not find API ${api}", ("api", api.str()));
+                    }
+                    FC_ASSERT(entry, "Could not find method ${method}", ("method", method.str()));
+                    return method_entry_ptr(std::move(current), entry);
+                }
+
+                /// method is api.method
+                method_entry_ptr find_method(const json_slice &method) const {
+                    auto current = tables();
+                    auto entry = current->methods.find(method.begin, method.size());
+                    if (entry) {
+                        return method_entry_ptr(std::move(current), entry);
+                    }
+
+                    auto dot = std::find(method.begin, method.end, '.');
+                    FC_ASSERT(dot != method.end && std::find(dot + 1, method.end, '.') == method.end,
+                              "method specification invalid. Should be api.method");
+
+                    json_slice api, name;
+                    api.begin = method.begin;
+                    api.end = dot;
+                    name.begin = dot + 1;
+                    name.end = method.end;
+                    return find_method(api, name);
+                }
+
+                method_entry_ptr process_params(const json_slice &method, const json_slice &params, msg_pack &func_args) {
+                    method_entry_ptr ret;
+
+                    if (method.equals("call")) {
+                        std::vector<json_slice> v;
+                        split_json_array(params.begin, params.end, v);
 
+                        FC_ASSERT(v.size() == 2 || v.size() == 3, "params should be {\"api\", \"method\", \"args\"");
+
+                        std::string api_holder, method_holder;
+                        ret = find_method(string_content(v[0], api_holder), string_content(v[1], method_holder));
+                        func_args.args = (v.size() == 3) ? parse_args(v[2]) : std::vector<fc::variant>();
+                    } else {
+                        ret = find_method(method);
+                        // params of api.method are the args
+                        func_args.args = (!params.empty() && *params.begin == '[')
+                                         ? parse_args(params) : std::vector<fc::variant>();
+                    }
+
+                    func_args.plugin = ret->api;
+                    func_args.method = ret->method;
+                    return ret;
+                }
+
+                method_entry_ptr process_params(const string &method, const fc::variant_object &request, msg_pack &func_args) {
                     if (method == "call") {
                         FC_ASSERT(request.contains("params"));
 
@@ -191,25 +535,127 @@ namespace graphene {
 
                         FC_ASSERT(v.size() == 2 || v.size() == 3, "params should be {\"api\", \"method\", \"args\"");
 
-                        ret = find_api_method(v[0].as_string(), v[1].as_string());
-                        func_args.plugin = v[0].as_string();
-                        func_args.method = v[1].as_string();
-                        fc::variant tmp = (v.size() == 3) ? v[2] : fc::json::from_string("{}");
-                        func_args.args = tmp.as<std::vector<fc::variant>>();
+                        auto api_name = v[0].as_string();
+                        auto method_name = v[1].as_string();
+                        auto ret = find_method(to_slice(api_name), to_slice(method_name));
+                        func_args.plugin = ret->api;
+                        func_args.method = ret->method;
+                        func_args.args = (v.size() == 3) ? v[2].as<std::vector<fc::variant>>() : std::vector<fc::variant>();
+                        return ret;
                     } else {
-                        vector<std::string> v;
-                        boost::split(v, method, boost::is_any_of("."));
+                        auto ret = find_method(to_slice(method));
+                        func_args.plugin = ret->api;
+                        func_args.method = ret->method;
+                        func_args.args = (request.contains("params") && request["params"].is_array())
+                                         ? request["params"].as<std::vector<fc::variant>>() : std::vector<fc::variant>();
+                        return ret;
+                    }
+                }
 
-                        FC_ASSERT(v.size() == 2, "method specification invalid. Should be api.method");
+                void call_method(const method_entry &entry, msg_pack &msg) {
+                    if (entry.is_expensive && _expensive_executor) {
+                        return call_expensive_method(entry, msg);
+                    }
+                    run_method(entry, msg);
+                }
 
-                        ret = find_api_method(v[0], v[1]);
-                        func_args.plugin = v[0];
-                        func_args.method = v[1];
-                        fc::variant tmp = (v.size() == 3) ? v[2] : fc::json::from_string("{}");
-                        func_args.args = tmp.as<std::vector<fc::variant>>();
+                /// the call is moved to the expensive executor, the current thread is released at once
+                void call_expensive_method(const method_entry &entry, msg_pack &msg) {
+                    // the move constructor moves only handlers
+                    auto delegated = std::make_shared<msg_pack>(std::move(msg));
+                    delegated->id = std::move(msg.id);
+                    delegated->plugin = std::move(msg.plugin);
+                    delegated->method = std::move(msg.method);
+                    delegated->args = std::move(msg.args);
+
+                    // the entry is copied, the table of methods can be rebuilt while the call waits in the queue
+                    auto is_accepted = _expensive_executor([this, entry, delegated]() {
+                        try {
+                            run_method(entry, *delegated);
+                        } catch (const fc::exception &e) {
+                            if (delegated->valid()) {
+                                delegated->error(e);
+                            }
+                        } catch (const std::exception &e) {
+                            if (delegated->valid()) {
+                                delegated->error(e.what());
+                            }
+                        } catch (...) {
+                            if (delegated->valid()) {
+                                delegated->error("Unknown error - calling method failed");
+                            }
+                        }
+                    });
+
+                    if (!is_accepted) {
+                        delegated->error(JSON_RPC_SERVER_OVERLOADED, "Server is overloaded: queue of expensive calls is full");
                     }
+                }
 
-                    return ret;
+                void run_method(const method_entry &entry, msg_pack &msg) {
+                    call_deadline deadline(entry.deadline);
+                    if (entry.metrics) {
+                        msg.metrics(entry.metrics);
+                        call_observer observer(*entry.metrics, _read_lock_wait_counter);
+                        return execute_method(entry, msg);
+                    }
+                    execute_method(entry, msg);
+                }
+
+                void execute_method(const method_entry &entry, msg_pack &msg) {
+                    try {
+                        if (entry.cacheable) {
+                            rpc_cached(entry, msg);
+                        } else if (entry.stream) {
+                            rpc_stream(*entry.stream, msg);
+                        } else {
+                            auto result = (*entry.call)(msg);
+                            if (msg.valid()) {
+                                msg.result(std::move(result));
+                            }
+                        }
+                    } catch (const fc::timeout_exception &e) {
+                        return msg.error(JSON_RPC_DEADLINE_EXCEEDED, e);
+                    } catch (const fc::assert_exception &e) {
+                        return msg.error(JSON_RPC_ERROR_DURING_CALL, e);
+                    }
+                }
+
+                /// the request is parsed only partially, see request_envelope
+                void rpc_envelope(const request_envelope &request, msg_pack &msg) {
+                    if (!request.id.empty()) {
+                        msg.rpc_id(fc::json::from_string(request.id.str()));
+                    }
+
+                    if (!request.jsonrpc.equals("\"2.0\"")) {
+                        return msg.error(JSON_RPC_INVALID_REQUEST, "jsonrpc value is not \"2.0\"");
+                    } else if (request.method.empty()) {
+                        return msg.error(JSON_RPC_INVALID_REQUEST, "A member \"method\" does not exist");
+                    }
+
+                    std::string method_holder;
+                    json_slice method;
+
+                    try {
+                        method = string_content(request.method, method_holder);
+                    } catch (const fc::assert_exception &e) {
+                        return msg.error(JSON_RPC_METHOD_NOT_FOUND, e);
+                    }
+
+                    // This is to maintain backwards compatibility with existing call structure.
+                    if (method.equals("call") && request.params.empty()) {
+                        return msg.error(JSON_RPC_NO_PARAMS, "A member \"params\" does not exist");
+                    }
+
+                    method_entry_ptr entry;
+
+                    try {
+                        entry = process_params(method, request.params, msg);
+                    } catch (const fc::assert_exception &e) {
+                        return msg.error(JSON_RPC_PARSE_PARAMS_ERROR, e);
+                    }
+
+                    call_method(*entry, msg);
                 }
 
                 void rpc_jsonrpc(const fc::variant_object &request, msg_pack &msg) {
@@ -234,64 +680,178 @@ namespace graphene {
 
                     // This is to maintain backwards compatibility with existing call structure.
                     if ((method == "call" && request.contains("params")) || method != "call") {
-                        api_method *call = nullptr;
+                        method_entry_ptr entry;
 
                         try {
-                            call = process_params(method, request, msg);
+                            entry = process_params(method, request, msg);
                         } catch (const fc::assert_exception &e) {
                             return msg.error(JSON_RPC_PARSE_PARAMS_ERROR, e);
                         }
 
-                        try {
-                            auto result = (*call)(msg);
-                            if (msg.valid()) {
-                                msg.result(std::move(result));
-                            }
-                        } catch (const fc::assert_exception &e) {
-                            return msg.error(JSON_RPC_ERROR_DURING_CALL, e);
-                        }
+                        call_method(*entry, msg);
                     } else {
                         return msg.error(JSON_RPC_NO_PARAMS, "A member \"params\" does not exist");
                     }
                 }
 
+                void rpc_stream(const api_stream_method &call, msg_pack &msg) {
+                    // the size of the previous response is a good estimation for the buffer
+                    static thread_local std::size_t last_size = 0;
+
+                    json_writer writer(last_size + 64);
+                    writer.write_raw("{\"jsonrpc\":\"2.0\",\"result\":");
+                    call(msg, writer);
+
+                    // the method delegated its response to other msg_pack
+                    if (!msg.valid()) {
+                        return;
+                    }
+
+                    write_response_end(writer, msg);
+                    last_size = writer.str().size();
+                    msg.raw_result(writer.release());
+                }
+
+                static void write_response_end(json_writer &writer, const msg_pack &msg) {
+                    auto id = msg.rpc_id();
+                    writer.write_raw(",\"id\":");
+                    writer.write_raw(fc::json::to_string(id.valid() ? *id : fc::variant()));
+                    writer.write_raw("}");
+                }
+
+                void rpc_cached(const method_entry &entry, msg_pack &msg) {
+                    auto key = entry.api + '.' + entry.method + ':' +
+                               (msg.args.valid() ? fc::json::to_string(*msg.args) : std::string());
+
+                    auto value = _cache.find(entry.cache_index, key);
+                    if (!value) {
+                        // the predicate is checked before the call, the result can only become immutable during it
+                        bool is_immutable = false;
+                        try {
+                            is_immutable = (*entry.cacheable)(msg);
+                        } catch (...) {
+                            // invalid args are reported by the call
+                        }
+
+                        std::string result;
+                        if (entry.stream) {
+                            json_writer writer;
+                            (*entry.stream)(msg, writer);
+                            result = writer.release();
+                        } else {
+                            result = fc::json::to_string((*entry.call)(msg));
+                        }
+
+                        // the method delegated its response to other msg_pack
+                        if (!msg.valid()) {
+                            return;
+                        }
+
+                        value = std::make_shared<const std::string>(std::move(result));
+                        if (is_immutable) {
+                            _cache.insert(entry.cache_index, std::move(key), value);
+                        } else {
+                            _cache.skip(entry.cache_index);
+                        }
+                    }
+
+                    json_writer writer(value->size() + 64);
+                    writer.write_raw("{\"jsonrpc\":\"2.0\",\"result\":");
+                    writer.write_raw(*value);
+                    write_response_end(writer, msg);
+                    msg.raw_result(writer.release());
+                }
+
+                void enable_cached_methods(const vector<string> &names) {
+                    if (!_cache.enabled()) {
+                        return;
+                    }
+
+                    for (const auto &name: names) {
+                        if (!_cache_predicates.count(name)) {
+                            wlog("Method ${m} from json-rpc-cache-methods isn't cacheable", ("m", name));
+                            continue;
+                        }
+                        if (!_cached_methods.count(name)) {
+                            _cached_methods[name] = _cache.add_method(name);
+                            ilog("Immutable results of ${m} are cached", ("m", name));
+                        }
+                    }
+                }
+
+                void enable_streamed_methods(const vector<string> &names) {
+                    for (const auto &name: names) {
+                        auto itr = _stream_apis.find(name);
+                        if (itr == _stream_apis.end()) {
+                            wlog("Method ${m} from json-rpc-streamed-methods isn't registered", ("m", name));
+                            continue;
+                        }
+                        _streamed_methods[name] = itr->second;
+                        ilog("Results of ${m} are written to JSON directly", ("m", name));
+                    }
+                }
+
+                static std::string to_log(const fc::variant& data) {
+                    return fc::json::to_string(data);
+                }
+
+                static const std::string& to_log(const std::string& data) {
+                    return data;
+                }
+
+                /// logs calls on the debug level, nothing is done on other levels
+                template<typename Data>
                 struct dump_rpc_time {
-                    dump_rpc_time(const fc::variant& data)
+                    dump_rpc_time(const Data& data)
                         : data_(data) {
-
-                        dlog("data: ${data}", ("data", fc::json::to_string(data_)));
+                        // fc::logger::get() looks up the logger by name under lock, so it is done once
+                        static fc::logger logger = fc::logger::get(DEFAULT_LOGGER);
+                        is_enabled_ = logger.is_enabled(fc::log_level::debug);
+                        if (is_enabled_) {
+                            start_ = fc::time_point::now();
+                            text_ = to_log(data_);
+                            dlog("data: ${data}", ("data", text_));
+                        }
                     }
 
                     ~dump_rpc_time() {
+                        if (!is_enabled_) {
+                            return;
+                        }
                         if (error_.empty()) {
                             dlog(
                                 "elapsed: ${time} sec, data: ${data}",
-                                ("data", fc::json::to_string(data_))
+                                ("data", text_)
                                 ("time", double((fc::time_point::now() - start_).count()) / 1000000.0));
                         } else {
                             dlog(
                                 "elapsed: ${time} sec, error: '${error}', data: ${data}",
-                                ("data", fc::json::to_string(data_))
+                                ("data", text_)
                                 ("error", error_)
                                 ("time", double((fc::time_point::now() - start_).count()) / 1000000.0));
                         }
                     }
 
                     void error(std::string value) {
-                        error_ = std::move(value);
+                        if (is_enabled_) {
+                            error_ = std::move(value);
+                        }
                     }
 
                 private:
-                    fc::time_point start_ = fc::time_point::now();
+                    bool is_enabled_ = false;
+                    fc::time_point start_;
+                    std::string text_;
                     std::string error_;
-                    const fc::variant& data_;
+                    const Data& data_;
                 };
 
-                void rpc(const fc::variant& data, msg_pack& msg) {
-                    dump_rpc_time dump(data);
+                template<typename Data, typename Call>
+                void rpc_guarded(const Data& data, msg_pack& msg, Call&& call) {
+                    dump_rpc_time<Data> dump(data);
 
                     try {
-                        rpc_jsonrpc(data.get_object(), msg);
+                        call();
                     } catch (const fc::parse_error_exception& e) {
                         msg.error(JSON_RPC_INVALID_PARAMS, e);
                         dump.error("invalid params");
@@ -310,29 +870,379 @@ namespace graphene {
                     }
                 }
 
-                void rpc(vector<fc::variant> messages, response_handler_type response_handler) {
-                    auto responses = std::make_shared<vector<json_rpc_response>>();
+                void rpc(const fc::variant& data, msg_pack& msg) {
+                    rpc_guarded(data, msg, [&]() {
+                        rpc_jsonrpc(data.get_object(), msg);
+                    });
+                }
+
+                void rpc(const std::string& message, msg_pack& msg) {
+                    request_envelope request;
+                    if (request.parse(message)) {
+                        return rpc_guarded(message, msg, [&]() {
+                            rpc_envelope(request, msg);
+                        });
+                    }
+
+                    // requests which aren't accepted by the envelope parser are parsed by fc
+                    fc::variant data;
+                    try {
+                        data = fc::json::from_string(message);
+                    } catch (const fc::exception& e) {
+                        return msg.error(JSON_RPC_PARSE_ERROR, e);
+                    }
+                    rpc(data, msg);
+                }
+
+                static std::string pack_response(const binary_rpc::response &response) {
+                    std::string result(fc::raw::pack_size(response), '\0');
+                    fc::datastream<char *> stream(&result[0], result.size());
+                    fc::raw::pack(stream, response);
+                    return result;
+                }
+
+                static void send_binary(const binary_rpc::response &response, const plugin::response_handler_type &handler) {
+                    try {
+                        handler(pack_response(response));
+                    } catch (const websocketpp::exception &) {
+                        // Can't send data via socket -
+                        //    don't pass exception to upper level, because it doesn't have handler for exception
+                    }
+                }
 
-                    responses->reserve(messages.size());
+                std::string binary_error(const std::string &message, int32_t code, const std::string &text) const {
+                    binary_rpc::response response;
+                    try {
+                        response.id = fc::raw::unpack<binary_rpc::request>(
+                            message.data(), static_cast<uint32_t>(message.size())).id;
+                    } catch (...) {
+                        // the invalid request gets the response with zero id
+                    }
+                    response.code = code;
+                    response.message = text;
+                    return pack_response(response);
+                }
 
-                    std::function<void()> next_handler = [response_handler, responses]{
-                        response_handler(fc::json::to_string(*responses.get()));
+                void rpc_binary(const std::string &message, const plugin::response_handler_type &handler) {
+                    binary_rpc::request request;
+                    try {
+                        request = fc::raw::unpack<binary_rpc::request>(message.data(), static_cast<uint32_t>(message.size()));
+                    } catch (const fc::exception &e) {
+                        binary_rpc::response response;
+                        response.code = JSON_RPC_PARSE_ERROR;
+                        response.message = e.to_string();
+                        return send_binary(response, handler);
+                    }
+
+                    binary_rpc::response response;
+                    response.id = request.id;
+
+                    const auto current = tables();
+                    if (request.method == binary_rpc::get_methods_id) {
+                        response.result = fc::raw::pack(current->binary_method_ids);
+                        return send_binary(response, handler);
+                    }
+
+                    if (request.method >= current->binary_methods.size()) {
+                        response.code = JSON_RPC_METHOD_NOT_FOUND;
+                        response.message = "Could not find method with id " + std::to_string(request.method);
+                        return send_binary(response, handler);
+                    }
+
+                    // the entry is copied, the table of methods can be rebuilt while the call waits in the queue
+                    const auto entry = current->binary_methods[request.method];
+                    if (entry.is_expensive && _expensive_executor) {
+                        auto delegated = std::make_shared<binary_rpc::request>(std::move(request));
+                        auto is_accepted = _expensive_executor([this, entry, delegated, handler]() {
+                            run_binary(entry, *delegated, handler);
+                        });
+
+                        if (!is_accepted) {
+                            response.code = JSON_RPC_SERVER_OVERLOADED;
+                            response.message = "Server is overloaded: queue of expensive calls is full";
+                            send_binary(response, handler);
+                        }
+                        return;
+                    }
+
+                    run_binary(entry, request, handler);
+                }
+
+                void run_binary(
+                    const method_entry &entry, binary_rpc::request &request, const plugin::response_handler_type &handler
+                ) {
+                    binary_rpc::response response;
+                    response.id = request.id;
+
+                    {
+                        call_deadline deadline(entry.deadline);
+                        if (entry.metrics) {
+                            call_observer observer(*entry.metrics, _read_lock_wait_counter);
+                            execute_binary(entry, request, response);
+                        } else {
+                            execute_binary(entry, request, response);
+                        }
+                    }
+
+                    auto data = pack_response(response);
+                    if (entry.metrics) {
+                        entry.metrics->response_size.observe(data.size());
+                        if (response.code != 0) {
+                            entry.metrics->errors.fetch_add(1, std::memory_order_relaxed);
+                        }
+                    }
+
+                    try {
+                        handler(std::move(data));
+                    } catch (const websocketpp::exception &) {
+                        // the connection is closed
+                    }
+                }
+
+                static void execute_binary(
+                    const method_entry &entry, binary_rpc::request &request, binary_rpc::response &response
+                ) {
+                    auto set_error = [&](int32_t code, std::string message) {
+                        response.code = code;
+                        response.message = std::move(message);
+                        response.result.clear();
                     };
 
-                    for (auto it = messages.rbegin(); messages.rend() != it; ++it) {
-                        auto v = *it;
+                    try {
+                        // the handler isn't used, the result is packed by the method
+                        msg_pack msg([](json_rpc_response &) {});
+                        msg.plugin = entry.api;
+                        msg.method = entry.method;
+                        msg.args = std::move(request.args);
+
+                        (*entry.binary)(msg, response.result);
+
+                        if (!msg.valid()) {
+                            set_error(JSON_RPC_INTERNAL_ERROR, "The method can't be called by binary RPC");
+                        }
+                    } catch (const fc::timeout_exception &e) {
+                        set_error(JSON_RPC_DEADLINE_EXCEEDED, e.to_string());
+                    } catch (const fc::parse_error_exception &e) {
+                        set_error(JSON_RPC_INVALID_PARAMS, e.to_string());
+                    } catch (const fc::bad_cast_exception &e) {
+                        set_error(JSON_RPC_INVALID_PARAMS, e.to_string());
+                    } catch (const fc::assert_exception &e) {
+                        set_error(JSON_RPC_ERROR_DURING_CALL, e.to_string());
+                    } catch (const fc::exception &e) {
+                        set_error(JSON_RPC_SERVER_ERROR, e.to_string());
+                    } catch (const std::exception &e) {
+                        set_error(JSON_RPC_SERVER_ERROR, e.what());
+                    } catch (...) {
+                        set_error(JSON_RPC_SERVER_ERROR, "Unknown error - calling method failed");
+                    }
+                }
+
+                void add_binary_method(const string &api_name, const string &method_name, api_binary_method call) {
+                    std::lock_guard<std::mutex> lock(_registration_mutex);
+                    _binary_apis[api_name + '.' + method_name] = std::move(call);
+                    if (_is_started) {
+                        update_method_table();
+                    }
+                }
+
+                void set_serial_method(const string &api_name, const string &method_name) {
+                    std::lock_guard<std::mutex> lock(_registration_mutex);
+                    _serial_methods.insert(api_name + '.' + method_name);
+                    if (_is_started) {
+                        update_method_table();
+                    }
+                }
+
+                void set_expensive_method(const string &api_name, const string &method_name) {
+                    std::lock_guard<std::mutex> lock(_registration_mutex);
+                    _expensive_methods.insert(api_name + '.' + method_name);
+                    if (_is_started) {
+                        update_method_table();
+                    }
+                }
+
+                void set_cacheable_method(const string &api_name, const string &method_name, cache_predicate predicate) {
+                    std::lock_guard<std::mutex> lock(_registration_mutex);
+                    const auto name = api_name + '.' + method_name;
+                    _cache_predicates[name] = std::move(predicate);
+                    if (_is_started) {
+                        // methods are added to the cache only on startup, the cache isn't changed during calls
+                        if (!_cached_methods.count(name) &&
+                            std::find(_cached_method_names.begin(), _cached_method_names.end(), name) != _cached_method_names.end()
+                        ) {
+                            wlog("Method ${m} from json-rpc-cache-methods is cacheable after the start, it isn't cached",
+                                 ("m", name));
+                        }
+                        update_method_table();
+                    }
+                }
+
+                bool is_concurrent(const fc::variant &message) const {
+                    auto current = tables();
+                    if (!current->has_serial_methods) {
+                        return true;
+                    }
+
+                    try {
+                        const auto &request = message.get_object();
+                        auto method = request["method"].as_string();
+                        if (method == "call") {
+                            const auto &params = request["params"].get_array();
+                            method = params.at(0).as_string() + '.' + params.at(1).as_string();
+                        }
+                        auto entry = current->methods.find(method);
+                        return !entry || !entry->is_serial;
+                    } catch (...) {
+                        // the invalid call only responds with error, it doesn't depend on other calls
+                        return true;
+                    }
+                }
+
+                bool is_concurrent(const batch_state::parsed_message &parsed) const {
+                    if (!parsed.is_envelope) {
+                        // the message which can't be parsed only responds with error
+                        return parsed.data.is_null() || is_concurrent(parsed.data);
+                    }
+
+                    const auto &request = parsed.envelope;
+                    try {
+                        std::string method_holder;
+                        auto method = string_content(request.method, method_holder);
+
+                        method_entry_ptr entry;
+                        if (method.equals("call")) {
+                            std::vector<json_slice> params;
+                            split_json_array(request.params.begin, request.params.end, params);
+
+                            std::string api_holder, name_holder;
+                            entry = find_method(
+                                string_content(params.at(0), api_holder), string_content(params.at(1), name_holder));
+                        } else {
+                            entry = find_method(method);
+                        }
+                        return !entry->is_serial;
+                    } catch (...) {
+                        return true;
+                    }
+                }
+
+                /// returns false if the executor has rejected the task
+                bool execute(std::function<void()> task) {
+                    if (_batch_executor) {
+                        return _batch_executor(std::move(task));
+                    }
+                    task();
+                    return true;
+                }
+
+                /// parses the message of the batch, it is done once for the check of serial calls and the call
+                static const batch_state::parsed_message &parse(batch_state &state, std::size_t index) {
+                    auto &parsed = state.parsed[index];
+                    if (!parsed.is_parsed) {
+                        parsed.is_parsed = true;
+                        parsed.is_envelope = parsed.envelope.parse(state.messages[index]);
+                        if (!parsed.is_envelope) {
+                            try {
+                                parsed.data = fc::json::from_string(state.messages[index]);
+                            } catch (...) {
+                                // the call parses the message again to respond with the parse error
+                            }
+                        }
+                    }
+                    return parsed;
+                }
+
+                /// calls the message of the batch by its parsed request
+                void rpc(batch_state &state, std::size_t index, msg_pack &msg) {
+                    const auto &parsed = parse(state, index);
+                    if (parsed.is_envelope) {
+                        return rpc_guarded(state.messages[index], msg, [&]() {
+                            rpc_envelope(parsed.envelope, msg);
+                        });
+                    } else if (!parsed.data.is_null()) {
+                        return rpc(parsed.data, msg);
+                    }
+                    rpc(state.messages[index], msg);
+                }
+
+                /// responds to the call of the batch which isn't admitted by the batch executor
+                void reject(std::shared_ptr<batch_state> state, std::size_t index) {
+                    msg_pack msg([state, index](json_rpc_response &response) {
+                        state->fill(index, response);
+                    });
+
+                    try {
+                        const auto &parsed = parse(*state, index);
+                        if (parsed.is_envelope) {
+                            if (!parsed.envelope.id.empty()) {
+                                msg.rpc_id(fc::json::from_string(parsed.envelope.id.str()));
+                            }
+                        } else if (parsed.data.is_object() && parsed.data.get_object().contains("id")) {
+                            msg.rpc_id(parsed.data.get_object()["id"]);
+                        }
+                    } catch (...) {
+                        // the id is invalid, the error is responded without it
+                    }
+
+                    msg.error(JSON_RPC_SERVER_OVERLOADED, "Server is overloaded: the call of the batch isn't admitted");
+                }
+
+                /// executes the serial calls from the position, the next one starts after the response of the previous
+                void rpc_serial(
+                    std::shared_ptr<batch_state> state,
+                    std::shared_ptr<vector<std::size_t>> indexes,
+                    std::size_t position
+                ) {
+                    if (position == indexes->size()) {
+                        return;
+                    }
 
-                        next_handler = [next_handler, responses, v, this]{
-                            msg_pack msg([next_handler, responses](json_rpc_response &response){
-                                responses->push_back(response);
-                                next_handler();
+                    const auto index = (*indexes)[position];
+                    msg_pack msg([this, state, indexes, index, position](json_rpc_response &response) {
+                        if (state->fill(index, response)) {
+                            rpc_serial(state, indexes, position + 1);
+                        }
+                    });
+
+                    rpc(*state, index, msg);
+                }
+
+                void rpc(vector<std::string> messages, response_handler_type response_handler) {
+                    auto state = std::make_shared<batch_state>(std::move(messages), std::move(response_handler));
+                    auto serial = std::make_shared<vector<std::size_t>>();
+                    // without serial methods messages are parsed by their calls in parallel
+                    const bool has_serial_methods = tables()->has_serial_methods;
+
+                    for (std::size_t i = 0; i < state->messages.size(); ++i) {
+                        if (has_serial_methods && !is_concurrent(parse(*state, i))) {
+                            serial->push_back(i);
+                            continue;
+                        }
+
+                        auto is_accepted = execute([this, state, i]{
+                            msg_pack msg([state, i](json_rpc_response &response){
+                                state->fill(i, response);
                             });
 
-                            this->rpc(v, msg);
-                        };
+                            this->rpc(*state, i, msg);
+                        });
+
+                        if (!is_accepted) {
+                            reject(state, i);
+                        }
                     }
 
-                    next_handler();
+                    if (!serial->empty()) {
+                        auto is_accepted = execute([this, state, serial]{
+                            rpc_serial(state, serial, 0);
+                        });
+
+                        if (!is_accepted) {
+                            for (auto index: *serial) {
+                                reject(state, index);
+                            }
+                        }
+                    }
                 }
 
                 void initialize() {
@@ -358,8 +1268,37 @@ namespace graphene {
 
                 map<string, api_description> _registered_apis;
                 vector<string> _methods;
+                std::set<string> _serial_methods;
+                plugin::pool_executor_type _batch_executor;
+                std::set<string> _expensive_methods;
+                plugin::pool_executor_type _expensive_executor;
+                /// deadlines from json-rpc-method-deadline
+                std::map<string, fc::microseconds> _method_deadlines;
+                /// the deadline of expensive methods without own deadline
+                fc::microseconds _expensive_deadline;
+                vector<string> _streamed_method_names;
+                vector<string> _cached_method_names;
+                response_cache _cache;
+                subscription_hub _subscriptions;
                 map<string, map<string, api_method_signature> > _method_sigs;
+                bool _is_started = false;
+                bool _is_metrics_enabled = false;
+                std::function<uint64_t()> _read_lock_wait_counter;
+                /// metrics are added by registration of methods, it is guarded by the registration mutex
+                method_metrics_map _metrics;
+                /// registration changes the maps of methods and rebuilds the tables
+                std::mutex _registration_mutex;
             private:
+                std::shared_ptr<const method_tables> _tables = std::make_shared<method_tables>();
+                /// methods which can write their results by json_writer
+                std::map<string, api_stream_method> _stream_apis;
+                /// methods enabled by json-rpc-streamed-methods
+                std::map<string, api_stream_method> _streamed_methods;
+                std::map<string, cache_predicate> _cache_predicates;
+                /// methods enabled by json-rpc-cache-methods, the value is the index of the method in the cache stats
+                std::map<string, uint32_t> _cached_methods;
+                /// methods which results can be packed by fc::raw
+                std::map<string, api_binary_method> _binary_apis;
                 // This is a reindex which allows to get parent plugin by method
                 // unordered_map[method] -> plugin
                 // For example:
@@ -375,16 +1314,99 @@ namespace graphene {
             plugin::~plugin() {
             }
 
+            void plugin::set_program_options(boost::program_options::options_description &,
+                                             boost::program_options::options_description &cfg) {
+                cfg.add_options()
+                    ("json-rpc-streamed-methods",
+                        boost::program_options::value<vector<string>>()->composing()->multitoken(),
+                        "Methods (api.method) which results are written to JSON directly from API objects "
+                        "without fc::variant, for example: database_api.get_block")
+                    ("json-rpc-cache-methods",
+                        boost::program_options::value<vector<string>>()->composing()->multitoken(),
+                        "Methods (api.method) which immutable results are cached, for example: database_api.get_block")
+                    ("json-rpc-cache-size-mb", boost::program_options::value<uint32_t>()->default_value(128),
+                        "Memory limit of the response cache in MB, 0 disables the cache")
+                    ("json-rpc-cache-shards", boost::program_options::value<uint32_t>()->default_value(16),
+                        "Number of independently locked parts of the response cache")
+                    ("json-rpc-expensive-methods",
+                        boost::program_options::value<vector<string>>()->composing()->multitoken(),
+                        "Methods (api.method) which are executed on the expensive thread pool in addition to the methods "
+                        "registered as expensive by plugins, for example: follow.get_feed")
+                    ("json-rpc-expensive-deadline-ms", boost::program_options::value<uint32_t>()->default_value(0),
+                        "Deadline of calls of expensive methods in milliseconds, 0 means no deadline")
+                    ("json-rpc-subscription-buffer-mb", boost::program_options::value<uint32_t>()->default_value(16),
+                        "Maximum size of unsent messages of subscriptions per connection in MB, "
+                        "the slower connection is closed")
+                    ("json-rpc-max-subscriptions-per-connection", boost::program_options::value<uint32_t>()->default_value(16),
+                        "Maximum number of subscriptions of one websocket connection")
+                    ("json-rpc-method-deadline",
+                        boost::program_options::value<vector<string>>()->composing()->multitoken(),
+                        "Deadline of calls of the method in format api.method=milliseconds, "
+                        "for example: tags.get_discussions_by_trending=2000");
+            }
+
             void plugin::plugin_initialize(const boost::program_options::variables_map &options) {
                 ilog("json_rpc plugin: plugin_initialize() begin");
                 pimpl = std::make_unique<impl>();
                 pimpl->initialize();
+                if (options.count("json-rpc-streamed-methods")) {
+                    pimpl->_streamed_method_names = options.at("json-rpc-streamed-methods").as<vector<string>>();
+                }
+                if (options.count("json-rpc-cache-methods")) {
+                    pimpl->_cached_method_names = options.at("json-rpc-cache-methods").as<vector<string>>();
+                    pimpl->_cache.configure(
+                        std::size_t(options.at("json-rpc-cache-size-mb").as<uint32_t>()) * 1024 * 1024,
+                        options.at("json-rpc-cache-shards").as<uint32_t>());
+                }
+
+                if (options.count("json-rpc-expensive-methods")) {
+                    for (const auto &method: options.at("json-rpc-expensive-methods").as<vector<string>>()) {
+                        pimpl->_expensive_methods.insert(method);
+                    }
+                }
+                pimpl->_expensive_deadline = fc::milliseconds(options.at("json-rpc-expensive-deadline-ms").as<uint32_t>());
+                if (options.count("json-rpc-method-deadline")) {
+                    for (const auto &item: options.at("json-rpc-method-deadline").as<vector<string>>()) {
+                        auto pos = item.rfind('=');
+                        FC_ASSERT(pos != string::npos && pos > 0,
+                                  "json-rpc-method-deadline should be api.method=milliseconds: ${i}", ("i", item));
+                        auto milliseconds_text = item.substr(pos + 1);
+                        std::size_t parsed = 0;
+                        unsigned long long milliseconds = 0;
+                        try {
+                            milliseconds = std::stoull(milliseconds_text, &parsed);
+                        } catch (const std::exception &) {
+                            parsed = 0;
+                        }
+                        FC_ASSERT(parsed > 0 && parsed == milliseconds_text.size() &&
+                                  milliseconds <= std::numeric_limits<uint32_t>::max(),
+                                  "deadline in json-rpc-method-deadline should be milliseconds: ${i}", ("i", item));
+                        pimpl->_method_deadlines[item.substr(0, pos)] = fc::milliseconds(milliseconds);
+                    }
+                }
+
+                subscription_hub::limits subscription_limits;
+                subscription_limits.max_buffered_bytes =
+                    std::size_t(options.at("json-rpc-subscription-buffer-mb").as<uint32_t>()) * 1024 * 1024;
+                subscription_limits.max_subscriptions_per_connection =
+                    options.at("json-rpc-max-subscriptions-per-connection").as<uint32_t>();
+                pimpl->_subscriptions.configure(subscription_limits);
+
+                add_api_method(name(), "get_response_cache_stats", [this](msg_pack &) -> fc::variant {
+                    return fc::variant(pimpl->_cache.stats());
+                });
                 ilog("json_rpc plugin: plugin_initialize() end");
             }
 
             void plugin::plugin_startup() {
                 ilog("json_rpc plugin: plugin_startup() begin");
+                std::lock_guard<std::mutex> lock(pimpl->_registration_mutex);
                 std::sort(pimpl->_methods.begin(), pimpl->_methods.end());
+                // APIs are registered on initialization of plugins
+                pimpl->enable_streamed_methods(pimpl->_streamed_method_names);
+                pimpl->enable_cached_methods(pimpl->_cached_method_names);
+                pimpl->update_method_table();
+                pimpl->_is_started = true;
                 ilog("json_rpc plugin: plugin_startup() end");
             }
 
@@ -395,25 +1417,104 @@ namespace graphene {
             }
 
             void plugin::add_api_method(const string &api_name, const string &method_name,
-                                        const api_method &api/*, const api_method_signature& sig */) {
-                pimpl->add_api_method(api_name, method_name, api/*, sig*/ );
+                                        const api_method &api/*, const api_method_signature& sig */,
+                                        bool is_concurrent, const api_stream_method &stream_api) {
+                pimpl->add_api_method(api_name, method_name, api/*, sig*/, is_concurrent, stream_api);
+            }
+
+            void plugin::add_binary_method(const string &api_name, const string &method_name, api_binary_method call) {
+                pimpl->add_binary_method(api_name, method_name, std::move(call));
+            }
+
+            void plugin::set_serial_method(const string &api_name, const string &method_name) {
+                pimpl->set_serial_method(api_name, method_name);
+            }
+
+            void plugin::enable_metrics(std::function<uint64_t()> read_lock_wait_counter) {
+                std::lock_guard<std::mutex> lock(pimpl->_registration_mutex);
+                pimpl->_is_metrics_enabled = true;
+                pimpl->_read_lock_wait_counter = std::move(read_lock_wait_counter);
+                if (pimpl->_is_started) {
+                    pimpl->update_method_table();
+                }
+            }
+
+            std::string plugin::get_metrics() const {
+                std::string metrics;
+                {
+                    // metrics of methods are added by registration
+                    std::lock_guard<std::mutex> lock(pimpl->_registration_mutex);
+                    metrics = write_prometheus_metrics(pimpl->_metrics);
+                }
+                return metrics + pimpl->_subscriptions.get_metrics();
+            }
+
+            subscription_hub &plugin::subscriptions() {
+                return pimpl->_subscriptions;
+            }
+
+            void plugin::set_cacheable_method(const string &api_name, const string &method_name, cache_predicate predicate) {
+                pimpl->set_cacheable_method(api_name, method_name, std::move(predicate));
+            }
+
+            void plugin::set_batch_executor(pool_executor_type executor) {
+                pimpl->_batch_executor = std::move(executor);
+            }
+
+            void plugin::set_expensive_method(const string &api_name, const string &method_name) {
+                pimpl->set_expensive_method(api_name, method_name);
+            }
+
+            void plugin::set_expensive_executor(pool_executor_type executor) {
+                pimpl->_expensive_executor = std::move(executor);
+            }
+
+            void plugin::call_binary(const string &message, response_handler_type response_handler) {
+                pimpl->rpc_binary(message, response_handler);
+            }
+
+            std::string plugin::binary_error(const string &message, int32_t code, const string &text) const {
+                return pimpl->binary_error(message, code, text);
             }
 
             void plugin::call(const string &message, response_handler_type response_handler) {
-                try {
-                    fc::variant v = fc::json::from_string(message);
+                call(message, std::move(response_handler), nullptr);
+            }
 
-                    if (v.is_array()) {
-                        vector<fc::variant> messages = v.as<vector<fc::variant>>();
+            void plugin::call(
+                const string &message, response_handler_type response_handler,
+                std::shared_ptr<subscriber_connection> connection
+            ) {
+                try {
+                    auto first = std::find_if(message.begin(), message.end(), [](char c) {
+                        return c != ' ' && c != '\t' && c != '\r' && c != '\n';
+                    });
+
+                    if (first != message.end() && *first == '[') {
+                        vector<string> messages;
+                        vector<json_slice> items;
+                        if (split_json_array(message, items)) {
+                            messages.reserve(items.size());
+                            for (const auto &item: items) {
+                                messages.push_back(item.str());
+                            }
+                        } else {
+                            // the array is malformed or unusual, fc reports the error or parses it
+                            for (const auto &item: fc::json::from_string(message).get_array()) {
+                                messages.push_back(fc::json::to_string(item));
+                            }
+                        }
 
                         FC_ASSERT(messages.size(), "Array is invalid");
-                        pimpl->rpc(messages, response_handler);
+                        pimpl->rpc(std::move(messages), response_handler);
                     } else {
                         msg_pack msg([response_handler](json_rpc_response &response){
-                            response_handler(fc::json::to_string(response));
+                            response_handler(to_json(response));
                         });
+                        // only single calls can subscribe, a batch is responded once
+                        msg.connection(std::move(connection));
 
-                        pimpl->rpc(v, msg);
+                        pimpl->rpc(message, msg);
                     }
                 } catch (const fc::exception &e) {
                     json_rpc_response response;
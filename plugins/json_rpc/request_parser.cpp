@@ -0,0 +1,218 @@
+#include <graphene/plugins/json_rpc/request_parser.hpp>
+
+namespace graphene {
+    namespace plugins {
+        namespace json_rpc {
+            namespace {
+                void skip_spaces(const char *&p, const char *end) {
+                    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+                        ++p;
+                    }
+                }
+
+                bool skip_string(const char *&p, const char *end, bool &has_escapes) {
+                    ++p; // opening quote
+                    while (p < end) {
+                        const auto c = *p++;
+                        if (c == '"') {
+                            return true;
+                        } else if (c == '\\') {
+                            if (p == end) {
+                                return false;
+                            }
+                            ++p;
+                            has_escapes = true;
+                        } else if (static_cast<unsigned char>(c) < 0x20) {
+                            return false;
+                        }
+                    }
+                    return false;
+                }
+
+                bool skip_value(const char *&p, const char *end) {
+                    if (p == end) {
+                        return false;
+                    }
+
+                    bool has_escapes = false;
+                    switch (*p) {
+                        case '"':
+                            return skip_string(p, end, has_escapes);
+
+                        case '{':
+                        case '[': {
+                            uint32_t depth = 0;
+                            while (p < end) {
+                                const auto c = *p;
+                                if (c == '"') {
+                                    if (!skip_string(p, end, has_escapes)) {
+                                        return false;
+                                    }
+                                    continue;
+                                }
+                                ++p;
+                                if (c == '{' || c == '[') {
+                                    ++depth;
+                                } else if ((c == '}' || c == ']') && --depth == 0) {
+                                    return true;
+                                }
+                            }
+                            return false;
+                        }
+
+                        case ',':
+                        case ':':
+                        case '}':
+                        case ']':
+                            return false;
+
+                        default: {
+                            // numbers, true, false and null
+                            const auto start = p;
+                            while (p < end && *p != ',' && *p != '}' && *p != ']' &&
+                                   *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n'
+                            ) {
+                                ++p;
+                            }
+                            return p != start;
+                        }
+                    }
+                }
+            }
+
+            bool json_slice::get_simple_string(json_slice &content) const {
+                if (size() < 2 || *begin != '"' || *(end - 1) != '"') {
+                    return false;
+                }
+                for (auto p = begin + 1; p < end - 1; ++p) {
+                    if (*p == '\\' || *p == '"') {
+                        return false;
+                    }
+                }
+                content.begin = begin + 1;
+                content.end = end - 1;
+                return true;
+            }
+
+            bool request_envelope::parse(const char *begin, const char *end) {
+                *this = request_envelope();
+
+                auto p = begin;
+                skip_spaces(p, end);
+                if (p == end || *p != '{') {
+                    return false;
+                }
+                ++p;
+
+                skip_spaces(p, end);
+                if (p < end && *p == '}') {
+                    ++p;
+                } else {
+                    for (;;) {
+                        skip_spaces(p, end);
+                        if (p == end || *p != '"') {
+                            return false;
+                        }
+
+                        json_slice name;
+                        name.begin = p + 1;
+                        bool has_escapes = false;
+                        if (!skip_string(p, end, has_escapes) || has_escapes) {
+                            return false;
+                        }
+                        name.end = p - 1;
+
+                        skip_spaces(p, end);
+                        if (p == end || *p != ':') {
+                            return false;
+                        }
+                        ++p;
+                        skip_spaces(p, end);
+
+                        json_slice value;
+                        value.begin = p;
+                        if (!skip_value(p, end)) {
+                            return false;
+                        }
+                        value.end = p;
+
+                        json_slice *member = nullptr;
+                        if (name.equals("jsonrpc")) {
+                            member = &jsonrpc;
+                        } else if (name.equals("id")) {
+                            member = &id;
+                        } else if (name.equals("method")) {
+                            member = &method;
+                        } else if (name.equals("params")) {
+                            member = &params;
+                        }
+
+                        if (member) {
+                            if (!member->empty()) {
+                                return false;
+                            }
+                            *member = value;
+                        }
+
+                        skip_spaces(p, end);
+                        if (p == end) {
+                            return false;
+                        } else if (*p == '}') {
+                            ++p;
+                            break;
+                        } else if (*p != ',') {
+                            return false;
+                        }
+                        ++p;
+                    }
+                }
+
+                skip_spaces(p, end);
+                return p == end;
+            }
+
+            bool split_json_array(const char *begin, const char *end, std::vector<json_slice> &items) {
+                items.clear();
+
+                auto p = begin;
+                skip_spaces(p, end);
+                if (p == end || *p != '[') {
+                    return false;
+                }
+                ++p;
+
+                skip_spaces(p, end);
+                if (p < end && *p == ']') {
+                    ++p;
+                } else {
+                    for (;;) {
+                        skip_spaces(p, end);
+
+                        json_slice item;
+                        item.begin = p;
+                        if (!skip_value(p, end)) {
+                            return false;
+                        }
+                        item.end = p;
+                        items.push_back(item);
+
+                        skip_spaces(p, end);
+                        if (p == end) {
+                            return false;
+                        } else if (*p == ']') {
+                            ++p;
+                            break;
+                        } else if (*p != ',') {
+                            return false;
+                        }
+                        ++p;
+                    }
+                }
+
+                skip_spaces(p, end);
+                return p == end;
+            }
+
+        }
+    }
+} // graphene::plugins::json_rpc
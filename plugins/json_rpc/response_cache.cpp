@@ -0,0 +1,126 @@
+#include <graphene/plugins/json_rpc/response_cache.hpp>
+
+#include <algorithm>
+
+namespace graphene {
+    namespace plugins {
+        namespace json_rpc {
+
+            void response_cache::configure(std::size_t max_bytes, uint32_t shards) {
+                _shards.clear();
+                _max_bytes = max_bytes;
+                if (max_bytes == 0) {
+                    return;
+                }
+
+                shards = std::max<uint32_t>(shards, 1);
+                _shard_max_bytes = max_bytes / shards;
+                for (uint32_t i = 0; i < shards; ++i) {
+                    _shards.emplace_back(new shard());
+                }
+            }
+
+            uint32_t response_cache::add_method(const std::string &name) {
+                _method_names.push_back(name);
+                _counters.emplace_back();
+                return static_cast<uint32_t>(_method_names.size() - 1);
+            }
+
+            std::size_t response_cache::size_of(const std::string &key, const value_type &value) {
+                // nodes of the map and the list are counted roughly
+                return key.size() + value->size() + 128;
+            }
+
+            response_cache::shard &response_cache::shard_of(const std::string &key) {
+                return *_shards[std::hash<std::string>()(key) % _shards.size()];
+            }
+
+            response_cache::value_type response_cache::find(uint32_t method, const std::string &key) {
+                if (!enabled()) {
+                    return value_type();
+                }
+
+                auto &s = shard_of(key);
+                {
+                    std::lock_guard<std::mutex> lock(s.mutex);
+                    auto itr = s.nodes.find(key);
+                    if (itr != s.nodes.end()) {
+                        s.lru.splice(s.lru.begin(), s.lru, itr->second.lru_position);
+                        ++_counters[method].hits;
+                        return itr->second.value;
+                    }
+                }
+
+                ++_counters[method].misses;
+                return value_type();
+            }
+
+            void response_cache::insert(uint32_t method, std::string key, value_type value) {
+                if (!enabled()) {
+                    return;
+                }
+
+                const auto size = size_of(key, value);
+                if (size > _shard_max_bytes) {
+                    ++_counters[method].uncacheable;
+                    return;
+                }
+
+                auto &s = shard_of(key);
+                std::lock_guard<std::mutex> lock(s.mutex);
+
+                auto result = s.nodes.emplace(std::move(key), node());
+                if (!result.second) {
+                    // other thread has already stored the same result
+                    return;
+                }
+
+                auto &n = result.first->second;
+                n.value = std::move(value);
+                n.method = method;
+                s.lru.push_front(&result.first->first);
+                n.lru_position = s.lru.begin();
+                s.bytes += size;
+                ++_counters[method].insertions;
+
+                while (s.bytes > _shard_max_bytes) {
+                    auto itr = s.nodes.find(*s.lru.back());
+                    s.bytes -= size_of(itr->first, itr->second.value);
+                    ++_counters[itr->second.method].evictions;
+                    s.lru.pop_back();
+                    s.nodes.erase(itr);
+                }
+            }
+
+            void response_cache::skip(uint32_t method) {
+                ++_counters[method].uncacheable;
+            }
+
+            response_cache_stats response_cache::stats() const {
+                response_cache_stats result;
+                result.max_bytes = _max_bytes;
+                result.shards = static_cast<uint32_t>(_shards.size());
+
+                for (const auto &s: _shards) {
+                    std::lock_guard<std::mutex> lock(s->mutex);
+                    result.bytes += s->bytes;
+                    result.entries += s->nodes.size();
+                }
+
+                for (std::size_t i = 0; i < _method_names.size(); ++i) {
+                    const auto &c = _counters[i];
+                    response_cache_method_stats stat;
+                    stat.method = _method_names[i];
+                    stat.hits = c.hits;
+                    stat.misses = c.misses;
+                    stat.uncacheable = c.uncacheable;
+                    stat.insertions = c.insertions;
+                    stat.evictions = c.evictions;
+                    result.methods.push_back(std::move(stat));
+                }
+                return result;
+            }
+
+        }
+    }
+} // graphene::plugins::json_rpc
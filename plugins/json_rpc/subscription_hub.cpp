@@ -0,0 +1,236 @@
+#include <graphene/plugins/json_rpc/subscription_hub.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/log/logger.hpp>
+
+#include <algorithm>
+
+namespace graphene {
+    namespace plugins {
+        namespace json_rpc {
+
+            bool subscription_filter::match(const subscription_event &event) const {
+                if (!types.empty() && !types.count(event.type)) {
+                    return false;
+                }
+                if (accounts.empty()) {
+                    return true;
+                }
+                for (const auto &account: event.accounts) {
+                    if (accounts.count(account)) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            void subscription_hub::configure(limits value) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _limits = value;
+            }
+
+            void subscription_hub::set_executor(executor_type executor) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _executor = std::move(executor);
+            }
+
+            subscription_hub::channel_type subscription_hub::add_channel(const std::string &name) {
+                std::unique_ptr<channel_state> channel(new channel_state());
+                channel->name = name;
+                _channels.push_back(std::move(channel));
+                return static_cast<channel_type>(_channels.size() - 1);
+            }
+
+            void subscription_hub::subscribe(
+                channel_type channel, std::shared_ptr<subscriber_connection> connection, std::string rpc_id,
+                subscription_filter filter
+            ) {
+                FC_ASSERT(channel < _channels.size(), "Unknown channel of subscriptions");
+                FC_ASSERT(connection, "Subscriptions require a websocket connection");
+
+                auto value = std::make_shared<subscription>();
+                value->connection = std::move(connection);
+                value->rpc_id = std::move(rpc_id);
+                value->filter = std::move(filter);
+
+                std::lock_guard<std::mutex> lock(_mutex);
+                auto &count = _connections[value->connection->id()];
+                FC_ASSERT(count < _limits.max_subscriptions_per_connection,
+                          "Connection can't have more than ${n} subscriptions", ("n", _limits.max_subscriptions_per_connection));
+                ++count;
+
+                auto &state = *_channels[channel];
+                state.subscriptions.push_back(std::move(value));
+                state.subscription_count.store(state.subscriptions.size(), std::memory_order_relaxed);
+            }
+
+            void subscription_hub::remove_connection(const void *connection_id) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (!_connections.erase(connection_id)) {
+                    return;
+                }
+
+                for (auto &channel: _channels) {
+                    auto &subscriptions = channel->subscriptions;
+                    subscriptions.erase(
+                        std::remove_if(subscriptions.begin(), subscriptions.end(), [&](const auto &s) {
+                            return s->connection->id() == connection_id;
+                        }),
+                        subscriptions.end());
+                    channel->subscription_count.store(subscriptions.size(), std::memory_order_relaxed);
+                }
+            }
+
+            void subscription_hub::publish(channel_type channel, event_producer producer) {
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    if (_events.size() >= _limits.max_pending_events) {
+                        ++_dropped_events;
+                        return;
+                    }
+
+                    pending_event event;
+                    event.channel = channel;
+                    event.producer = std::move(producer);
+                    _events.push_back(std::move(event));
+
+                    if (_is_dispatching) {
+                        return;
+                    }
+                    _is_dispatching = true;
+
+                    if (_executor) {
+                        _executor([this]() {
+                            dispatch();
+                        });
+                        return;
+                    }
+                }
+                dispatch();
+            }
+
+            void subscription_hub::dispatch() {
+                // only one thread dispatches events, so they are delivered in order of publishing
+                for (;;) {
+                    pending_event event;
+                    {
+                        std::lock_guard<std::mutex> lock(_mutex);
+                        if (_events.empty()) {
+                            _is_dispatching = false;
+                            return;
+                        }
+                        event = std::move(_events.front());
+                        _events.pop_front();
+                    }
+                    fan_out(event);
+                }
+            }
+
+            void subscription_hub::fan_out(pending_event &pending) {
+                std::vector<std::shared_ptr<const subscription>> subscriptions;
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    subscriptions = _channels[pending.channel]->subscriptions;
+                }
+                if (subscriptions.empty()) {
+                    return;
+                }
+
+                subscription_event event;
+                try {
+                    if (!pending.producer(event) || !event.payload) {
+                        return;
+                    }
+                } catch (const fc::exception &e) {
+                    wlog("Can't produce event of ${c}: ${e}", ("c", _channels[pending.channel]->name)("e", e.to_string()));
+                    return;
+                } catch (const std::exception &e) {
+                    wlog("Can't produce event of ${c}: ${e}", ("c", _channels[pending.channel]->name)("e", e.what()));
+                    return;
+                }
+                ++_published_events;
+
+                std::set<const void *> removed;
+                for (const auto &s: subscriptions) {
+                    const auto id = s->connection->id();
+                    if (removed.count(id) || !s->filter.match(event)) {
+                        continue;
+                    }
+                    if (!deliver(*s, event)) {
+                        removed.insert(id);
+                        remove_connection(id);
+                    }
+                }
+            }
+
+            bool subscription_hub::deliver(const subscription &s, const subscription_event &event) {
+                std::string message;
+                message.reserve(event.payload->size() + s.rpc_id.size() + 40);
+                message.append("{\"jsonrpc\":\"2.0\",\"result\":");
+                message.append(*event.payload);
+                message.append(",\"id\":");
+                message.append(s.rpc_id);
+                message.push_back('}');
+
+                auto &connection = *s.connection;
+                if (connection.buffered_amount() + message.size() > _limits.max_buffered_bytes) {
+                    ++_slow_consumer_disconnects;
+                    try {
+                        connection.close("Slow consumer: too many unsent messages of subscriptions");
+                    } catch (...) {
+                        // the connection is closed already
+                    }
+                    return false;
+                }
+
+                try {
+                    if (connection.send(message)) {
+                        ++_sent_messages;
+                        return true;
+                    }
+                } catch (...) {
+                    // the connection is closed
+                }
+                return false;
+            }
+
+            std::string subscription_hub::get_metrics() const {
+                std::string out;
+                uint32_t connections, pending;
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    connections = static_cast<uint32_t>(_connections.size());
+                    pending = static_cast<uint32_t>(_events.size());
+                }
+
+                out += "# HELP vizd_rpc_subscriptions Number of subscriptions by channel\n";
+                out += "# TYPE vizd_rpc_subscriptions gauge\n";
+                for (const auto &channel: _channels) {
+                    out += "vizd_rpc_subscriptions{channel=\"" + channel->name + "\"} " +
+                           std::to_string(channel->subscription_count.load(std::memory_order_relaxed)) + "\n";
+                }
+                out += "# HELP vizd_rpc_subscription_connections Number of connections with subscriptions\n";
+                out += "# TYPE vizd_rpc_subscription_connections gauge\n";
+                out += "vizd_rpc_subscription_connections " + std::to_string(connections) + "\n";
+                out += "# HELP vizd_rpc_subscription_pending_events Number of events waiting for the fan-out\n";
+                out += "# TYPE vizd_rpc_subscription_pending_events gauge\n";
+                out += "vizd_rpc_subscription_pending_events " + std::to_string(pending) + "\n";
+                out += "# HELP vizd_rpc_subscription_events_total Number of published events\n";
+                out += "# TYPE vizd_rpc_subscription_events_total counter\n";
+                out += "vizd_rpc_subscription_events_total " + std::to_string(_published_events.load()) + "\n";
+                out += "# HELP vizd_rpc_subscription_dropped_events_total Number of events dropped because of the full queue\n";
+                out += "# TYPE vizd_rpc_subscription_dropped_events_total counter\n";
+                out += "vizd_rpc_subscription_dropped_events_total " + std::to_string(_dropped_events.load()) + "\n";
+                out += "# HELP vizd_rpc_subscription_messages_total Number of messages sent to subscribers\n";
+                out += "# TYPE vizd_rpc_subscription_messages_total counter\n";
+                out += "vizd_rpc_subscription_messages_total " + std::to_string(_sent_messages.load()) + "\n";
+                out += "# HELP vizd_rpc_slow_consumer_disconnects_total Number of connections closed as slow consumers\n";
+                out += "# TYPE vizd_rpc_slow_consumer_disconnects_total counter\n";
+                out += "vizd_rpc_slow_consumer_disconnects_total " +
+                       std::to_string(_slow_consumer_disconnects.load()) + "\n";
+                return out;
+            }
+
+        }
+    }
+} // graphene::plugins::json_rpc
@@ -96,13 +96,14 @@ namespace mongo_db {
                 // Set applied block listener
                 auto &db = pimpl_->database();
 
-                db.applied_block.connect([&](const signed_block &b) {
+                db.applied_block.connect(db.timed_handler("mongo_db.applied_block", [&](const signed_block &b) {
                     pimpl_->on_block(b);
-                });
+                }));
 
-                db.post_apply_operation.connect([&](const operation_notification &o) {
-                    pimpl_->on_operation(o);
-                });
+                db.post_apply_operation.connect(db.timed_handler("mongo_db.post_apply_operation",
+                    [&](const operation_notification &o) {
+                        pimpl_->on_operation(o);
+                    }));
 
             } else {
                 ilog("Mongo plugin configured, but no mongodb-uri specified. Plugin disabled.");
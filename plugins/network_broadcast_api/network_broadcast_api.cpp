@@ -142,11 +142,13 @@ namespace graphene {
 
             void network_broadcast_api_plugin::plugin_initialize(const boost::program_options::variables_map &options) {
                 pimpl.reset(new impl);
-                JSON_RPC_REGISTER_API(NETWORK_BROADCAST_API_PLUGIN_NAME);
-                on_applied_block_connection = appbase::app().get_plugin<chain::plugin>().db().applied_block.connect(
-                    [&](const signed_block &b) {
+                // transactions of a batch can depend on each other
+                JSON_RPC_REGISTER_SERIAL_API(NETWORK_BROADCAST_API_PLUGIN_NAME);
+                auto &db = appbase::app().get_plugin<chain::plugin>().db();
+                on_applied_block_connection = db.applied_block.connect(
+                    db.timed_handler("network_broadcast_api.applied_block", [&](const signed_block &b) {
                         on_applied_block(b);
-                    }
+                    })
                 );
             }
 
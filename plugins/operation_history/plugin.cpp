@@ -183,9 +183,10 @@ namespace graphene { namespace plugins { namespace operation_history {
 
         pimpl = std::make_unique<plugin_impl>();
 
-        pimpl->database.pre_apply_operation.connect([&](graphene::chain::operation_notification& note){
-            pimpl->on_operation(note);
-        });
+        pimpl->database.pre_apply_operation.connect(pimpl->database.timed_handler(
+            "operation_history.pre_apply_operation", [&](graphene::chain::operation_notification& note){
+                pimpl->on_operation(note);
+            }));
 
         graphene::chain::add_plugin_index<operation_index>(pimpl->database);
 
@@ -226,6 +227,16 @@ namespace graphene { namespace plugins { namespace operation_history {
         }
         ilog("operation_history: start_block ${s}", ("s", pimpl->start_block));
         JSON_RPC_REGISTER_API(name());
+        JSON_RPC_REGISTER_BINARY_METHODS(name(), (get_ops_in_block)(get_transaction))
+
+        // operations of the irreversible block can't change
+        appbase::app().get_plugin<json_rpc::plugin>().set_cacheable_method(name(), "get_ops_in_block",
+            [this](const json_rpc::msg_pack &args) {
+                auto block_num = args.args->at(0).as<uint32_t>();
+                return pimpl->database.with_weak_read_lock([&]() {
+                    return block_num <= pimpl->database.last_non_undoable_block_num();
+                });
+            });
         ilog("operation_history plugin: plugin_initialize() end");
     }
 
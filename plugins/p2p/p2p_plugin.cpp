@@ -52,6 +52,8 @@ namespace graphene {
 
                     virtual bool handle_block(const block_message &, bool, std::vector<fc::uint160_t> &) override;
 
+                    virtual void prefetch_block(const block_message &) override;
+
                     virtual void handle_transaction(const trx_message &) override;
 
                     virtual void handle_message(const message &) override;
@@ -159,6 +161,12 @@ namespace graphene {
                     } FC_CAPTURE_AND_RETHROW((blk_msg)(sync_mode))
                 }
 
+                void p2p_plugin_impl::prefetch_block(const block_message &blk_msg) {
+                    chain.prefetch_signature_keys(blk_msg.block, (block_producer | force_validate)
+                                                                 ? database::skip_nothing
+                                                                 : database::skip_transaction_signatures);
+                }
+
                 void p2p_plugin_impl::handle_transaction(const trx_message &trx_msg) {
                     try {
                         chain.accept_transaction(trx_msg.trx);
@@ -61,6 +61,16 @@ plugin::~plugin() {
 void plugin::plugin_initialize(const boost::program_options::variables_map &options) {
     my.reset(new plugin_impl);
     JSON_RPC_REGISTER_API ( name() ) ;
+
+    // the irreversible block can't change
+    appbase::app().get_plugin<json_rpc::plugin>().set_cacheable_method(name(), "get_raw_block",
+        [this](const json_rpc::msg_pack &args) {
+            auto block_num = args.args->at(0).as<uint32_t>();
+            auto &db = my->database();
+            return db.with_weak_read_lock([&]() {
+                return block_num <= db.last_non_undoable_block_num();
+            });
+        });
 }
 
 void plugin::plugin_startup() {
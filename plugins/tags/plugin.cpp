@@ -10,6 +10,7 @@
 // These visitors creates additional tables, we don't really need them in LOW_MEM mode
 #include <graphene/plugins/tags/tag_visitor.hpp>
 #include <graphene/chain/operation_notification.hpp>
+#include <graphene/plugins/json_rpc/call_deadline.hpp>
 
 #define CHECK_ARG_SIZE(_S)                                 \
    FC_ASSERT(                                              \
@@ -31,6 +32,7 @@
 namespace graphene { namespace plugins { namespace tags {
 
     using graphene::api::discussion_helper;
+    using graphene::plugins::json_rpc::call_deadline;
 
     struct tags_plugin::impl final {
         impl(): database_(appbase::app().get_plugin<chain::plugin>().db()) {
@@ -210,9 +212,10 @@ namespace graphene { namespace plugins { namespace tags {
 // Disable index creation for tag visitor
 #ifndef IS_LOW_MEM
         auto& db = pimpl->database();
-        db.post_apply_operation.connect([&](const operation_notification& note) {
-            pimpl->on_operation(note);
-        });
+        db.post_apply_operation.connect(db.timed_handler("tags.post_apply_operation",
+            [&](const operation_notification& note) {
+                pimpl->on_operation(note);
+            }));
         add_plugin_index<tags::tag_index>(db);
         add_plugin_index<tags::tag_stats_index>(db);
         add_plugin_index<tags::author_tag_stats_index>(db);
@@ -226,6 +229,16 @@ namespace graphene { namespace plugins { namespace tags {
 
         JSON_RPC_REGISTER_API (name());
 
+        // discussions are selected by scans of tag indexes, they are executed apart from cheap calls
+        auto& json_rpc_plugin = appbase::app().get_plugin<json_rpc::plugin>();
+        for (const auto& method: {
+            "get_trending_tags", "get_discussions_by_trending", "get_discussions_by_created",
+            "get_discussions_by_active", "get_discussions_by_cashout", "get_discussions_by_payout",
+            "get_discussions_by_votes", "get_discussions_by_children", "get_discussions_by_hot",
+            "get_discussions_by_feed", "get_discussions_by_blog", "get_discussions_by_contents",
+            "get_discussions_by_author_before_date"}) {
+            json_rpc_plugin.set_expensive_method(name(), method);
+        }
     }
 
     void tags_plugin::remove_lifespan_content() {
@@ -390,6 +403,7 @@ namespace graphene { namespace plugins { namespace tags {
         for (; query.select_authors.end() != aitr && result.size() < query.limit; ++aitr) {
             auto itr = idx.lower_bound(*aitr);
             for (; itr != etr && itr->account == *aitr && result.size() < query.limit; ++itr) {
+                call_deadline::check();
                 if (id_set.count(itr->content)) {
                     continue;
                 }
@@ -441,6 +455,7 @@ namespace graphene { namespace plugins { namespace tags {
     ) const {
         auto& db = database();
         for (; itr != etr && !exit(*itr); ++itr) {
+            call_deadline::check();
             if (id_set.count(itr->content)) {
                 continue;
             }
@@ -660,6 +675,7 @@ namespace graphene { namespace plugins { namespace tags {
             result.reserve(query.limit);
 
             for (; itr != idx.end() && itr->author == *query.start_author && result.size() < query.limit; ++itr) {
+                call_deadline::check();
                 if (itr->parent_author.size() > 0) {
                     discussion p(db.get<content_object>(itr->root_content), db);
                     if (!query.is_good_tags(p) || !query.is_good_author(p.author)) {
@@ -918,6 +934,7 @@ namespace graphene { namespace plugins { namespace tags {
                 }
 
                 while (itr != didx.end() && itr->author == author && count < limit) {
+                    call_deadline::check();
                     if (itr->parent_author.size() == 0) {
                         result.push_back(pimpl->get_discussion(*itr, vote_limit));
                         ++count;
@@ -0,0 +1,170 @@
+#include <graphene/plugins/webserver/http_compression.hpp>
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <memory>
+
+namespace graphene {
+    namespace plugins {
+        namespace webserver {
+
+            namespace {
+                std::string trim(const std::string &value) {
+                    auto begin = value.find_first_not_of(" \t");
+                    if (begin == std::string::npos) {
+                        return std::string();
+                    }
+                    auto end = value.find_last_not_of(" \t");
+                    return value.substr(begin, end - begin + 1);
+                }
+
+                /// the deflate stream of the thread, it is created once per encoding and level
+                class deflate_stream final {
+                public:
+                    deflate_stream(content_encoding encoding, int level)
+                        : _encoding(encoding), _level(level) {
+                        // 15 bits of window, +16 adds the gzip header and trailer
+                        const int window_bits = encoding == content_encoding::gzip ? 15 + 16 : 15;
+                        _is_valid = deflateInit2(&_stream, level, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+                    }
+
+                    ~deflate_stream() {
+                        if (_is_valid) {
+                            deflateEnd(&_stream);
+                        }
+                    }
+
+                    deflate_stream(const deflate_stream &) = delete;
+
+                    deflate_stream &operator=(const deflate_stream &) = delete;
+
+                    bool matches(content_encoding encoding, int level) const {
+                        return _encoding == encoding && _level == level;
+                    }
+
+                    bool compress(const std::string &input, std::string &output) {
+                        if (!_is_valid || deflateReset(&_stream) != Z_OK) {
+                            return false;
+                        }
+
+                        output.resize(deflateBound(&_stream, input.size()));
+                        _stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+                        _stream.avail_in = static_cast<uInt>(input.size());
+                        _stream.next_out = reinterpret_cast<Bytef *>(&output[0]);
+                        _stream.avail_out = static_cast<uInt>(output.size());
+
+                        if (deflate(&_stream, Z_FINISH) != Z_STREAM_END) {
+                            return false;
+                        }
+                        output.resize(_stream.total_out);
+                        return true;
+                    }
+
+                private:
+                    z_stream _stream = z_stream();
+                    const content_encoding _encoding;
+                    const int _level;
+                    bool _is_valid = false;
+                };
+
+                deflate_stream &thread_stream(content_encoding encoding, int level) {
+                    static thread_local std::unique_ptr<deflate_stream> gzip_stream;
+                    static thread_local std::unique_ptr<deflate_stream> deflate_stream_;
+
+                    auto &stream = encoding == content_encoding::gzip ? gzip_stream : deflate_stream_;
+                    if (!stream || !stream->matches(encoding, level)) {
+                        stream.reset(new deflate_stream(encoding, level));
+                    }
+                    return *stream;
+                }
+            }
+
+            const char *to_string(content_encoding encoding) {
+                switch (encoding) {
+                    case content_encoding::gzip:
+                        return "gzip";
+                    case content_encoding::deflate:
+                        return "deflate";
+                    default:
+                        return "";
+                }
+            }
+
+            content_encoding negotiate_content_encoding(const std::string &accept_encoding) {
+                double gzip_q = -1;
+                double deflate_q = -1;
+                double any_q = -1;
+
+                std::size_t begin = 0;
+                while (begin <= accept_encoding.size()) {
+                    auto end = accept_encoding.find(',', begin);
+                    if (end == std::string::npos) {
+                        end = accept_encoding.size();
+                    }
+                    auto item = accept_encoding.substr(begin, end - begin);
+                    begin = end + 1;
+
+                    double q = 1;
+                    auto params = item.find(';');
+                    auto name = trim(item.substr(0, params));
+                    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) {
+                        return std::tolower(c);
+                    });
+                    if (params != std::string::npos) {
+                        auto param = trim(item.substr(params + 1));
+                        if (param.size() > 2 && (param[0] == 'q' || param[0] == 'Q') && param[1] == '=') {
+                            q = std::strtod(param.c_str() + 2, nullptr);
+                        }
+                    }
+
+                    if (name == "gzip" || name == "x-gzip") {
+                        gzip_q = q;
+                    } else if (name == "deflate") {
+                        deflate_q = q;
+                    } else if (name == "*") {
+                        any_q = q;
+                    }
+                }
+
+                if (gzip_q < 0) {
+                    gzip_q = any_q;
+                }
+                if (deflate_q < 0) {
+                    deflate_q = any_q;
+                }
+
+                if (gzip_q > 0 && gzip_q >= deflate_q) {
+                    return content_encoding::gzip;
+                }
+                if (deflate_q > 0) {
+                    return content_encoding::deflate;
+                }
+                return content_encoding::identity;
+            }
+
+            content_encoding compress_response(
+                std::string &body, const std::string &accept_encoding, const compression_options &options
+            ) {
+                if (options.level <= 0 || body.size() < options.min_size || accept_encoding.empty()) {
+                    return content_encoding::identity;
+                }
+
+                auto encoding = negotiate_content_encoding(accept_encoding);
+                if (encoding == content_encoding::identity) {
+                    return encoding;
+                }
+
+                std::string output;
+                if (!thread_stream(encoding, options.level).compress(body, output) || output.size() >= body.size()) {
+                    return content_encoding::identity;
+                }
+                body.swap(output);
+                return encoding;
+            }
+
+        }
+    }
+} // graphene::plugins::webserver
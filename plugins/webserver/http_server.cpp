@@ -0,0 +1,483 @@
+#include <graphene/plugins/webserver/http_server.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <deque>
+
+namespace graphene {
+    namespace plugins {
+        namespace webserver {
+
+            namespace asio = boost::asio;
+            using boost::asio::ip::tcp;
+
+            namespace {
+                const char *status_text(int status) {
+                    switch (status) {
+                        case 100: return "Continue";
+                        case 200: return "OK";
+                        case 400: return "Bad Request";
+                        case 404: return "Not Found";
+                        case 411: return "Length Required";
+                        case 413: return "Payload Too Large";
+                        case 431: return "Request Header Fields Too Large";
+                        case 500: return "Internal Server Error";
+                        case 503: return "Service Unavailable";
+                        case 505: return "HTTP Version Not Supported";
+                        default: return "Unknown";
+                    }
+                }
+
+                std::string trim(const std::string &value) {
+                    auto begin = value.find_first_not_of(" \t");
+                    if (begin == std::string::npos) {
+                        return std::string();
+                    }
+                    auto end = value.find_last_not_of(" \t");
+                    return value.substr(begin, end - begin + 1);
+                }
+
+                std::string lower(std::string value) {
+                    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) {
+                        return std::tolower(c);
+                    });
+                    return value;
+                }
+
+                bool has_token(const std::string &value, const char *token) {
+                    return lower(value).find(token) != std::string::npos;
+                }
+            }
+
+            std::string http_server::request::header(const std::string &name) const {
+                auto itr = headers.find(name);
+                return itr != headers.end() ? itr->second : std::string();
+            }
+
+            class http_server::connection final: public std::enable_shared_from_this<connection> {
+            public:
+                connection(asio::io_service &ios, const limits &limits, const handler_type &handler)
+                    : _limits(limits),
+                      _handler(handler),
+                      _socket(ios),
+                      _strand(ios),
+                      _timer(ios) {
+                }
+
+                tcp::socket &socket() {
+                    return _socket;
+                }
+
+                void start() {
+                    boost::system::error_code ec;
+                    auto endpoint = _socket.remote_endpoint(ec);
+                    if (!ec) {
+                        _remote_address = endpoint.address().to_string();
+                    }
+                    // responses are small and written at once, they shouldn't wait for ACK of the previous ones
+                    _socket.set_option(tcp::no_delay(true), ec);
+
+                    auto self = shared_from_this();
+                    _strand.dispatch([self]() {
+                        self->process();
+                    });
+                }
+
+            private:
+                /// the response of the request, responses are written in order of slots
+                struct slot {
+                    bool is_ready = false;
+                    bool is_http10 = false;
+                    bool is_keep_alive = true;
+                    std::string data;
+                };
+
+                void process() {
+                    parse();
+                    flush();
+                    read();
+                    if (_slots.empty() && !_is_writing) {
+                        if (_is_finished) {
+                            close();
+                        } else {
+                            start_timer();
+                        }
+                    }
+                }
+
+                void read() {
+                    if (_is_reading || _is_finished || _is_closed ||
+                        _slots.size() >= _limits.max_pipelined_requests
+                    ) {
+                        // reading is resumed when responses are written
+                        return;
+                    }
+
+                    _is_reading = true;
+                    auto self = shared_from_this();
+                    _socket.async_read_some(
+                        asio::buffer(_read_buffer),
+                        _strand.wrap([self](const boost::system::error_code &ec, std::size_t size) {
+                            self->on_read(ec, size);
+                        }));
+                }
+
+                void on_read(const boost::system::error_code &ec, std::size_t size) {
+                    _is_reading = false;
+                    if (_is_closed) {
+                        return;
+                    }
+                    if (ec) {
+                        // the client can half-close the connection after requests, they are still answered
+                        _is_finished = true;
+                        if (ec != asio::error::eof) {
+                            close();
+                            return;
+                        }
+                    } else {
+                        _input.append(_read_buffer, size);
+                    }
+                    process();
+                }
+
+                void parse() {
+                    while (!_is_finished && !_is_closed && _slots.size() < _limits.max_pipelined_requests) {
+                        if (!_is_header_parsed) {
+                            // empty lines before the request line are allowed
+                            std::size_t skip = 0;
+                            while (_input.compare(skip, 2, "\r\n") == 0) {
+                                skip += 2;
+                            }
+                            if (skip > 0) {
+                                _input.erase(0, skip);
+                                _scan_position = 0;
+                            }
+
+                            auto end = _input.find("\r\n\r\n", _scan_position);
+                            if (end == std::string::npos) {
+                                if (_input.size() > _limits.max_header_size) {
+                                    fail(431);
+                                } else {
+                                    _scan_position = _input.size() > 3 ? _input.size() - 3 : 0;
+                                }
+                                return;
+                            }
+                            _scan_position = 0;
+
+                            if (end > _limits.max_header_size) {
+                                fail(431);
+                                return;
+                            }
+                            if (!parse_header(end)) {
+                                return;
+                            }
+                            _input.erase(0, end + 4);
+                            _is_header_parsed = true;
+
+                            if (_is_continue_expected && _input.size() < _content_length) {
+                                add_ready_slot("HTTP/1.1 100 Continue\r\n\r\n");
+                            }
+                        }
+
+                        if (_input.size() < _content_length) {
+                            return;
+                        }
+                        _request.body.assign(_input, 0, _content_length);
+                        _input.erase(0, _content_length);
+                        _is_header_parsed = false;
+                        dispatch();
+                    }
+                }
+
+                bool parse_header(std::size_t end) {
+                    auto line_end = _input.find("\r\n");
+                    const auto line = _input.substr(0, line_end);
+                    const auto first_space = line.find(' ');
+                    const auto last_space = line.rfind(' ');
+                    if (first_space == std::string::npos || first_space == last_space) {
+                        fail(400);
+                        return false;
+                    }
+
+                    _request = request();
+                    _request.method = line.substr(0, first_space);
+                    _request.target = line.substr(first_space + 1, last_space - first_space - 1);
+                    const auto version = line.substr(last_space + 1);
+                    if (version == "HTTP/1.0") {
+                        _is_http10 = true;
+                    } else if (version == "HTTP/1.1") {
+                        _is_http10 = false;
+                    } else {
+                        fail(version.compare(0, 5, "HTTP/") == 0 ? 505 : 400);
+                        return false;
+                    }
+
+                    for (auto position = line_end + 2; position < end;) {
+                        auto next = std::min(_input.find("\r\n", position), end);
+                        const auto header = _input.substr(position, next - position);
+                        position = next + 2;
+
+                        const auto colon = header.find(':');
+                        if (colon == std::string::npos || colon == 0) {
+                            fail(400);
+                            return false;
+                        }
+                        const auto name = lower(trim(header.substr(0, colon)));
+                        const auto value = trim(header.substr(colon + 1));
+                        auto itr = _request.headers.find(name);
+                        if (itr == _request.headers.end()) {
+                            _request.headers.emplace(name, value);
+                        } else {
+                            itr->second += ", " + value;
+                        }
+                    }
+
+                    if (_request.headers.count("transfer-encoding")) {
+                        fail(411);
+                        return false;
+                    }
+
+                    _content_length = 0;
+                    const auto length = _request.header("content-length");
+                    if (!length.empty()) {
+                        if (length.size() > 18 || length.find_first_not_of("0123456789") != std::string::npos) {
+                            fail(400);
+                            return false;
+                        }
+                        _content_length = std::stoull(length);
+                        if (_content_length > _limits.max_body_size) {
+                            fail(413);
+                            return false;
+                        }
+                    }
+
+                    const auto connection = _request.header("connection");
+                    _is_keep_alive = _is_http10 ? has_token(connection, "keep-alive") : !has_token(connection, "close");
+                    _is_continue_expected = lower(_request.header("expect")) == "100-continue";
+                    return true;
+                }
+
+                void dispatch() {
+                    const auto slot_id = _first_slot_id + _slots.size();
+                    _slots.emplace_back();
+                    auto &s = _slots.back();
+                    s.is_http10 = _is_http10;
+                    s.is_keep_alive = _is_keep_alive;
+                    if (!_is_keep_alive) {
+                        _is_finished = true;
+                    }
+
+                    request r = std::move(_request);
+                    _request = request();
+                    r.remote_address = _remote_address;
+                    r.connection_id = this;
+
+                    auto self = shared_from_this();
+                    auto responder = [self, slot_id](response value) {
+                        auto shared = std::make_shared<response>(std::move(value));
+                        self->_strand.post([self, slot_id, shared]() {
+                            self->respond(slot_id, std::move(*shared));
+                        });
+                    };
+
+                    try {
+                        _handler(std::move(r), responder);
+                    } catch (...) {
+                        response error;
+                        error.status = 500;
+                        error.body = status_text(500);
+                        error.content_type = "text/plain";
+                        responder(std::move(error));
+                    }
+                }
+
+                void respond(uint64_t slot_id, response &&value) {
+                    if (_is_closed || slot_id < _first_slot_id || slot_id - _first_slot_id >= _slots.size()) {
+                        return;
+                    }
+
+                    auto &s = _slots[slot_id - _first_slot_id];
+                    if (s.is_ready) {
+                        return;
+                    }
+                    s.data = serialize(value, s.is_http10, s.is_keep_alive);
+                    s.is_ready = true;
+                    process();
+                }
+
+                static std::string serialize(const response &value, bool is_http10, bool is_keep_alive) {
+                    std::string result;
+                    result.reserve(value.body.size() + 256);
+                    result += "HTTP/1.1 ";
+                    result += std::to_string(value.status);
+                    result += ' ';
+                    result += status_text(value.status);
+                    result += "\r\n";
+                    if (!value.content_type.empty()) {
+                        result += "Content-Type: " + value.content_type + "\r\n";
+                    }
+                    if (!value.content_encoding.empty()) {
+                        result += "Content-Encoding: " + value.content_encoding + "\r\n";
+                        result += "Vary: Accept-Encoding\r\n";
+                    }
+                    result += "Content-Length: " + std::to_string(value.body.size()) + "\r\n";
+                    if (!is_keep_alive) {
+                        result += "Connection: close\r\n";
+                    } else if (is_http10) {
+                        result += "Connection: keep-alive\r\n";
+                    }
+                    result += "\r\n";
+                    result += value.body;
+                    return result;
+                }
+
+                void add_ready_slot(std::string data) {
+                    _slots.emplace_back();
+                    _slots.back().is_ready = true;
+                    _slots.back().data = std::move(data);
+                }
+
+                /// answers the invalid request and closes the connection
+                void fail(int status) {
+                    response error;
+                    error.status = status;
+                    error.body = status_text(status);
+                    error.content_type = "text/plain";
+                    add_ready_slot(serialize(error, false, false));
+                    _is_finished = true;
+                }
+
+                void flush() {
+                    while (!_slots.empty() && _slots.front().is_ready) {
+                        _output += _slots.front().data;
+                        _slots.pop_front();
+                        ++_first_slot_id;
+                    }
+                    write();
+                }
+
+                void write() {
+                    if (_is_writing || _is_closed || _output.empty()) {
+                        return;
+                    }
+
+                    _is_writing = true;
+                    _writing.swap(_output);
+                    _output.clear();
+
+                    auto self = shared_from_this();
+                    asio::async_write(
+                        _socket, asio::buffer(_writing),
+                        _strand.wrap([self](const boost::system::error_code &ec, std::size_t) {
+                            self->on_write(ec);
+                        }));
+                }
+
+                void on_write(const boost::system::error_code &ec) {
+                    _is_writing = false;
+                    if (ec) {
+                        close();
+                        return;
+                    }
+                    process();
+                }
+
+                void start_timer() {
+                    if (_is_closed) {
+                        return;
+                    }
+
+                    auto self = shared_from_this();
+                    _timer.expires_from_now(boost::posix_time::seconds(_limits.idle_timeout_seconds));
+                    _timer.async_wait(_strand.wrap([self](const boost::system::error_code &ec) {
+                        if (!ec && self->_slots.empty() && !self->_is_writing) {
+                            self->close();
+                        }
+                    }));
+                }
+
+                void close() {
+                    if (_is_closed) {
+                        return;
+                    }
+                    _is_closed = true;
+
+                    boost::system::error_code ec;
+                    _timer.cancel(ec);
+                    _socket.shutdown(tcp::socket::shutdown_both, ec);
+                    _socket.close(ec);
+                }
+
+                const limits _limits;
+                const handler_type &_handler;
+                tcp::socket _socket;
+                asio::io_service::strand _strand;
+                asio::deadline_timer _timer;
+                std::string _remote_address;
+
+                char _read_buffer[16 * 1024];
+                std::string _input;
+                /// the search of the end of headers continues from here
+                std::size_t _scan_position = 0;
+                bool _is_reading = false;
+
+                request _request;
+                bool _is_header_parsed = false;
+                uint64_t _content_length = 0;
+                bool _is_http10 = false;
+                bool _is_keep_alive = true;
+                bool _is_continue_expected = false;
+
+                /// unanswered requests, the first one has _first_slot_id
+                std::deque<slot> _slots;
+                uint64_t _first_slot_id = 0;
+
+                std::string _output;
+                std::string _writing;
+                bool _is_writing = false;
+
+                /// no more requests are read, the connection is closed after the last response
+                bool _is_finished = false;
+                bool _is_closed = false;
+            };
+
+            http_server::http_server(asio::io_service &ios, limits limits, handler_type handler)
+                : _ios(ios),
+                  _acceptor(ios),
+                  _limits(limits),
+                  _handler(std::move(handler)) {
+            }
+
+            http_server::~http_server() {
+                stop();
+            }
+
+            void http_server::listen(const tcp::endpoint &endpoint) {
+                _acceptor.open(endpoint.protocol());
+                _acceptor.set_option(tcp::acceptor::reuse_address(true));
+                _acceptor.bind(endpoint);
+                _acceptor.listen();
+                accept();
+            }
+
+            void http_server::stop() {
+                boost::system::error_code ec;
+                _acceptor.close(ec);
+            }
+
+            void http_server::accept() {
+                auto con = std::make_shared<connection>(_ios, _limits, _handler);
+                _acceptor.async_accept(con->socket(), [this, con](const boost::system::error_code &ec) {
+                    if (!_acceptor.is_open()) {
+                        return;
+                    }
+                    if (!ec) {
+                        con->start();
+                    }
+                    accept();
+                });
+            }
+
+        }
+    }
+} // graphene::plugins::webserver
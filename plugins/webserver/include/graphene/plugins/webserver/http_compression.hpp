@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace graphene {
+    namespace plugins {
+        namespace webserver {
+
+            enum class content_encoding {
+                identity,
+                gzip,
+                deflate
+            };
+
+            /// the value of Content-Encoding header, it is empty for identity
+            const char *to_string(content_encoding);
+
+            /// chooses the encoding from Accept-Encoding by q-values, gzip is preferred on equal q-values
+            content_encoding negotiate_content_encoding(const std::string &accept_encoding);
+
+            struct compression_options {
+                /// responses which are smaller aren't compressed, headers of compressed response don't pay off
+                uint32_t min_size = 1024;
+                /// level of zlib from 1 (fast) to 9 (small), 0 disables compression
+                int level = 6;
+            };
+
+            /**
+             * Compresses the body of the response in place by zlib, it is called on the worker thread.
+             * Streams of zlib are kept per thread and reset between responses, so their buffers
+             * aren't allocated for each response.
+             *
+             * @return the encoding of the body, identity if the body isn't compressed
+             */
+            content_encoding compress_response(
+                std::string &body, const std::string &accept_encoding, const compression_options &);
+
+        }
+    }
+} // graphene::plugins::webserver
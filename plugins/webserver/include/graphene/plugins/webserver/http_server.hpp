@@ -0,0 +1,86 @@
+#pragma once
+
+#include <boost/asio.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace graphene {
+    namespace plugins {
+        namespace webserver {
+
+            /**
+             * HTTP/1.1 server of the separate http endpoint.
+             *
+             * Connections are persistent: HTTP/1.1 keeps the connection unless the client sends
+             * "Connection: close", HTTP/1.0 keeps it only with "Connection: keep-alive".
+             * Requests of a connection can be pipelined, they are handled in parallel and their responses
+             * are written in order of requests. Reading of the connection is paused while it has
+             * max_pipelined_requests unanswered requests.
+             *
+             * Bodies are read by Content-Length, chunked requests are rejected with 411.
+             * All work of a connection is serialized by its strand, so the io_service can be run by any threads.
+             */
+            class http_server final {
+            public:
+                struct request {
+                    std::string method;
+                    std::string target;
+                    std::string body;
+                    /// names of headers are in lower case
+                    std::map<std::string, std::string> headers;
+                    std::string remote_address;
+                    /// the same for all requests of the connection while it is open
+                    const void *connection_id = nullptr;
+
+                    /// the value of the header, its name must be in lower case
+                    std::string header(const std::string &name) const;
+                };
+
+                struct response {
+                    int status = 200;
+                    std::string body;
+                    std::string content_type = "application/json";
+                    /// empty for identity
+                    std::string content_encoding;
+                };
+
+                /// sends the response of the request, it should be called once, from any thread
+                using responder_type = std::function<void(response)>;
+
+                using handler_type = std::function<void(request &&, responder_type)>;
+
+                struct limits {
+                    std::size_t max_header_size = 64 * 1024;
+                    std::size_t max_body_size = 64 * 1024 * 1024;
+                    uint32_t max_pipelined_requests = 16;
+                    /// the connection without requests in progress is closed after this time
+                    uint32_t idle_timeout_seconds = 60;
+                };
+
+                http_server(boost::asio::io_service &, limits, handler_type);
+
+                ~http_server();
+
+                void listen(const boost::asio::ip::tcp::endpoint &);
+
+                /// stops accepting of connections, open connections are closed by stopping of the io_service
+                void stop();
+
+            private:
+                class connection;
+
+                void accept();
+
+                boost::asio::io_service &_ios;
+                boost::asio::ip::tcp::acceptor _acceptor;
+                const limits _limits;
+                const handler_type _handler;
+            };
+
+        }
+    }
+} // graphene::plugins::webserver
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <graphene/plugins/json_rpc/metrics.hpp>
+
+#include <fc/time.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace graphene {
+    namespace plugins {
+        namespace webserver {
+
+            /**
+             * Admission control and fair queuing of requests in front of the thread pool.
+             *
+             * Requests are queued per client (the remote address), clients are served by deficit round robin:
+             * a client with weight N executes up to N requests per round, so one busy client can't starve others.
+             * Only max_concurrency requests are executed on the executor at once, the rest wait in the queues.
+             *
+             * A request is rejected at once if the total queue is full, or the connection or the client
+             * has too many requests which are queued or executed.
+             *
+             * The executed request holds its slot: it is counted in the limits of its client and connection
+             * until the last reference to the slot is released, so work which continues the request on other
+             * executors (calls of a batch, expensive calls) is limited too. The thread is released when the task returns.
+             */
+            class request_scheduler final {
+            public:
+                using task_type = std::function<void()>;
+                using executor_type = std::function<void(task_type)>;
+
+                struct limits {
+                    uint32_t max_queue_size = 10000;
+                    uint32_t max_in_flight_per_connection = 64;
+                    uint32_t max_in_flight_per_client = 256;
+                    uint32_t max_concurrency = 256;
+                };
+
+                enum class admission {
+                    accepted,
+                    queue_full,
+                    connection_limit,
+                    client_limit
+                };
+
+                /// the accounting of the request in the limits of its client and connection
+                class slot final {
+                public:
+                    slot(request_scheduler &, std::string client, const void *connection);
+
+                    ~slot();
+
+                    const std::string &client() const {
+                        return _client;
+                    }
+
+                    const void *connection() const {
+                        return _connection;
+                    }
+
+                private:
+                    request_scheduler &_scheduler;
+                    const std::string _client;
+                    const void *const _connection;
+                };
+
+                using slot_ptr = std::shared_ptr<slot>;
+
+                request_scheduler(limits, executor_type);
+
+                /// the weight of the client in the fair queuing, the default weight is 1
+                void set_client_weight(const std::string &client, uint32_t weight);
+
+                /// the task is executed later on the executor, the rejected task is dropped
+                admission submit(const std::string &client, const void *connection, task_type task);
+
+                /// the slot of the request executed by the current thread, it is empty outside of tasks of schedulers
+                static slot_ptr current_slot();
+
+                /// metrics in Prometheus text format
+                std::string get_metrics() const;
+
+                static const char *to_string(admission);
+
+            private:
+                struct queued_task {
+                    task_type task;
+                    const void *connection;
+                    fc::time_point enqueue_time;
+                };
+
+                struct client_state {
+                    std::deque<queued_task> queue;
+                    uint32_t in_flight = 0;
+                    uint32_t weight = 1;
+                    int64_t deficit = 0;
+                    bool is_active = false;
+                };
+
+                struct dispatched_task {
+                    task_type task;
+                    std::string client;
+                    const void *connection;
+                };
+
+                /// takes tasks from the queues while there are free execution slots
+                std::vector<dispatched_task> take_tasks_locked();
+
+                void execute(std::vector<dispatched_task> tasks);
+
+                /// the task has returned, its thread can execute the next one
+                void complete();
+
+                /// the last reference to the slot is released
+                void release(const std::string &client, const void *connection);
+
+                const limits _limits;
+                const executor_type _executor;
+
+                mutable std::mutex _mutex;
+                std::unordered_map<std::string, client_state> _clients;
+                std::unordered_map<const void *, uint32_t> _connections;
+                std::map<std::string, uint32_t> _weights;
+                /// clients with queued requests in order of round robin
+                std::list<std::string> _active_clients;
+                uint32_t _queue_size = 0;
+                uint32_t _running = 0;
+
+                std::atomic<uint64_t> _accepted{0};
+                std::atomic<uint64_t> _rejected_queue_full{0};
+                std::atomic<uint64_t> _rejected_connection_limit{0};
+                std::atomic<uint64_t> _rejected_client_limit{0};
+                /// time in the queue in microseconds
+                json_rpc::metrics_histogram _queue_wait;
+            };
+
+        }
+    }
+} // graphene::plugins::webserver
@@ -0,0 +1,233 @@
+#include <graphene/plugins/webserver/request_scheduler.hpp>
+
+#include <algorithm>
+
+namespace graphene {
+    namespace plugins {
+        namespace webserver {
+
+            request_scheduler::request_scheduler(limits l, executor_type executor)
+                : _limits(l),
+                  _executor(std::move(executor)),
+                  _queue_wait({100, 500, 1000, 5000, 10000, 50000, 100000, 500000, 1000000, 5000000}) {
+            }
+
+            void request_scheduler::set_client_weight(const std::string &client, uint32_t weight) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _weights[client] = std::max<uint32_t>(weight, 1);
+                auto itr = _clients.find(client);
+                if (itr != _clients.end()) {
+                    itr->second.weight = _weights[client];
+                }
+            }
+
+            request_scheduler::admission request_scheduler::submit(
+                const std::string &client, const void *connection, task_type task
+            ) {
+                std::vector<dispatched_task> tasks;
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+
+                    if (_queue_size >= _limits.max_queue_size) {
+                        ++_rejected_queue_full;
+                        return admission::queue_full;
+                    }
+
+                    // entries are added only for admitted requests, they are erased when their counters reach 0
+                    auto connection_itr = _connections.find(connection);
+                    if (connection_itr != _connections.end() &&
+                        connection_itr->second >= _limits.max_in_flight_per_connection
+                    ) {
+                        ++_rejected_connection_limit;
+                        return admission::connection_limit;
+                    }
+
+                    auto client_itr = _clients.find(client);
+                    if (client_itr != _clients.end() && client_itr->second.in_flight >= _limits.max_in_flight_per_client) {
+                        ++_rejected_client_limit;
+                        return admission::client_limit;
+                    }
+
+                    if (connection_itr == _connections.end()) {
+                        connection_itr = _connections.emplace(connection, 0).first;
+                    }
+                    if (client_itr == _clients.end()) {
+                        client_itr = _clients.emplace(client, client_state()).first;
+                        auto weight_itr = _weights.find(client);
+                        if (weight_itr != _weights.end()) {
+                            client_itr->second.weight = weight_itr->second;
+                        }
+                    }
+
+                    auto &state = client_itr->second;
+                    ++connection_itr->second;
+                    ++state.in_flight;
+                    ++_queue_size;
+                    ++_accepted;
+
+                    state.queue.push_back(queued_task{std::move(task), connection, fc::time_point::now()});
+                    if (!state.is_active) {
+                        state.is_active = true;
+                        _active_clients.push_back(client);
+                    }
+
+                    tasks = take_tasks_locked();
+                }
+
+                execute(std::move(tasks));
+                return admission::accepted;
+            }
+
+            std::vector<request_scheduler::dispatched_task> request_scheduler::take_tasks_locked() {
+                std::vector<dispatched_task> result;
+                const auto now = fc::time_point::now();
+
+                while (_running < _limits.max_concurrency && !_active_clients.empty()) {
+                    const auto &client = _active_clients.front();
+                    auto &state = _clients[client];
+
+                    if (state.deficit <= 0) {
+                        state.deficit += state.weight;
+                    }
+
+                    auto &queued = state.queue.front();
+                    _queue_wait.observe((now - queued.enqueue_time).count());
+                    result.push_back(dispatched_task{std::move(queued.task), client, queued.connection});
+                    state.queue.pop_front();
+                    --state.deficit;
+                    --_queue_size;
+                    ++_running;
+
+                    if (state.queue.empty()) {
+                        state.deficit = 0;
+                        state.is_active = false;
+                        _active_clients.pop_front();
+                    } else if (state.deficit <= 0) {
+                        // the client has used its quantum, it goes to the end of the round
+                        _active_clients.splice(_active_clients.end(), _active_clients, _active_clients.begin());
+                    }
+                }
+                return result;
+            }
+
+            namespace {
+                thread_local request_scheduler::slot_ptr current_task_slot;
+            }
+
+            request_scheduler::slot::slot(request_scheduler &scheduler, std::string client, const void *connection)
+                : _scheduler(scheduler),
+                  _client(std::move(client)),
+                  _connection(connection) {
+            }
+
+            request_scheduler::slot::~slot() {
+                _scheduler.release(_client, _connection);
+            }
+
+            request_scheduler::slot_ptr request_scheduler::current_slot() {
+                return current_task_slot;
+            }
+
+            void request_scheduler::execute(std::vector<dispatched_task> tasks) {
+                for (auto &t: tasks) {
+                    auto task = std::make_shared<dispatched_task>(std::move(t));
+                    _executor([this, task]() {
+                        struct completion final {
+                            completion(request_scheduler &scheduler, slot_ptr task_slot)
+                                : scheduler(scheduler),
+                                  previous_slot(std::move(current_task_slot)) {
+                                current_task_slot = std::move(task_slot);
+                            }
+
+                            ~completion() {
+                                // the slot is released here, unless the task has passed it to other executors
+                                current_task_slot = std::move(previous_slot);
+                                scheduler.complete();
+                            }
+
+                            request_scheduler &scheduler;
+                            slot_ptr previous_slot;
+                        } guard{*this, std::make_shared<slot>(*this, std::move(task->client), task->connection)};
+
+                        task->task();
+                    });
+                }
+            }
+
+            void request_scheduler::complete() {
+                std::vector<dispatched_task> tasks;
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    --_running;
+                    tasks = take_tasks_locked();
+                }
+                execute(std::move(tasks));
+            }
+
+            void request_scheduler::release(const std::string &client, const void *connection) {
+                std::lock_guard<std::mutex> lock(_mutex);
+
+                auto connection_itr = _connections.find(connection);
+                if (connection_itr != _connections.end() && --connection_itr->second == 0) {
+                    _connections.erase(connection_itr);
+                }
+
+                auto client_itr = _clients.find(client);
+                if (client_itr != _clients.end() && --client_itr->second.in_flight == 0) {
+                    _clients.erase(client_itr);
+                }
+            }
+
+            const char *request_scheduler::to_string(admission value) {
+                switch (value) {
+                    case admission::accepted:
+                        return "accepted";
+                    case admission::queue_full:
+                        return "queue is full";
+                    case admission::connection_limit:
+                        return "too many requests from the connection";
+                    case admission::client_limit:
+                        return "too many requests from the client";
+                }
+                return "unknown";
+            }
+
+            std::string request_scheduler::get_metrics() const {
+                uint32_t queue_size, running, clients;
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    queue_size = _queue_size;
+                    running = _running;
+                    clients = static_cast<uint32_t>(_clients.size());
+                }
+
+                std::string out;
+                out += "# HELP vizd_webserver_queue_depth Number of requests waiting in the queues\n";
+                out += "# TYPE vizd_webserver_queue_depth gauge\n";
+                out += "vizd_webserver_queue_depth " + std::to_string(queue_size) + "\n";
+                out += "# HELP vizd_webserver_running Number of requests which are executed now\n";
+                out += "# TYPE vizd_webserver_running gauge\n";
+                out += "vizd_webserver_running " + std::to_string(running) + "\n";
+                out += "# HELP vizd_webserver_clients Number of clients with queued or executed requests\n";
+                out += "# TYPE vizd_webserver_clients gauge\n";
+                out += "vizd_webserver_clients " + std::to_string(clients) + "\n";
+                out += "# HELP vizd_webserver_accepted_total Number of accepted requests\n";
+                out += "# TYPE vizd_webserver_accepted_total counter\n";
+                out += "vizd_webserver_accepted_total " + std::to_string(_accepted.load()) + "\n";
+                out += "# HELP vizd_webserver_rejected_total Number of rejected requests by reason\n";
+                out += "# TYPE vizd_webserver_rejected_total counter\n";
+                out += "vizd_webserver_rejected_total{reason=\"queue_full\"} " +
+                       std::to_string(_rejected_queue_full.load()) + "\n";
+                out += "vizd_webserver_rejected_total{reason=\"connection_limit\"} " +
+                       std::to_string(_rejected_connection_limit.load()) + "\n";
+                out += "vizd_webserver_rejected_total{reason=\"client_limit\"} " +
+                       std::to_string(_rejected_client_limit.load()) + "\n";
+                out += "# HELP vizd_webserver_queue_wait_seconds Time of waiting in the queue\n";
+                out += "# TYPE vizd_webserver_queue_wait_seconds histogram\n";
+                _queue_wait.write(out, "vizd_webserver_queue_wait_seconds", "", 1e6);
+                return out;
+            }
+
+        }
+    }
+} // graphene::plugins::webserver
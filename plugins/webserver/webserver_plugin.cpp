@@ -1,4 +1,7 @@
 #include <graphene/plugins/webserver/webserver_plugin.hpp>
+#include <graphene/plugins/webserver/request_scheduler.hpp>
+#include <graphene/plugins/webserver/http_server.hpp>
+#include <graphene/plugins/webserver/http_compression.hpp>
 
 #include <graphene/plugins/chain/plugin.hpp>
 
@@ -20,10 +23,14 @@
 #include <websocketpp/logger/stub.hpp>
 #include <websocketpp/logger/syslog.hpp>
 
+#include <atomic>
+#include <limits>
+#include <set>
 #include <thread>
 #include <memory>
 #include <iostream>
 #include <graphene/plugins/json_rpc/plugin.hpp>
+#include <graphene/plugins/json_rpc/request_parser.hpp>
 
 namespace graphene {
     namespace plugins {
@@ -76,13 +83,59 @@ namespace graphene {
 
             using websocket_server_type = websocketpp::server<asio_with_stub_log>;
 
+            /// messages of subscriptions are queued by websocketpp, its buffer is the send queue of the connection
+            class ws_subscriber_connection final: public plugins::json_rpc::subscriber_connection {
+            public:
+                explicit ws_subscriber_connection(websocket_server_type::connection_ptr con)
+                    : _con(std::move(con)) {
+                }
+
+                const void *id() const override {
+                    return _con.get();
+                }
+
+                bool send(const std::string &message) override {
+                    return !_con->send(message);
+                }
+
+                std::size_t buffered_amount() const override {
+                    return _con->get_buffered_amount();
+                }
+
+                void close(const std::string &reason) override {
+                    websocketpp::lib::error_code ec;
+                    _con->close(websocketpp::close::status::policy_violation, reason, ec);
+                }
+
+            private:
+                websocket_server_type::connection_ptr _con;
+            };
+
             struct webserver_plugin::webserver_plugin_impl final {
             public:
                 boost::thread_group& thread_pool = appbase::app().scheduler();
-                webserver_plugin_impl(thread_pool_size_t thread_pool_size) : thread_pool_work(this->thread_pool_ios) {
+                webserver_plugin_impl(
+                    thread_pool_size_t thread_pool_size,
+                    thread_pool_size_t expensive_pool_size,
+                    uint32_t expensive_max_queue_size,
+                    request_scheduler::limits limits,
+                    http_server::limits http_limits,
+                    compression_options compression
+                ) : http_limits(http_limits),
+                    thread_pool_work(this->thread_pool_ios),
+                    scheduler(limits, [this](request_scheduler::task_type task) {
+                        thread_pool_ios.post(std::move(task));
+                    }),
+                    expensive_pool_work(this->expensive_pool_ios),
+                    expensive_pool_size(expensive_pool_size),
+                    expensive_max_queue_size(expensive_max_queue_size),
+                    compression(compression) {
                     for (uint32_t i = 0; i < thread_pool_size; ++i) {
                         thread_pool.create_thread(boost::bind(&asio::io_service::run, &thread_pool_ios));
                     }
+                    for (uint32_t i = 0; i < expensive_pool_size; ++i) {
+                        thread_pool.create_thread(boost::bind(&asio::io_service::run, &expensive_pool_ios));
+                    }
                 }
 
                 void start_webserver();
@@ -91,12 +144,43 @@ namespace graphene {
 
                 void handle_ws_message(websocket_server_type *, connection_hdl, websocket_server_type::message_ptr);
 
+                void handle_ws_close(websocket_server_type *, connection_hdl);
+
                 void handle_http_message(websocket_server_type *, connection_hdl);
 
+                /**
+                 * Executes the request of HTTP connection, it is shared by the websocket endpoint
+                 * and the separate http endpoint. The reply is called once, from any thread.
+                 */
+                void process_http_request(
+                    const string &client, const void *connection_id, const string &resource, string body,
+                    const string &accept_encoding, std::function<void(http_server::response)> reply);
+
+                /**
+                 * The address of the client, requests of one client are limited and queued together.
+                 * For requests from a trusted proxy it is taken from X-Real-IP or X-Forwarded-For.
+                 */
+                string client_address(const string &remote_address, const string &forwarded_for, const string &real_ip) const;
+
+                string client_address(const websocket_server_type::connection_ptr &) const;
+
+                /**
+                 * Posts the call of the expensive method, returns false if the queue of expensive calls is full.
+                 * The call holds the slot of its request, so expensive calls of a client are limited
+                 * by webserver-max-in-flight-per-ip and webserver-max-in-flight-per-connection too.
+                 */
+                bool post_expensive_task(std::function<void()> task);
+
+                std::string expensive_pool_metrics() const;
+
+                /// the JSON-RPC error for the rejected request, it has the id of the request if it is simple
+                static string overloaded_response(const string &request, request_scheduler::admission);
+
                 shared_ptr<std::thread> http_thread;
                 asio::io_service http_ios;
                 optional<tcp::endpoint> http_endpoint;
-                websocket_server_type http_server;
+                const http_server::limits http_limits;
+                std::unique_ptr<http_server> http_listener;
 
                 shared_ptr<std::thread> ws_thread;
                 asio::io_service ws_ios;
@@ -104,9 +188,31 @@ namespace graphene {
                 websocket_server_type ws_server;
                 asio::io_service thread_pool_ios;
                 asio::io_service::work thread_pool_work;
+                request_scheduler scheduler;
+
+                /// calls of expensive methods, they don't occupy threads of cheap calls
+                asio::io_service expensive_pool_ios;
+                asio::io_service::work expensive_pool_work;
+                const thread_pool_size_t expensive_pool_size;
+                const uint32_t expensive_max_queue_size;
+                /// queued and executed expensive calls
+                std::atomic<uint32_t> expensive_queue_size{0};
+                std::atomic<uint64_t> expensive_rejected{0};
 
                 plugins::json_rpc::plugin *api;
                 boost::signals2::connection chain_sync_con;
+
+                /// the HTTP path of metrics in Prometheus format, empty if metrics are disabled
+                string metrics_path;
+
+                /// compression of HTTP responses, it is negotiated by Accept-Encoding of the request
+                const compression_options compression;
+
+                /// addresses of reverse proxies which pass the address of the client, it isn't changed after the start
+                std::set<string> trusted_proxies;
+
+                /// binary websocket messages are served as binary RPC calls, otherwise they are rejected
+                bool binary_rpc_enabled = false;
             };
 
             void webserver_plugin::webserver_plugin_impl::start_webserver() {
@@ -120,6 +226,7 @@ namespace graphene {
                             ws_server.set_reuse_addr(true);
 
                             ws_server.set_message_handler(boost::bind(&webserver_plugin_impl::handle_ws_message, this, &ws_server, _1, _2));
+                            ws_server.set_close_handler(boost::bind(&webserver_plugin_impl::handle_ws_close, this, &ws_server, _1));
 
                             if (http_endpoint && http_endpoint == ws_endpoint) {
                                 ws_server.set_http_handler(boost::bind(&webserver_plugin_impl::handle_http_message, this, &ws_server, _1));
@@ -142,18 +249,18 @@ namespace graphene {
                     http_thread = std::make_shared<std::thread>( [&]() {
                         ilog("start processing http thread");
                         try {
-                            http_server.clear_access_channels(websocketpp::log::alevel::all);
-                            http_server.clear_error_channels(websocketpp::log::elevel::all);
-                            http_server.init_asio(&http_ios);
-                            http_server.set_reuse_addr(true);
-
-                            http_server.set_http_handler([this](connection_hdl hdl) {
-                                this->handle_http_message(&this->http_server, hdl);
-                            });
+                            http_listener.reset(new http_server(http_ios, http_limits,
+                                [this](http_server::request &&request, http_server::responder_type reply) {
+                                    auto accept_encoding = request.header("accept-encoding");
+                                    auto client = client_address(
+                                        request.remote_address, request.header("x-forwarded-for"), request.header("x-real-ip"));
+                                    process_http_request(
+                                        client, request.connection_id, request.target,
+                                        std::move(request.body), accept_encoding, std::move(reply));
+                                }));
 
                             ilog("start listening for http requests");
-                            http_server.listen(*http_endpoint);
-                            http_server.start_accept();
+                            http_listener->listen(*http_endpoint);
 
                             http_ios.run();
                             ilog("http io service exit");
@@ -169,11 +276,8 @@ namespace graphene {
                     ws_server.stop_listening();
                 }
 
-                if (http_server.is_listening()) {
-                    http_server.stop_listening();
-                }
-
                 thread_pool_ios.stop();
+                expensive_pool_ios.stop();
                 thread_pool.join_all();
 
                 if (ws_thread) {
@@ -186,7 +290,110 @@ namespace graphene {
                     http_ios.stop();
                     http_thread->join();
                     http_thread.reset();
+                    http_listener.reset();
+                }
+            }
+
+            bool webserver_plugin::webserver_plugin_impl::post_expensive_task(std::function<void()> task) {
+                if (expensive_queue_size.fetch_add(1) >= expensive_max_queue_size) {
+                    --expensive_queue_size;
+                    ++expensive_rejected;
+                    return false;
+                }
+
+                // the call stays in the limits of its client and connection until it is executed,
+                // but the thread of cheap calls is released at once
+                auto slot = request_scheduler::current_slot();
+                expensive_pool_ios.post([this, task, slot]() {
+                    try {
+                        task();
+                    } catch (...) {
+                        // the call responds with its errors, the thread of the pool should survive
+                    }
+                    --expensive_queue_size;
+                });
+                return true;
+            }
+
+            std::string webserver_plugin::webserver_plugin_impl::expensive_pool_metrics() const {
+                std::string out;
+                out += "# HELP vizd_webserver_expensive_calls Number of queued and executed calls of expensive methods\n";
+                out += "# TYPE vizd_webserver_expensive_calls gauge\n";
+                out += "vizd_webserver_expensive_calls " + std::to_string(expensive_queue_size.load()) + "\n";
+                out += "# HELP vizd_webserver_expensive_rejected_total Number of calls of expensive methods rejected "
+                       "because the queue is full\n";
+                out += "# TYPE vizd_webserver_expensive_rejected_total counter\n";
+                out += "vizd_webserver_expensive_rejected_total " + std::to_string(expensive_rejected.load()) + "\n";
+                return out;
+            }
+
+            string webserver_plugin::webserver_plugin_impl::client_address(
+                const string &remote_address, const string &forwarded_for, const string &real_ip
+            ) const {
+                if (trusted_proxies.find(remote_address) == trusted_proxies.end()) {
+                    return remote_address;
+                }
+
+                auto trim = [](const string &value) {
+                    auto begin = value.find_first_not_of(" \t");
+                    if (begin == string::npos) {
+                        return string();
+                    }
+                    return value.substr(begin, value.find_last_not_of(" \t") - begin + 1);
+                };
+
+                auto address = trim(real_ip);
+                if (!address.empty()) {
+                    return address;
+                }
+
+                // the client is the last address which isn't added by trusted proxies
+                auto end = forwarded_for.size();
+                while (end != string::npos && end > 0) {
+                    auto begin = forwarded_for.rfind(',', end - 1);
+                    auto first = (begin == string::npos) ? 0 : begin + 1;
+                    address = trim(forwarded_for.substr(first, end - first));
+                    if (!address.empty() && trusted_proxies.find(address) == trusted_proxies.end()) {
+                        return address;
+                    }
+                    end = begin;
+                }
+                return remote_address;
+            }
+
+            string webserver_plugin::webserver_plugin_impl::client_address(
+                const websocket_server_type::connection_ptr &con
+            ) const {
+                boost::system::error_code ec;
+                auto endpoint = con->get_raw_socket().remote_endpoint(ec);
+                if (ec) {
+                    return con->get_remote_endpoint();
+                }
+                return client_address(
+                    endpoint.address().to_string(), con->get_request_header("X-Forwarded-For"),
+                    con->get_request_header("X-Real-IP"));
+            }
+
+            string webserver_plugin::webserver_plugin_impl::overloaded_response(
+                const string &request, request_scheduler::admission reason
+            ) {
+                // the request isn't parsed by fc, only the simple id is copied
+                string id = "null";
+                plugins::json_rpc::request_envelope envelope;
+                if (envelope.parse(request) && !envelope.id.empty()) {
+                    plugins::json_rpc::json_slice content;
+                    bool is_number = envelope.id.size() <= 20;
+                    for (auto c = envelope.id.begin; c != envelope.id.end && is_number; ++c) {
+                        is_number = (*c >= '0' && *c <= '9') || *c == '-';
+                    }
+                    if (is_number || envelope.id.get_simple_string(content)) {
+                        id = envelope.id.str();
+                    }
                 }
+
+                return string("{\"jsonrpc\":\"2.0\",\"error\":{\"code\":") +
+                       std::to_string(JSON_RPC_SERVER_OVERLOADED) + ",\"message\":\"Server is overloaded: " +
+                       request_scheduler::to_string(reason) + "\"},\"id\":" + id + "}";
             }
 
             void webserver_plugin::webserver_plugin_impl::handle_ws_message(
@@ -195,7 +402,13 @@ namespace graphene {
                 websocket_server_type::message_ptr msg
             ) {
                 auto con = server->get_con_from_hdl(hdl);
-                thread_pool_ios.post([con, msg, this]() {
+                if (msg->get_opcode() == websocketpp::frame::opcode::binary && !binary_rpc_enabled) {
+                    con->send(api->binary_error(msg->get_payload(), JSON_RPC_METHOD_NOT_FOUND, "Binary RPC is disabled"),
+                        websocketpp::frame::opcode::binary);
+                    return;
+                }
+
+                auto result = scheduler.submit(client_address(con), con.get(), [con, msg, this]() {
                     try {
                         if (msg->get_opcode() == websocketpp::frame::opcode::text) {
                             api->call(msg->get_payload(), [con](const std::string &data){
@@ -203,6 +416,13 @@ namespace graphene {
                                 if (ec) {
                                     throw websocketpp::exception(ec);
                                 }
+                            }, std::make_shared<ws_subscriber_connection>(con));
+                        } else if (msg->get_opcode() == websocketpp::frame::opcode::binary) {
+                            api->call_binary(msg->get_payload(), [con](const std::string &data){
+                                auto ec = con->send(data, websocketpp::frame::opcode::binary);
+                                if (ec) {
+                                    throw websocketpp::exception(ec);
+                                }
                             });
                         } else {
                             con->send("error: string payload expected");
@@ -211,38 +431,95 @@ namespace graphene {
                         con->send("error calling API " + e.to_string());
                     }
                 });
+
+                if (result != request_scheduler::admission::accepted) {
+                    if (msg->get_opcode() == websocketpp::frame::opcode::binary) {
+                        con->send(api->binary_error(msg->get_payload(), JSON_RPC_SERVER_OVERLOADED,
+                            string("Server is overloaded: ") + request_scheduler::to_string(result)),
+                            websocketpp::frame::opcode::binary);
+                    } else {
+                        con->send(overloaded_response(msg->get_payload(), result));
+                    }
+                }
+            }
+
+            void webserver_plugin::webserver_plugin_impl::handle_ws_close(websocket_server_type *server, connection_hdl hdl) {
+                auto con = server->get_con_from_hdl(hdl);
+                api->subscriptions().remove_connection(con.get());
             }
 
             void webserver_plugin::webserver_plugin_impl::handle_http_message(websocket_server_type *server, connection_hdl hdl) {
+                // the connection of websocketpp is closed after the response, keep-alive is served by the separate http endpoint
                 auto con = server->get_con_from_hdl(hdl);
                 con->defer_http_response();
 
-                thread_pool_ios.post([con, this]() {
-                    auto body = con->get_request_body();
+                process_http_request(
+                    client_address(con), con.get(), con->get_resource(), con->get_request_body(),
+                    con->get_request_header("Accept-Encoding"),
+                    [con](http_server::response response) {
+                        con->set_body(std::move(response.body));
+                        con->set_status(static_cast<websocketpp::http::status_code::value>(response.status));
+                        con->append_header("Content-Type", response.content_type);
+                        if (!response.content_encoding.empty()) {
+                            con->append_header("Content-Encoding", response.content_encoding);
+                            con->append_header("Vary", "Accept-Encoding");
+                        }
+                        try {
+                            con->send_http_response();
+                        } catch (...) {
+                            // the client has gone
+                        }
+                    });
+            }
+
+            void webserver_plugin::webserver_plugin_impl::process_http_request(
+                const string &client, const void *connection_id, const string &resource, string body,
+                const string &accept_encoding, std::function<void(http_server::response)> reply
+            ) {
+                // compression is done on the thread which produced the response, not on the io thread
+                auto compress_and_reply = [this, accept_encoding, reply](http_server::response &&response) {
+                    auto encoding = compress_response(response.body, accept_encoding, compression);
+                    response.content_encoding = to_string(encoding);
+                    reply(std::move(response));
+                };
+
+                if (!metrics_path.empty() && resource == metrics_path) {
+                    thread_pool_ios.post([this, compress_and_reply]() {
+                        http_server::response response;
+                        response.body = api->get_metrics() + scheduler.get_metrics() + expensive_pool_metrics();
+                        response.content_type = "text/plain; version=0.0.4";
+                        compress_and_reply(std::move(response));
+                    });
+                    return;
+                }
 
+                auto request = std::make_shared<string>(std::move(body));
+                auto result = scheduler.submit(client, connection_id, [this, request, reply, compress_and_reply]() {
                     try {
-                        api->call(body, [con](const std::string &data){
+                        api->call(*request, [compress_and_reply](std::string &&data) {
                             // this lambda can be called from any thread in application
                             //   for example, when task was delegated ( see msg_pack(msg_pack&&) )
-                            con->set_body(data);
-                            con->set_status(websocketpp::http::status_code::ok);
-                            con->send_http_response();
+                            http_server::response response;
+                            response.body = std::move(data);
+                            compress_and_reply(std::move(response));
                         });
                     } catch (fc::exception &e) {
                         // this case happens if exception was thrown on parsing request
                         edump((e));
-                        con->set_body("Could not call API");
-                        con->set_status(websocketpp::http::status_code::not_found);
-                        // this sending response can't be merged with sending response from try-block
-                        //   because try-block can work from other thread,
-                        //   when catch-block happens in current thread on parsing request
-                        try {
-                            con->send_http_response();
-                        } catch (...) {
-                            // disable segfault
-                        }
+                        http_server::response response;
+                        response.status = 404;
+                        response.body = "Could not call API";
+                        response.content_type = "text/plain";
+                        reply(std::move(response));
                     }
                 });
+
+                if (result != request_scheduler::admission::accepted) {
+                    http_server::response response;
+                    response.status = 503;
+                    response.body = overloaded_response(*request, result);
+                    reply(std::move(response));
+                }
             }
 
             webserver_plugin::webserver_plugin() {
@@ -260,14 +537,111 @@ namespace graphene {
                     ("rpc-endpoint", boost::program_options::value<string>(),
                         "Local http and websocket endpoint for webserver requests. Deprectaed in favor of webserver-http-endpoint and webserver-ws-endpoint")
                     ("webserver-thread-pool-size", boost::program_options::value<thread_pool_size_t>()->default_value(256),
-                        "Number of threads used to handle queries. Default: 256.");
+                        "Number of threads used to handle queries. Default: 256.")
+                    ("webserver-expensive-thread-pool-size", boost::program_options::value<thread_pool_size_t>()->default_value(16),
+                        "Number of threads used to handle calls of expensive methods (see json-rpc-expensive-methods), "
+                        "0 executes them on the main thread pool.")
+                    ("webserver-expensive-max-queue-size", boost::program_options::value<uint32_t>()->default_value(1000),
+                        "Maximum number of queued and executed calls of expensive methods, "
+                        "new calls are rejected when the queue is full. Queued calls are counted "
+                        "in the limits of their connection and IP address.")
+                    ("webserver-metrics-path", boost::program_options::value<string>(),
+                        "HTTP path (for example, /metrics) which serves metrics of API methods in Prometheus format. "
+                        "Metrics are collected only if the path is set.")
+                    ("webserver-max-queue-size", boost::program_options::value<uint32_t>()->default_value(10000),
+                        "Maximum number of requests waiting for a thread, new requests are rejected when the queue is full.")
+                    ("webserver-max-in-flight-per-connection", boost::program_options::value<uint32_t>()->default_value(64),
+                        "Maximum number of queued and executed requests of one connection, "
+                        "each call of a batch is counted as a request.")
+                    ("webserver-max-in-flight-per-ip", boost::program_options::value<uint32_t>()->default_value(256),
+                        "Maximum number of queued and executed requests of one IP address. Behind a reverse proxy "
+                        "all clients have the address of the proxy, unless it is listed in webserver-trusted-proxy.")
+                    ("webserver-client-weight", boost::program_options::value<std::vector<string>>()->composing()->multitoken(),
+                        "Share of threads for the IP address in format IP=weight, the default weight is 1. "
+                        "Can be specified multiple times.")
+                    ("webserver-trusted-proxy", boost::program_options::value<std::vector<string>>()->composing()->multitoken(),
+                        "IP address of a reverse proxy, the address of the client of its requests is taken from "
+                        "X-Real-IP or X-Forwarded-For headers. Can be specified multiple times.")
+                    ("webserver-enable-binary-rpc", boost::program_options::value<bool>()->default_value(false),
+                        "Serve binary websocket messages as binary RPC calls (see graphene::binary_rpc::client), "
+                        "binary messages are rejected if it is disabled.")
+                    ("webserver-http-idle-timeout", boost::program_options::value<uint32_t>()->default_value(60),
+                        "Seconds after which the idle keep-alive connection of the http endpoint is closed.")
+                    ("webserver-http-max-pipelined-requests", boost::program_options::value<uint32_t>()->default_value(16),
+                        "Maximum number of unanswered requests of one keep-alive connection, "
+                        "reading of the connection is paused when it is reached.")
+                    ("webserver-http-max-body-size", boost::program_options::value<uint32_t>()->default_value(64),
+                        "Maximum size of HTTP request body in megabytes.")
+                    ("webserver-compression-level", boost::program_options::value<int>()->default_value(6),
+                        "Level of gzip/deflate compression of HTTP responses from 1 (fast) to 9 (small), 0 disables compression.")
+                    ("webserver-compression-min-size", boost::program_options::value<uint32_t>()->default_value(1024),
+                        "Responses smaller than this size in bytes aren't compressed.");
             }
 
             void webserver_plugin::plugin_initialize(const boost::program_options::variables_map &options) {
                 auto thread_pool_size = options.at("webserver-thread-pool-size").as<thread_pool_size_t>();
                 FC_ASSERT(thread_pool_size > 0, "webserver-thread-pool-size must be greater than 0");
                 ilog("configured with ${tps} thread pool size", ("tps", thread_pool_size));
-                my.reset(new webserver_plugin_impl(thread_pool_size));
+
+                request_scheduler::limits limits;
+                limits.max_queue_size = options.at("webserver-max-queue-size").as<uint32_t>();
+                limits.max_in_flight_per_connection = options.at("webserver-max-in-flight-per-connection").as<uint32_t>();
+                limits.max_in_flight_per_client = options.at("webserver-max-in-flight-per-ip").as<uint32_t>();
+                limits.max_concurrency = thread_pool_size;
+                FC_ASSERT(limits.max_in_flight_per_connection > 0, "webserver-max-in-flight-per-connection must be greater than 0");
+                FC_ASSERT(limits.max_in_flight_per_client > 0, "webserver-max-in-flight-per-ip must be greater than 0");
+                ilog("configured with ${q} queue size, ${c} requests per connection and ${i} requests per IP",
+                     ("q", limits.max_queue_size)("c", limits.max_in_flight_per_connection)
+                     ("i", limits.max_in_flight_per_client));
+                auto expensive_pool_size = options.at("webserver-expensive-thread-pool-size").as<thread_pool_size_t>();
+                auto expensive_max_queue_size = options.at("webserver-expensive-max-queue-size").as<uint32_t>();
+                ilog("configured with ${tps} thread pool size for expensive methods", ("tps", expensive_pool_size));
+
+                http_server::limits http_limits;
+                http_limits.idle_timeout_seconds = options.at("webserver-http-idle-timeout").as<uint32_t>();
+                http_limits.max_pipelined_requests = options.at("webserver-http-max-pipelined-requests").as<uint32_t>();
+                http_limits.max_body_size = std::size_t(options.at("webserver-http-max-body-size").as<uint32_t>()) * 1024 * 1024;
+                FC_ASSERT(http_limits.idle_timeout_seconds > 0, "webserver-http-idle-timeout must be greater than 0");
+                FC_ASSERT(http_limits.max_pipelined_requests > 0, "webserver-http-max-pipelined-requests must be greater than 0");
+
+                compression_options compression;
+                compression.level = options.at("webserver-compression-level").as<int>();
+                compression.min_size = options.at("webserver-compression-min-size").as<uint32_t>();
+                FC_ASSERT(compression.level >= 0 && compression.level <= 9, "webserver-compression-level must be from 0 to 9");
+                ilog("configured with ${l} compression level of responses larger than ${s} bytes",
+                     ("l", compression.level)("s", compression.min_size));
+
+                my.reset(new webserver_plugin_impl(
+                    thread_pool_size, expensive_pool_size, expensive_max_queue_size, limits, http_limits, compression));
+
+                if (options.count("webserver-client-weight")) {
+                    for (const auto &item: options.at("webserver-client-weight").as<std::vector<string>>()) {
+                        auto pos = item.rfind('=');
+                        FC_ASSERT(pos != string::npos && pos > 0, "webserver-client-weight should be IP=weight: ${i}", ("i", item));
+                        auto weight_text = item.substr(pos + 1);
+                        std::size_t parsed = 0;
+                        unsigned long long weight = 0;
+                        try {
+                            weight = std::stoull(weight_text, &parsed);
+                        } catch (const std::exception &) {
+                            parsed = 0;
+                        }
+                        FC_ASSERT(parsed > 0 && parsed == weight_text.size() && weight > 0 &&
+                                  weight <= std::numeric_limits<uint32_t>::max(),
+                            "weight of client in webserver-client-weight should be a positive integer: ${i}", ("i", item));
+                        my->scheduler.set_client_weight(item.substr(0, pos), static_cast<uint32_t>(weight));
+                    }
+                }
+
+                if (options.count("webserver-trusted-proxy")) {
+                    for (const auto &item: options.at("webserver-trusted-proxy").as<std::vector<string>>()) {
+                        my->trusted_proxies.insert(item);
+                    }
+                    ilog("configured with ${n} trusted proxies", ("n", my->trusted_proxies.size()));
+                }
+
+                my->binary_rpc_enabled = options.at("webserver-enable-binary-rpc").as<bool>();
+                ilog("configured with ${e} binary RPC", ("e", my->binary_rpc_enabled ? "enabled" : "disabled"));
 
                 if (options.count("webserver-http-endpoint")) {
                     auto http_endpoint = options.at("webserver-http-endpoint").as<string>();
@@ -309,12 +683,48 @@ namespace graphene {
                         ilog("configured ws to listen on ${ep}", ("ep", ip_port));
                     }
                 }
+
+                if (options.count("webserver-metrics-path")) {
+                    my->metrics_path = options.at("webserver-metrics-path").as<string>();
+                    FC_ASSERT(!my->metrics_path.empty() && my->metrics_path[0] == '/',
+                              "webserver-metrics-path should start with /");
+
+                    // methods are resolved on startup of json_rpc, so metrics are enabled before it
+                    graphene::chain::database::set_read_lock_wait_measured(true);
+                    appbase::app().get_plugin<plugins::json_rpc::plugin>().enable_metrics([]() {
+                        return graphene::chain::database::read_lock_wait_micros();
+                    });
+                    ilog("metrics are served on ${p}", ("p", my->metrics_path));
+                }
             }
 
             void webserver_plugin::plugin_startup() {
                 my->api = appbase::app().find_plugin<plugins::json_rpc::plugin>();
                 FC_ASSERT(my->api != nullptr, "Could not find API Register Plugin");
 
+                // calls of batches are executed on the thread pool in parallel, they are queued and limited
+                // as requests of the client and the connection of the batch
+                my->api->set_batch_executor([this](std::function<void()> task) {
+                    auto slot = request_scheduler::current_slot();
+                    if (!slot) {
+                        my->thread_pool_ios.post(std::move(task));
+                        return true;
+                    }
+                    return my->scheduler.submit(slot->client(), slot->connection(), std::move(task)) ==
+                           request_scheduler::admission::accepted;
+                });
+
+                // events of subscriptions are serialized and sent on the thread pool, not on the write thread
+                my->api->subscriptions().set_executor([this](std::function<void()> task) {
+                    my->thread_pool_ios.post(std::move(task));
+                });
+
+                if (my->expensive_pool_size > 0) {
+                    my->api->set_expensive_executor([this](std::function<void()> task) {
+                        return my->post_expensive_task(std::move(task));
+                    });
+                }
+
                 chain::plugin *chain = appbase::app().find_plugin<chain::plugin>();
                 if (chain != nullptr && chain->get_state() != appbase::abstract_plugin::started) {
                     ilog("Waiting for chain plugin to start");
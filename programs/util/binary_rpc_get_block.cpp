@@ -0,0 +1,72 @@
+/**
+ * Fetches blocks from the node by binary RPC and checks that they survive the round trip through protocol types.
+ *
+ * Usage: binary_rpc_get_block <ws url> [first block] [count]
+ *
+ * The node should be started with webserver-enable-binary-rpc = true. Each block is requested by
+ * database_api.get_block, unpacked into signed_block, packed again and compared with the received bytes.
+ * Requests are pipelined, the last block is printed as JSON.
+ */
+
+#include <graphene/binary_rpc/client.hpp>
+#include <graphene/protocol/block.hpp>
+
+#include <fc/io/json.hpp>
+
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <vector>
+
+using graphene::binary_rpc::client;
+using graphene::binary_rpc::response;
+using graphene::protocol::signed_block;
+
+int main(int argc, char** argv) {
+    try {
+        if (argc < 2) {
+            std::cerr << "Usage: " << argv[0] << " <ws url> [first block] [count]" << std::endl;
+            return 1;
+        }
+
+        const uint32_t first = argc > 2 ? std::stoul(argv[2]) : 1;
+        const uint32_t count = argc > 3 ? std::stoul(argv[3]) : 1;
+        FC_ASSERT(first > 0 && count > 0, "The first block and the count should be greater than 0.");
+
+        client node(argv[1]);
+        FC_ASSERT(node.methods().count("database_api.get_block"),
+                  "The node doesn't serve database_api.get_block by binary RPC.");
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::future<response>> calls;
+        calls.reserve(count);
+        for (uint32_t num = first; num < first + count; ++num) {
+            calls.push_back(node.async_call("database_api", "get_block", {fc::variant(num)}));
+        }
+
+        uint64_t bytes = 0;
+        fc::optional<signed_block> block;
+        for (uint32_t i = 0; i < count; ++i) {
+            auto value = calls[i].get();
+            block = client::unpack<fc::optional<signed_block>>(value);
+            FC_ASSERT(block.valid(), "Block ${n} isn't found.", ("n", first + i));
+            FC_ASSERT(block->block_num() == first + i, "Block ${n} has number ${b}.",
+                      ("n", first + i)("b", block->block_num()));
+            FC_ASSERT(fc::raw::pack(block) == value.result, "Block ${n} is changed by unpack and pack.",
+                      ("n", first + i));
+            bytes += value.result.size();
+        }
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << fc::json::to_pretty_string(*block) << std::endl;
+        std::cout << count << " blocks, " << bytes << " bytes in " << elapsed.count() << " sec" << std::endl;
+    } catch (const fc::exception& e) {
+        std::cerr << e.to_detail_string() << std::endl;
+        return 1;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
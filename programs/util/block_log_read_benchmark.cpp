@@ -0,0 +1,139 @@
+/**
+ * Measures throughput of concurrent random reads from the block log.
+ *
+ * Usage: block_log_read_benchmark [block_log path] [seconds per run] [max threads]
+ *
+ * Without a path, a temporary log with synthetic blocks is created. Each run reads random blocks
+ * by number from N threads, N is doubled up to max threads. For the temporary log one more thread
+ * appends new blocks during the run, an existing log is only read.
+ */
+
+#include <graphene/chain/block_log.hpp>
+
+#include <fc/filesystem.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+using graphene::chain::block_log;
+using graphene::protocol::signed_block;
+
+static signed_block make_block(const signed_block& prev, uint32_t size) {
+    signed_block block;
+    block.previous = prev.id();
+    block.timestamp = prev.timestamp + 3;
+    block.witness = "benchmark";
+    block.transactions.resize(1);
+    auto& trx = block.transactions.back();
+    trx.ref_block_num = 1;
+    trx.signatures.resize(size / sizeof(graphene::protocol::signature_type) + 1);
+    return block;
+}
+
+int main(int argc, char** argv) {
+    try {
+        const double seconds = argc > 2 ? std::stod(argv[2]) : 5;
+        const uint32_t max_threads = argc > 3 ? std::stoul(argv[3]) : std::thread::hardware_concurrency();
+
+        fc::temp_directory temp_dir(".");
+        fc::path path;
+        if (argc > 1) {
+            path = argv[1];
+        } else {
+            path = temp_dir.path() / "block_log";
+        }
+
+        block_log log;
+        log.open(path);
+
+        if (argc <= 1) {
+            std::cout << "Creating block log with synthetic blocks..." << std::endl;
+            signed_block block;
+            block.timestamp = fc::time_point_sec(1);
+            for (uint32_t num = 1; num <= 100000; ++num) {
+                block = make_block(block, 1024);
+                if (num == 1) {
+                    // the number of the block is taken from the previous id
+                    block.previous = graphene::protocol::block_id_type();
+                }
+                log.append(block);
+            }
+        }
+
+        const uint32_t head_num = log.head_block_num();
+        FC_ASSERT(head_num > 0, "Block log is empty.");
+        std::cout << "Block log has " << head_num << " blocks" << std::endl;
+
+        for (uint32_t threads = 1; threads <= max_threads; threads *= 2) {
+            std::atomic<bool> is_stopped{false};
+            std::atomic<uint64_t> reads{0};
+            std::vector<std::thread> readers;
+            // exceptions can't leave threads, they are rethrown on the main thread after the run
+            std::vector<std::exception_ptr> errors(threads);
+
+            for (uint32_t i = 0; i < threads; ++i) {
+                readers.emplace_back([&, i]() {
+                    try {
+                        std::mt19937 rng(i);
+                        std::uniform_int_distribution<uint32_t> dist(1, head_num);
+                        uint64_t count = 0;
+                        while (!is_stopped.load(std::memory_order_relaxed)) {
+                            auto num = dist(rng);
+                            auto block = log.read_block_by_num(num);
+                            FC_ASSERT(block.valid(), "Block ${n} isn't read.", ("n", num));
+                            ++count;
+                        }
+                        reads += count;
+                    } catch (...) {
+                        errors[i] = std::current_exception();
+                        is_stopped = true;
+                    }
+                });
+            }
+
+            // the appender exercises publishing of states while the readers work
+            uint32_t appended = 0;
+            auto start = std::chrono::steady_clock::now();
+            auto deadline = start + std::chrono::duration<double>(seconds);
+            signed_block block = log.read_head();
+            while (std::chrono::steady_clock::now() < deadline) {
+                if (argc <= 1) {
+                    block = make_block(block, 1024);
+                    log.append(block);
+                    ++appended;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            is_stopped = true;
+            for (auto& t: readers) {
+                t.join();
+            }
+            for (auto& error: errors) {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            std::cout << threads << " threads: "
+                      << uint64_t(reads / elapsed.count()) << " reads/sec, "
+                      << appended << " blocks appended" << std::endl;
+        }
+
+        log.close();
+    } catch (const fc::exception& e) {
+        std::cerr << e.to_detail_string() << std::endl;
+        return 1;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,65 @@
+/**
+ * Offline maintenance of the block log: reconstruction of the index and verification of blocks.
+ *
+ * Usage: block_log_tool --block-log <path> [--rebuild-index] [--verify] [--threads N]
+ */
+
+#include <graphene/chain/block_log.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <iostream>
+#include <thread>
+
+namespace bpo = boost::program_options;
+
+int main(int argc, char** argv) {
+    try {
+        bpo::options_description options("Block log tool options");
+        options.add_options()
+            ("help,h", "print this help message")
+            ("block-log", bpo::value<std::string>(), "path to the block log file")
+            ("rebuild-index", bpo::bool_switch()->default_value(false), "remove the index and reconstruct it")
+            ("verify", bpo::bool_switch()->default_value(false),
+                "check numbers, links to previous blocks and merkle roots of all blocks")
+            ("threads", bpo::value<uint32_t>()->default_value(std::thread::hardware_concurrency()),
+                "number of threads for verification");
+
+        bpo::variables_map args;
+        bpo::store(bpo::parse_command_line(argc, argv, options), args);
+        bpo::notify(args);
+
+        if (args.count("help") || !args.count("block-log")) {
+            std::cout << options << std::endl;
+            return args.count("help") ? 0 : 1;
+        }
+
+        const fc::path path = args.at("block-log").as<std::string>();
+        FC_ASSERT(fc::exists(path), "Block log ${p} doesn't exist.", ("p", path.string()));
+
+        if (args.at("rebuild-index").as<bool>()) {
+            // opening of the block log reconstructs the missing index
+            fc::remove_all(fc::path(path.string() + ".index"));
+        }
+
+        graphene::chain::block_log log;
+        log.open(path);
+        std::cout << "Block log version " << log.version() << " has " << log.head_block_num() << " blocks" << std::endl;
+
+        if (args.at("verify").as<bool>()) {
+            auto start = fc::time_point::now();
+            log.verify(std::max<uint32_t>(args.at("threads").as<uint32_t>(), 1));
+            std::cout << "Block log is verified in " << (fc::time_point::now() - start).count() / 1000 << " ms" << std::endl;
+        }
+
+        log.close();
+    } catch (const fc::exception& e) {
+        std::cerr << e.to_detail_string() << std::endl;
+        return 1;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
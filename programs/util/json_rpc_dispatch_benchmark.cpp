@@ -0,0 +1,209 @@
+/**
+ * Measures the front-end of JSON-RPC requests on one core: parsing of the request,
+ * resolving of the method and parsing of its args, the methods aren't called.
+ *
+ * Usage: json_rpc_dispatch_benchmark [requests file] [seconds per run]
+ *
+ * The file contains recorded requests, one per line. Without the file, a synthetic mix of requests is used.
+ * The legacy front-end parses the whole request into fc::variant and finds the method in nested maps,
+ * the new one parses only the envelope and finds the method in the perfect hash table.
+ */
+
+#include <graphene/plugins/json_rpc/method_table.hpp>
+#include <graphene/plugins/json_rpc/request_parser.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/variant_object.hpp>
+
+#include <boost/algorithm/string.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace graphene::plugins::json_rpc;
+
+static std::vector<std::string> synthetic_requests() {
+    return {
+        R"({"jsonrpc":"2.0","id":1,"method":"call","params":["database_api","get_dynamic_global_properties",[]]})",
+        R"({"jsonrpc":"2.0","id":2,"method":"call","params":["database_api","get_block",[25000000]]})",
+        R"({"jsonrpc":"2.0","id":3,"method":"call","params":["database_api","get_accounts",[["alice","bob","carol"]]]})",
+        R"({"jsonrpc":"2.0","id":4,"method":"call","params":["operation_history","get_ops_in_block",[25000000,false]]})",
+        R"({"jsonrpc":"2.0","id":"5","method":"database_api.get_block_header","params":[25000000]})",
+        R"({"jsonrpc":"2.0","id":6,"method":"call","params":["account_history","get_account_history",["alice",-1,100]]})",
+        R"({"jsonrpc":"2.0","id":7,"method":"call","params":["network_broadcast_api","broadcast_transaction",[{"ref_block_num":1,"ref_block_prefix":2,"expiration":"2026-01-01T00:00:00","operations":[["transfer",{"from":"alice","to":"bob","amount":"1.000 VIZ","memo":"memo"}]],"extensions":[],"signatures":["1f2b"]}]]})",
+    };
+}
+
+static std::pair<std::string, std::string> method_of(const std::string& message) {
+    const auto request = fc::json::from_string(message).get_object();
+    auto method = request["method"].as_string();
+    if (method == "call") {
+        const auto& params = request["params"].get_array();
+        return {params.at(0).as_string(), params.at(1).as_string()};
+    }
+    std::vector<std::string> v;
+    boost::split(v, method, boost::is_any_of("."));
+    return {v.at(0), v.at(1)};
+}
+
+/// the front-end before the envelope parser
+struct legacy_front_end {
+    std::map<std::string, std::map<std::string, int>> apis;
+
+    std::size_t process(const std::string& message) const {
+        const auto data = fc::json::from_string(message);
+        const auto& request = data.get_object();
+        fc::variant id;
+        if (request.contains("id")) {
+            id = request["id"];
+        }
+        FC_ASSERT(request.contains("jsonrpc") && request["jsonrpc"].as_string() == "2.0");
+
+        std::string api, method = request["method"].as_string();
+        std::vector<fc::variant> args;
+        if (method == "call") {
+            auto v = request["params"].as<std::vector<fc::variant>>();
+            api = v[0].as_string();
+            method = v[1].as_string();
+            if (v.size() == 3) {
+                args = v[2].as<std::vector<fc::variant>>();
+            }
+        } else {
+            std::vector<std::string> v;
+            boost::split(v, method, boost::is_any_of("."));
+            api = v[0];
+            method = v[1];
+            if (request.contains("params")) {
+                args = request["params"].as<std::vector<fc::variant>>();
+            }
+        }
+
+        auto api_itr = apis.find(api);
+        FC_ASSERT(api_itr != apis.end());
+        auto method_itr = api_itr->second.find(method);
+        FC_ASSERT(method_itr != api_itr->second.end());
+        return method_itr->second + args.size();
+    }
+};
+
+/// the front-end of the json_rpc plugin
+struct envelope_front_end {
+    method_table<int> methods;
+
+    static std::string content(const json_slice& value) {
+        json_slice result;
+        return value.get_simple_string(result) ? result.str() : fc::json::from_string(value.str()).as_string();
+    }
+
+    std::size_t process(const std::string& message) const {
+        request_envelope request;
+        FC_ASSERT(request.parse(message));
+        fc::variant id;
+        if (!request.id.empty()) {
+            id = fc::json::from_string(request.id.str());
+        }
+        FC_ASSERT(request.jsonrpc.equals("\"2.0\""));
+
+        json_slice method;
+        FC_ASSERT(request.method.get_simple_string(method));
+
+        const int* entry = nullptr;
+        std::vector<fc::variant> args;
+        if (method.equals("call")) {
+            std::vector<json_slice> params;
+            FC_ASSERT(split_json_array(request.params.begin, request.params.end, params));
+            entry = methods.find(content(params[0]) + '.' + content(params[1]));
+            if (params.size() == 3) {
+                args = fc::json::from_string(params[2].str()).as<std::vector<fc::variant>>();
+            }
+        } else {
+            entry = methods.find(method.begin, method.size());
+            if (!request.params.empty()) {
+                args = fc::json::from_string(request.params.str()).as<std::vector<fc::variant>>();
+            }
+        }
+        FC_ASSERT(entry);
+        return *entry + args.size();
+    }
+};
+
+template<typename FrontEnd>
+static double requests_per_second(const FrontEnd& front_end, const std::vector<std::string>& requests, double seconds) {
+    uint64_t count = 0;
+    std::size_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::duration<double>(seconds);
+    while (std::chrono::steady_clock::now() < deadline) {
+        for (const auto& request: requests) {
+            checksum += front_end.process(request);
+        }
+        count += requests.size();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    FC_ASSERT(checksum != 0 || requests.empty());
+    return count / elapsed.count();
+}
+
+int main(int argc, char** argv) {
+    try {
+        const double seconds = argc > 2 ? std::stod(argv[2]) : 5;
+
+        std::vector<std::string> requests;
+        if (argc > 1) {
+            std::ifstream file(argv[1]);
+            FC_ASSERT(file, "Can't open ${f}", ("f", argv[1]));
+            for (std::string line; std::getline(file, line);) {
+                if (!line.empty()) {
+                    requests.push_back(line);
+                }
+            }
+        } else {
+            requests = synthetic_requests();
+        }
+        FC_ASSERT(!requests.empty(), "No requests");
+
+        // the node registers ~200 methods, the recorded ones are among them
+        std::set<std::pair<std::string, std::string>> names;
+        for (const auto& request: requests) {
+            names.insert(method_of(request));
+        }
+        for (int i = 0; names.size() < 200; ++i) {
+            names.emplace("api_" + std::to_string(i % 20), "method_" + std::to_string(i));
+        }
+
+        legacy_front_end legacy;
+        envelope_front_end envelope;
+        std::vector<method_table<int>::item_type> items;
+        int value = 1;
+        for (const auto& name: names) {
+            legacy.apis[name.first][name.second] = value;
+            items.emplace_back(name.first + '.' + name.second, value);
+            ++value;
+        }
+        envelope.methods.build(std::move(items));
+
+        for (const auto& request: requests) {
+            FC_ASSERT(legacy.process(request) == envelope.process(request), "Front-ends differ on ${r}", ("r", request));
+        }
+
+        std::cout << requests.size() << " requests, " << names.size() << " methods" << std::endl;
+        const auto before = requests_per_second(legacy, requests, seconds);
+        const auto after = requests_per_second(envelope, requests, seconds);
+        std::cout << "fc::variant and maps: " << uint64_t(before) << " requests/sec per core" << std::endl;
+        std::cout << "envelope and perfect hash: " << uint64_t(after) << " requests/sec per core" << std::endl;
+        std::cout << "Speedup: " << after / before << "x" << std::endl;
+    } catch (const fc::exception& e) {
+        std::cerr << e.to_detail_string() << std::endl;
+        return 1;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,100 @@
+/**
+ * Compares serialization of blocks to JSON via fc::variant and via json_writer.
+ *
+ * Usage: json_writer_benchmark [blocks] [transactions per block] [iterations]
+ *
+ * Blocks are synthetic, each transaction contains one transfer. Both outputs are compared
+ * before the measurement, the benchmark fails if they differ.
+ */
+
+#include <graphene/plugins/json_rpc/json_writer.hpp>
+#include <graphene/protocol/block.hpp>
+#include <graphene/protocol/config.hpp>
+#include <graphene/protocol/operations.hpp>
+
+#include <fc/io/json.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using graphene::plugins::json_rpc::json_writer;
+using graphene::protocol::asset;
+using graphene::protocol::signed_block;
+using graphene::protocol::signed_transaction;
+using graphene::protocol::transfer_operation;
+
+static signed_block make_block(uint32_t num, uint32_t transactions) {
+    signed_block block;
+    block.timestamp = fc::time_point_sec(num * 3);
+    block.witness = "benchmark";
+    block.transactions.resize(transactions);
+    for (uint32_t i = 0; i < transactions; ++i) {
+        auto& trx = block.transactions[i];
+        trx.ref_block_num = num & 0xffff;
+        trx.ref_block_prefix = num * 7 + i;
+        trx.expiration = block.timestamp + 60;
+
+        transfer_operation op;
+        op.from = "alice";
+        op.to = "bob";
+        op.amount = asset(num * 1000 + i, TOKEN_SYMBOL);
+        op.memo = "memo of transfer " + std::to_string(i);
+        trx.operations.push_back(op);
+        trx.signatures.resize(1);
+    }
+    return block;
+}
+
+template<typename Task>
+static double measure(uint32_t iterations, Task&& task) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; ++i) {
+        task();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+int main(int argc, char** argv) {
+    try {
+        const uint32_t block_count = argc > 1 ? std::stoul(argv[1]) : 100;
+        const uint32_t transactions = argc > 2 ? std::stoul(argv[2]) : 100;
+        const uint32_t iterations = argc > 3 ? std::stoul(argv[3]) : 20;
+
+        std::vector<signed_block> blocks;
+        for (uint32_t num = 1; num <= block_count; ++num) {
+            blocks.push_back(make_block(num, transactions));
+        }
+
+        const auto expected = fc::json::to_string(fc::variant(blocks));
+        json_writer writer;
+        writer.write(blocks);
+        FC_ASSERT(writer.str() == expected, "Output of json_writer differs from fc::json");
+        std::cout << "Output size: " << expected.size() << " bytes" << std::endl;
+
+        std::size_t size = 0;
+        const auto variant_time = measure(iterations, [&]() {
+            size += fc::json::to_string(fc::variant(blocks)).size();
+        });
+        const auto writer_time = measure(iterations, [&]() {
+            // the buffer is reused as the rpc layer does
+            writer.clear();
+            writer.write(blocks);
+            size += writer.str().size();
+        });
+
+        const double mb = double(expected.size()) * iterations / (1024 * 1024);
+        std::cout << "fc::variant: " << variant_time << " sec, " << mb / variant_time << " MB/sec" << std::endl;
+        std::cout << "json_writer: " << writer_time << " sec, " << mb / writer_time << " MB/sec" << std::endl;
+        std::cout << "Speedup: " << variant_time / writer_time << "x (" << size << " bytes written)" << std::endl;
+    } catch (const fc::exception& e) {
+        std::cerr << e.to_detail_string() << std::endl;
+        return 1;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,266 @@
+#pragma once
+
+/**
+ * Nodes over loopback which serve a synthetic chain, they are used by the sync benchmark and tests of the p2p code.
+ */
+
+#include <graphene/network/exceptions.hpp>
+#include <graphene/network/node.hpp>
+#include <graphene/protocol/block.hpp>
+#include <graphene/protocol/config.hpp>
+#include <graphene/protocol/operations.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/thread/thread.hpp>
+#include <fc/variant_object.hpp>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace p2p_loopback {
+
+using namespace graphene::network;
+using graphene::protocol::asset;
+using graphene::protocol::block_header;
+using graphene::protocol::block_id_type;
+using graphene::protocol::signed_block;
+using graphene::protocol::transfer_operation;
+
+inline std::vector<signed_block> make_chain(uint32_t block_count, uint32_t transactions) {
+    std::vector<signed_block> blocks;
+    blocks.reserve(block_count);
+    const fc::time_point_sec start = fc::time_point::now() - fc::seconds(3 * (block_count + 1));
+    block_id_type previous;
+    for (uint32_t num = 1; num <= block_count; ++num) {
+        signed_block block;
+        block.previous = previous;
+        block.timestamp = start + 3 * num;
+        block.witness = "benchmark";
+        block.transactions.resize(transactions);
+        for (uint32_t i = 0; i < transactions; ++i) {
+            auto& trx = block.transactions[i];
+            trx.ref_block_num = num & 0xffff;
+            trx.ref_block_prefix = num * 7 + i;
+            trx.expiration = block.timestamp + 60;
+
+            transfer_operation op;
+            op.from = "alice";
+            op.to = "bob";
+            op.amount = asset(num * 1000 + i, TOKEN_SYMBOL);
+            op.memo = "memo of transfer " + std::to_string(i);
+            trx.operations.push_back(op);
+            trx.signatures.resize(1);
+        }
+        previous = block.id();
+        blocks.push_back(std::move(block));
+    }
+    return blocks;
+}
+
+/**
+ * Linear chain without forks, all blocks are irreversible.
+ * It is used only from the thread of its node.
+ */
+class chain_delegate final: public node_delegate {
+public:
+    void push(const signed_block& block) {
+        const auto id = block.id();
+        _numbers[id] = block.block_num();
+        _blocks.push_back(block);
+        _head_block_num = _blocks.size();
+    }
+
+    uint32_t head_block_num() const {
+        return _head_block_num;
+    }
+
+    bool has_item(const item_id& id) override {
+        return id.item_type == block_message_type && is_known_block(id.item_hash);
+    }
+
+    bool handle_block(const block_message& blk_msg, bool sync_mode, std::vector<fc::uint160_t>&) override {
+        if (is_known_block(blk_msg.block_id)) {
+            return false;
+        }
+        if (blk_msg.block.previous != get_head_block_id()) {
+            FC_THROW_EXCEPTION(unlinkable_block_exception, "Block ${n} doesn't link to the head",
+                ("n", blk_msg.block.block_num()));
+        }
+        push(blk_msg.block);
+        return false;
+    }
+
+    void handle_transaction(const trx_message&) override {
+    }
+
+    void handle_message(const message&) override {
+        FC_THROW("Invalid Message Type");
+    }
+
+    std::vector<item_hash_t> get_block_ids(
+            const std::vector<item_hash_t>& blockchain_synopsis, uint32_t& remaining_item_count,
+            uint32_t limit) override {
+        std::vector<item_hash_t> result;
+        remaining_item_count = 0;
+        if (_blocks.empty()) {
+            return result;
+        }
+
+        uint32_t last_known_block_num = 0;
+        for (auto itr = blockchain_synopsis.rbegin(); itr != blockchain_synopsis.rend(); ++itr) {
+            if (*itr == item_hash_t() || is_known_block(*itr)) {
+                last_known_block_num = block_header::num_from_id(*itr);
+                break;
+            }
+            if (itr + 1 == blockchain_synopsis.rend()) {
+                FC_THROW_EXCEPTION(peer_is_on_an_unreachable_fork, "Unable to provide a list of blocks");
+            }
+        }
+
+        for (uint32_t num = last_known_block_num; num <= _blocks.size() && result.size() < limit; ++num) {
+            if (num > 0) {
+                result.push_back(_blocks[num - 1].id());
+            }
+        }
+        if (!result.empty() && block_header::num_from_id(result.back()) < _blocks.size()) {
+            remaining_item_count = _blocks.size() - block_header::num_from_id(result.back());
+        }
+        return result;
+    }
+
+    message get_item(const item_id& id) override {
+        FC_ASSERT(id.item_type == block_message_type && is_known_block(id.item_hash));
+        return block_message(_blocks[block_header::num_from_id(id.item_hash) - 1]);
+    }
+
+    std::vector<item_hash_t> get_blockchain_synopsis(
+            const item_hash_t& reference_point, uint32_t number_of_blocks_after_reference_point) override {
+        std::vector<item_hash_t> synopsis;
+        uint32_t high_block_num = _blocks.size();
+        if (reference_point != item_hash_t() && is_known_block(reference_point)) {
+            high_block_num = block_header::num_from_id(reference_point);
+        }
+        if (high_block_num == 0) {
+            return synopsis;
+        }
+
+        const uint32_t true_high_block_num = high_block_num + number_of_blocks_after_reference_point;
+        uint32_t low_block_num = 1;
+        do {
+            synopsis.push_back(_blocks[low_block_num - 1].id());
+            low_block_num += (true_high_block_num - low_block_num + 2) / 2;
+        } while (low_block_num <= high_block_num);
+        return synopsis;
+    }
+
+    void sync_status(uint32_t, uint32_t) override {
+    }
+
+    void connection_count_changed(uint32_t) override {
+    }
+
+    uint32_t get_block_number(const item_hash_t& block_id) override {
+        return block_header::num_from_id(block_id);
+    }
+
+    fc::time_point_sec get_block_time(const item_hash_t& block_id) override {
+        if (is_known_block(block_id)) {
+            return _blocks[block_header::num_from_id(block_id) - 1].timestamp;
+        }
+        return fc::time_point_sec::min();
+    }
+
+    fc::time_point_sec get_blockchain_now() override {
+        return fc::time_point::now();
+    }
+
+    item_hash_t get_head_block_id() const override {
+        return _blocks.empty() ? item_hash_t() : item_hash_t(_blocks.back().id());
+    }
+
+    uint32_t estimate_last_known_fork_from_git_revision_timestamp(uint32_t) const override {
+        return 0;
+    }
+
+    void error_encountered(const std::string& message, const fc::oexception&) override {
+        wlog("${m}", ("m", message));
+    }
+
+private:
+    bool is_known_block(const item_hash_t& id) const {
+        return _numbers.find(id) != _numbers.end();
+    }
+
+    std::vector<signed_block> _blocks;
+    std::unordered_map<block_id_type, uint32_t> _numbers;
+    std::atomic<uint32_t> _head_block_num{0};
+};
+
+/// the node with its own thread, as the p2p plugin runs it
+class loopback_node final {
+public:
+    explicit loopback_node(const std::string& name)
+            : _thread(name) {
+        _thread.async([this, name]() {
+            _node.reset(new node(name));
+            _node->load_configuration(_directory.path());
+            _node->set_node_delegate(&delegate);
+            _node->listen_on_endpoint(fc::ip::endpoint(fc::ip::address("127.0.0.1"), 0), false);
+        }).wait();
+    }
+
+    ~loopback_node() {
+        _thread.async([this]() {
+            _node->close();
+            _node.reset();
+        }).wait();
+        _thread.quit();
+    }
+
+    fc::ip::endpoint endpoint() const {
+        return _node->get_actual_listening_endpoint();
+    }
+
+    void start(const std::vector<fc::ip::endpoint>& seeds) {
+        _thread.async([this, seeds]() {
+            for (const auto& seed: seeds) {
+                _node->add_node(seed);
+                _node->connect_to_endpoint(seed);
+            }
+            _node->listen_to_p2p_network();
+            _node->connect_to_p2p_network();
+            _node->sync_from(item_id(block_message_type, delegate.get_head_block_id()), std::vector<uint32_t>());
+        }).wait();
+    }
+
+    /// the block is relayed as the produced one, so it stays in the message cache of the node
+    void broadcast(const signed_block& block) {
+        _thread.async([this, block]() {
+            _node->broadcast(block_message(block));
+        }).wait();
+    }
+
+    fc::variant_object network_info() {
+        return _thread.async([this]() {
+            return _node->network_get_info();
+        }).wait();
+    }
+
+    uint32_t connection_count() {
+        return _thread.async([this]() {
+            return _node->get_connection_count();
+        }).wait();
+    }
+
+    chain_delegate delegate;
+
+private:
+    fc::temp_directory _directory;
+    fc::thread _thread;
+    std::unique_ptr<node> _node;
+};
+
+} // p2p_loopback
@@ -0,0 +1,66 @@
+/**
+ * Measures synchronization of a node from peers over loopback.
+ *
+ * Usage: p2p_sync_benchmark [blocks] [peers] [transactions per block]
+ *
+ * The peers serve the same synthetic chain, the syncing node accepts blocks without validation,
+ * so the result is the throughput of the network code: fetching of blocks from several peers
+ * and handing them to the delegate in order of the chain.
+ */
+
+#include "p2p_loopback.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+using namespace p2p_loopback;
+
+int main(int argc, char** argv) {
+    try {
+        const uint32_t block_count = argc > 1 ? std::stoul(argv[1]) : 20000;
+        const uint32_t peer_count = argc > 2 ? std::stoul(argv[2]) : 4;
+        const uint32_t transactions = argc > 3 ? std::stoul(argv[3]) : 10;
+        FC_ASSERT(block_count > 0 && peer_count > 0);
+
+        const auto blocks = make_chain(block_count, transactions);
+
+        std::vector<std::unique_ptr<loopback_node>> peers;
+        std::vector<fc::ip::endpoint> seeds;
+        for (uint32_t i = 0; i < peer_count; ++i) {
+            peers.emplace_back(new loopback_node("peer-" + std::to_string(i)));
+            for (const auto& block: blocks) {
+                peers.back()->delegate.push(block);
+            }
+            peers.back()->start({});
+            seeds.push_back(peers.back()->endpoint());
+        }
+
+        loopback_node syncing("syncing");
+        const auto start = std::chrono::steady_clock::now();
+        syncing.start(seeds);
+
+        uint32_t reported = 0;
+        while (syncing.delegate.head_block_num() < block_count) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            FC_ASSERT(elapsed.count() < 600, "Sync stalled at block ${n}", ("n", syncing.delegate.head_block_num()));
+            if (elapsed.count() >= reported + 5) {
+                reported += 5;
+                std::cout << syncing.delegate.head_block_num() << " blocks after " << reported << " sec" << std::endl;
+            }
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::cout << block_count << " blocks from " << peer_count << " peers: " << elapsed.count() << " sec, "
+                  << uint64_t(block_count / elapsed.count()) << " blocks/sec" << std::endl;
+    } catch (const fc::exception& e) {
+        std::cerr << e.to_detail_string() << std::endl;
+        return 1;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,122 @@
+/**
+ * Checks that conversion of the block log to version 2 with a compression dictionary and back keeps all blocks.
+ *
+ * Usage: test_block_log_convert [blocks]
+ *
+ * The log of version 1 is converted to version 2 with zstd, a trained dictionary and a sparse index,
+ * then back to version 1. After each conversion blocks are read by number and by position
+ * and compared with the blocks read from the original log.
+ */
+
+#include <graphene/chain/block_log.hpp>
+
+#include <fc/filesystem.hpp>
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+using graphene::chain::block_log;
+using graphene::chain::block_log_compression;
+using graphene::chain::block_log_options;
+using graphene::protocol::signed_block;
+
+static std::vector<signed_block> make_blocks(uint32_t count) {
+    std::mt19937 rng(count);
+    std::vector<signed_block> blocks;
+    for (uint32_t num = 1; num <= count; ++num) {
+        signed_block block;
+        // the number of the block is taken from the previous id
+        if (num > 1) {
+            block.previous = blocks.back().id();
+        }
+        block.timestamp = fc::time_point_sec(3 * num);
+        block.witness = "witness" + std::to_string(num % 21);
+        block.transactions.resize(num % 4);
+        for (auto& trx: block.transactions) {
+            trx.ref_block_num = num & 0xffff;
+            trx.ref_block_prefix = rng();
+            trx.signatures.resize(num % 3 + 1);
+            // signatures are random, so the dictionary is trained on a realistic mix of repeated and unique data
+            for (auto& signature: trx.signatures) {
+                for (auto& byte: signature.data) {
+                    byte = static_cast<unsigned char>(rng());
+                }
+            }
+        }
+        blocks.push_back(block);
+    }
+    return blocks;
+}
+
+static std::vector<std::vector<char>> read_all(const fc::path& path, uint32_t expected_version) {
+    block_log log;
+    log.open(path);
+    FC_ASSERT(log.version() == expected_version, "Block log has version ${v} instead of ${e}.",
+              ("v", log.version())("e", expected_version));
+
+    std::vector<std::vector<char>> result;
+    for (uint32_t num = 1; num <= log.head_block_num(); ++num) {
+        auto block = log.read_block_by_num(num);
+        FC_ASSERT(block.valid(), "Block ${n} isn't read.", ("n", num));
+
+        auto by_pos = log.read_block(log.get_block_pos(num)).first;
+        FC_ASSERT(fc::raw::pack(by_pos) == fc::raw::pack(*block), "Block ${n} is read by position with other content.",
+                  ("n", num));
+        result.push_back(fc::raw::pack(*block));
+    }
+    log.close();
+    return result;
+}
+
+static void check_same(const std::vector<std::vector<char>>& read, const std::vector<std::vector<char>>& expected) {
+    FC_ASSERT(read.size() == expected.size(), "Block log has ${n} blocks instead of ${e}.",
+              ("n", read.size())("e", expected.size()));
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        FC_ASSERT(read[i] == expected[i], "Block ${n} is changed by the conversion.", ("n", i + 1));
+    }
+}
+
+int main(int argc, char** argv) {
+    try {
+        const uint32_t block_count = argc > 1 ? std::stoul(argv[1]) : 5000;
+        FC_ASSERT(block_count > 0);
+
+        fc::temp_directory temp_dir(".");
+        const auto path = temp_dir.path() / "block_log";
+
+        block_log_options v1_options;
+        v1_options.extent_size = 4096;
+        {
+            block_log log;
+            log.open(path, v1_options);
+            for (const auto& block: make_blocks(block_count)) {
+                log.append(block);
+            }
+            log.close();
+        }
+        const auto original = read_all(path, 1);
+
+        block_log_options v2_options;
+        v2_options.version = 2;
+        v2_options.compression = block_log_compression::zstd;
+        v2_options.index_step = 8;
+        v2_options.dictionary_size = 4096;
+        v2_options.extent_size = 4096;
+        block_log::convert(path, v2_options);
+        check_same(read_all(path, 2), original);
+
+        block_log::convert(path, v1_options);
+        check_same(read_all(path, 1), original);
+
+        std::cout << block_count << " blocks are the same after conversion to version 2 and back" << std::endl;
+    } catch (const fc::exception& e) {
+        std::cerr << e.to_detail_string() << std::endl;
+        return 1;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
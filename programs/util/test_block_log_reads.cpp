@@ -0,0 +1,208 @@
+/**
+ * Checks reading of the block log while blocks are appended, and the same content of logs of version 1 and 2.
+ *
+ * Usage: test_block_log_reads [blocks] [reader threads]
+ *
+ * Readers check random blocks and the head while the appender writes blocks with small extents,
+ * so the files are mapped again and replaced states are reclaimed during reads. Then the same blocks
+ * are written to logs of both versions, the logs are reopened and all blocks are compared.
+ */
+
+#include <graphene/chain/block_log.hpp>
+
+#include <fc/filesystem.hpp>
+
+#include <atomic>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+using graphene::chain::block_log;
+using graphene::chain::block_log_compression;
+using graphene::chain::block_log_options;
+using graphene::protocol::signed_block;
+
+static std::vector<signed_block> make_blocks(uint32_t count) {
+    std::vector<signed_block> blocks;
+    for (uint32_t num = 1; num <= count; ++num) {
+        signed_block block;
+        // the number of the block is taken from the previous id
+        if (num > 1) {
+            block.previous = blocks.back().id();
+        }
+        block.timestamp = fc::time_point_sec(3 * num);
+        block.witness = "test";
+        block.transactions.resize(num % 4);
+        for (auto& trx: block.transactions) {
+            trx.ref_block_num = num & 0xffff;
+            trx.ref_block_prefix = num;
+            trx.signatures.resize(num % 3 + 1);
+        }
+        blocks.push_back(block);
+    }
+    return blocks;
+}
+
+static void check_same(const signed_block& read, const signed_block& expected) {
+    FC_ASSERT(fc::raw::pack(read) == fc::raw::pack(expected), "Block ${n} is read with other content.",
+              ("n", expected.block_num()));
+}
+
+static void check_concurrent_reads(
+        const fc::path& path, const block_log_options& options, const std::vector<signed_block>& blocks, uint32_t threads) {
+    block_log log;
+    log.open(path, options);
+
+    std::atomic<uint32_t> appended{0};
+    std::atomic<bool> is_stopped{false};
+    std::atomic<uint64_t> reads{0};
+    // exceptions can't leave threads, they are rethrown on the main thread after the run
+    std::vector<std::exception_ptr> errors(threads);
+    std::vector<std::thread> readers;
+
+    for (uint32_t i = 0; i < threads; ++i) {
+        readers.emplace_back([&, i]() {
+            try {
+                std::mt19937 rng(i);
+                while (!is_stopped.load()) {
+                    const auto head_num = appended.load();
+                    if (!head_num) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+
+                    const auto num = std::uniform_int_distribution<uint32_t>(1, head_num)(rng);
+                    auto block = log.read_block_by_num(num);
+                    FC_ASSERT(block.valid(), "Block ${n} of ${h} isn't read.", ("n", num)("h", head_num));
+                    check_same(*block, blocks[num - 1]);
+
+                    // the head is published after the counter of the test is read, so it can only be newer
+                    const auto head = log.head();
+                    FC_ASSERT(head.valid() && head->block_num() >= head_num);
+                    check_same(*head, blocks[head->block_num() - 1]);
+                    ++reads;
+                }
+            } catch (...) {
+                errors[i] = std::current_exception();
+                is_stopped = true;
+            }
+        });
+    }
+
+    for (const auto& block: blocks) {
+        if (is_stopped.load()) {
+            break;
+        }
+        log.append(block);
+        appended = block.block_num();
+    }
+
+    is_stopped = true;
+    for (auto& reader: readers) {
+        reader.join();
+    }
+    for (auto& error: errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    FC_ASSERT(log.head_block_num() == blocks.size());
+    log.close();
+    std::cout << "Version " << options.version << ": " << reads.load() << " reads during "
+              << blocks.size() << " appends" << std::endl;
+}
+
+static void write_log(const fc::path& path, const block_log_options& options, const std::vector<signed_block>& blocks) {
+    block_log log;
+    log.open(path, options);
+    for (const auto& block: blocks) {
+        log.append(block);
+    }
+    log.close();
+}
+
+static void check_versions(const fc::path& dir, const std::vector<signed_block>& blocks) {
+    block_log_options v1_options;
+    v1_options.extent_size = 4096;
+
+    block_log_options v2_options;
+    v2_options.version = 2;
+    v2_options.compression = block_log_compression::zstd;
+    v2_options.index_step = 8;
+    v2_options.extent_size = 4096;
+
+    write_log(dir / "v1_block_log", v1_options, blocks);
+    write_log(dir / "v2_block_log", v2_options, blocks);
+
+    block_log v1;
+    block_log v2;
+    v1.open(dir / "v1_block_log", v1_options);
+    // options describe new logs, so the existing log of version 2 is opened with its own format
+    v2.open(dir / "v2_block_log", v1_options);
+    FC_ASSERT(v1.version() == 1 && v2.version() == 2 && v2.index_step() == v2_options.index_step);
+    FC_ASSERT(v1.head_block_num() == blocks.size() && v2.head_block_num() == blocks.size());
+
+    for (const auto& expected: blocks) {
+        const auto num = expected.block_num();
+        auto from_v1 = v1.read_block_by_num(num);
+        auto from_v2 = v2.read_block_by_num(num);
+        FC_ASSERT(from_v1.valid() && from_v2.valid(), "Block ${n} isn't read.", ("n", num));
+        check_same(*from_v1, expected);
+        check_same(*from_v2, expected);
+    }
+    check_same(v1.read_head(), blocks.back());
+    check_same(v2.read_head(), blocks.back());
+    FC_ASSERT(!v1.read_block_by_num(blocks.size() + 1).valid() && !v2.read_block_by_num(blocks.size() + 1).valid());
+
+    // blocks appended after reopening keep the format of the log
+    auto more_blocks = make_blocks(blocks.size() + 10);
+    for (auto num = blocks.size() + 1; num <= more_blocks.size(); ++num) {
+        v1.append(more_blocks[num - 1]);
+        v2.append(more_blocks[num - 1]);
+    }
+    v1.close();
+    v2.close();
+
+    v1.open(dir / "v1_block_log", v1_options);
+    v2.open(dir / "v2_block_log", v1_options);
+    for (const auto& expected: more_blocks) {
+        check_same(*v1.read_block_by_num(expected.block_num()), expected);
+        check_same(*v2.read_block_by_num(expected.block_num()), expected);
+    }
+    std::cout << "Versions 1 and 2 have the same " << more_blocks.size() << " blocks" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    try {
+        const uint32_t block_count = argc > 1 ? std::stoul(argv[1]) : 5000;
+        const uint32_t threads = argc > 2 ? std::stoul(argv[2]) : 4;
+        FC_ASSERT(block_count > 0 && threads > 0);
+
+        const auto blocks = make_blocks(block_count);
+        fc::temp_directory temp_dir(".");
+
+        block_log_options v1_options;
+        v1_options.extent_size = 4096;
+        check_concurrent_reads(temp_dir.path() / "concurrent_v1_block_log", v1_options, blocks, threads);
+
+        block_log_options v2_options;
+        v2_options.version = 2;
+        v2_options.compression = block_log_compression::zstd;
+        v2_options.index_step = 16;
+        v2_options.extent_size = 4096;
+        check_concurrent_reads(temp_dir.path() / "concurrent_v2_block_log", v2_options, blocks, threads);
+
+        check_versions(temp_dir.path(), blocks);
+    } catch (const fc::exception& e) {
+        std::cerr << e.to_detail_string() << std::endl;
+        return 1;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,64 @@
+/**
+ * Checks that a node syncs from a peer of the compact blocks protocol version which has recent blocks in its message cache.
+ *
+ * Usage: test_p2p_compact_sync [blocks] [cached blocks]
+ *
+ * The peer relays the last blocks of its chain, so they are in its message cache as after production.
+ * The syncing node fetches them during sync: it must receive full blocks, stay connected and reach the head.
+ */
+
+#include "p2p_loopback.hpp"
+
+#include <graphene/network/config.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+using namespace p2p_loopback;
+
+int main(int argc, char** argv) {
+    try {
+        const uint32_t block_count = argc > 1 ? std::stoul(argv[1]) : 2000;
+        const uint32_t cached_count = argc > 2 ? std::stoul(argv[2]) : 100;
+        FC_ASSERT(block_count > 0 && cached_count <= block_count);
+        static_assert(GRAPHENE_NET_PROTOCOL_VERSION >= GRAPHENE_NET_COMPACT_BLOCKS_PROTOCOL_VERSION,
+                      "the peer should support compact blocks");
+
+        const auto blocks = make_chain(block_count, 5);
+
+        loopback_node peer("peer");
+        for (const auto& block: blocks) {
+            peer.delegate.push(block);
+        }
+        peer.start({});
+        for (uint32_t num = block_count - cached_count + 1; num <= block_count; ++num) {
+            peer.broadcast(blocks[num - 1]);
+        }
+
+        loopback_node syncing("syncing");
+        const auto start = std::chrono::steady_clock::now();
+        syncing.start({peer.endpoint()});
+
+        while (syncing.delegate.head_block_num() < block_count) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            FC_ASSERT(elapsed.count() < 120, "Sync stalled at block ${n}", ("n", syncing.delegate.head_block_num()));
+        }
+
+        FC_ASSERT(syncing.connection_count() == 1, "The syncing node has disconnected from the peer.");
+        const auto compact_blocks_sent = peer.network_info()["compact_blocks_sent"].as_uint64();
+        FC_ASSERT(compact_blocks_sent == 0, "${n} blocks were sent as compact blocks during sync.",
+                  ("n", compact_blocks_sent));
+
+        std::cout << "Synced " << block_count << " blocks, " << cached_count << " of them from the message cache" << std::endl;
+    } catch (const fc::exception& e) {
+        std::cerr << e.to_detail_string() << std::endl;
+        return 1;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
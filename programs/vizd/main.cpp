@@ -17,6 +17,7 @@
 #include <graphene/plugins/auth_util/plugin.hpp>
 #include <graphene/plugins/debug_node/plugin.hpp>
 #include <graphene/plugins/raw_block/plugin.hpp>
+#include <graphene/plugins/block_timing_api/plugin.hpp>
 #include <graphene/plugins/block_info/plugin.hpp>
 #include <graphene/plugins/tags/plugin.hpp>
 #include <graphene/plugins/witness_api/plugin.hpp>
@@ -75,6 +76,7 @@ namespace graphene {
             appbase::app().register_plugin<graphene::plugins::private_message::private_message_plugin>();
             appbase::app().register_plugin<graphene::plugins::auth_util::plugin>();
             appbase::app().register_plugin<graphene::plugins::raw_block::plugin>();
+            appbase::app().register_plugin<graphene::plugins::block_timing_api::plugin>();
             appbase::app().register_plugin<graphene::plugins::block_info::plugin>();
             appbase::app().register_plugin<graphene::plugins::debug_node::plugin>();
             appbase::app().register_plugin<graphene::plugins::tags::tags_plugin>();